@@ -17,12 +17,18 @@ SOURCES += src/main.cpp \
 	src/client/clientstruct.cpp \
 	src/core/banpair.cpp \
 	src/core/card.cpp \
+	src/core/cardstring.cpp \
+	src/core/distancematrix.cpp \
 	src/core/engine.cpp \
 	src/core/general.cpp \
 	src/core/lua-wrapper.cpp \
+	src/core/luaprofiler.cpp \
 	src/core/player.cpp \
+	src/core/randomgenerator.cpp \
+	src/core/roomconfig.cpp \
 	src/core/settings.cpp \
 	src/core/skill.cpp \
+	src/core/symbol.cpp \
 	src/dialog/cardeditor.cpp \
 	src/dialog/cardoverview.cpp \
 	src/dialog/choosegeneraldialog.cpp \
@@ -65,14 +71,25 @@ SOURCES += src/main.cpp \
 	src/scenario/miniscenarios.cpp \
 	src/scenario/zombie-mode-scenario.cpp \
 	src/server/ai.cpp \
+	src/server/benchmark.cpp \
+	src/server/cardarena.cpp \
+	src/server/cardpile.cpp \
 	src/server/contestdb.cpp \
+	src/server/contestwriter.cpp \
+	src/server/deadlinewheel.cpp \
 	src/server/gamerule.cpp \
+	src/server/luastatepool.cpp \
+	src/server/roomscheduler.cpp \
 	src/server/room.cpp \
+	src/server/roomstate.cpp \
 	src/server/roomthread.cpp \
 	src/server/roomthread1v1.cpp \
 	src/server/roomthread3v3.cpp \
 	src/server/server.cpp \
 	src/server/serverplayer.cpp \
+	src/server/simulator.cpp \
+	src/ui/animationclock.cpp \
+	src/ui/assetloader.cpp \
 	src/ui/button.cpp \
 	src/ui/cardcontainer.cpp \
 	src/ui/carditem.cpp \
@@ -88,6 +105,7 @@ SOURCES += src/main.cpp \
 	src/ui/sprite.cpp \
 	src/ui/startscene.cpp \
 	src/ui/window.cpp \
+	src/util/binaryprotocol.cpp \
 	src/util/detector.cpp \
 	src/util/nativesocket.cpp \
 	src/util/recorder.cpp \
@@ -130,12 +148,18 @@ HEADERS += src/client/aux-skills.h \
 	src/core/audio.h \
 	src/core/banpair.h \
 	src/core/card.h \
+	src/core/cardstring.h \
+	src/core/distancematrix.h \
 	src/core/engine.h \
 	src/core/general.h \
 	src/core/lua-wrapper.h \
+	src/core/luaprofiler.h \
 	src/core/player.h \
+	src/core/randomgenerator.h \
+	src/core/roomconfig.h \
 	src/core/settings.h \
 	src/core/skill.h \
+	src/core/symbol.h \
 	src/dialog/cardeditor.h \
 	src/dialog/cardoverview.h \
 	src/dialog/choosegeneraldialog.h \
@@ -178,15 +202,26 @@ HEADERS += src/client/aux-skills.h \
 	src/scenario/scenerule.h \
 	src/scenario/zombie-mode-scenario.h \
 	src/server/ai.h \
+	src/server/benchmark.h \
+	src/server/cardarena.h \
+	src/server/cardpile.h \
 	src/server/contestdb.h \
+	src/server/contestwriter.h \
+	src/server/deadlinewheel.h \
 	src/server/gamerule.h \
+	src/server/luastatepool.h \
+	src/server/roomscheduler.h \
 	src/server/room.h \
+	src/server/roomstate.h \
 	src/server/roomthread.h \
 	src/server/roomthread1v1.h \
 	src/server/roomthread3v3.h \
 	src/server/server.h \
 	src/server/serverplayer.h \
+	src/server/simulator.h \
 	src/server/structs.h \
+	src/ui/animationclock.h \
+	src/ui/assetloader.h \
 	src/ui/button.h \
 	src/ui/cardcontainer.h \
 	src/ui/carditem.h \
@@ -202,6 +237,7 @@ HEADERS += src/client/aux-skills.h \
 	src/ui/sprite.h \
 	src/ui/startscene.h \
 	src/ui/window.h \
+	src/util/binaryprotocol.h \
 	src/util/detector.h \
 	src/util/nativesocket.h \
 	src/util/recorder.h \
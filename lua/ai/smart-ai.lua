@@ -16,7 +16,34 @@ version = "QSanguosha AI 20120128"
 -- @param player The ServerPlayer object that want to create the AI object
 -- @return The AI object
 function CloneAI(player)
-	return SmartAI(player).lua_ai
+	local ai = SmartAI(player)
+	-- the new AI of a player takes the place of the old one, as Room::resetAI does
+	for i, receiver in ipairs(sgs.ai_receivers) do
+		if receiver.player:objectName() == player:objectName() then
+			sgs.ai_receivers[i] = ai
+			return ai.lua_ai
+		end
+	end
+	table.insert(sgs.ai_receivers, ai)
+	return ai.lua_ai
+end
+
+-- the AIs of the room in the order they were cloned, which is the order of Room::ais
+sgs.ai_receivers = {}
+
+--- the host program delivers every event here once, instead of calling each AI
+function FilterEvents(event, player, data)
+	for _, ai in ipairs(sgs.ai_receivers) do
+		local success, error_msg = pcall(ai.filterEvent, ai, event, player, data)
+		if not success then
+			ai.room:writeToConsole(error_msg)
+			ai.room:writeToConsole("filterEvent")
+			ai.room:writeToConsole(debug.traceback())
+			ai.room:writeToConsole("Event stack:")
+			ai.room:outputEventStack()
+			ai.room:writeToConsole("End of Event Stack")
+		end
+	end
 end
 
 function SmartAI:initialize(player)
@@ -972,6 +999,38 @@ function SmartAI:sortEnemies(players)
 	table.sort(players,comp_func)
 end
 
+-- the copy that sgs.QList2Table made before it became native, kept for the benchmark below
+local function copyList(qlist)
+	local t = {}
+	for i=0, qlist:length()-1 do
+		table.insert(t, qlist:at(i))
+	end
+
+	return t
+end
+
+-- times rounds copies of the card lists with both copies, run by -benchmark:lists outside of any game
+function sgs.benchmarkLists(rounds)
+	local ids = sgs.Sanguosha:getRandomCards()
+	local cards = sgs.CardList()
+	for i=0, ids:length()-1 do
+		cards:append(sgs.Sanguosha:getCard(ids:at(i)))
+	end
+
+	local function measure(copy)
+		local start = os.clock()
+		for i=1, rounds do
+			copy(ids)
+			copy(cards)
+		end
+		return (os.clock() - start) * 1000
+	end
+
+	local copied = measure(copyList)
+	local viewed = measure(sgs.QList2Table)
+	return ("%d cards x %d: %.1f ms copied by at(), %.1f ms copied natively"):format(cards:length(), rounds, copied, viewed)
+end
+
 function SmartAI:updatePlayers(inclusive)
 	self.friends = sgs.QList2Table(self.lua_ai:getFriends())
 	table.insert(self.friends, self.player)
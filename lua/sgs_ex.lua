@@ -147,23 +147,39 @@ function sgs.LoadTranslationTable(t)
 end
 
 -- utilities, i.e: convert QList<const Card> to Lua's native table
-function sgs.QList2Table(qlist)
-	local t = {}
-	for i=0, qlist:length()-1 do
-		table.insert(t, qlist:at(i))
-	end
-
-	return t
-end
+-- sgs.QList2Table is native, see swig/list.i, it copies a list or a view in one pass
 
--- the iterator of QList object
+-- the iterator of QList object, for the lists that have no view
 local qlist_iterator = function(list, n)
 	if n < list:length()-1 then
 		return n+1, list:at(n+1) -- the next element of list
 	end
 end
 
+-- Lua 5.1 has no __ipairs, so ipairs learns the views and the lists here
+local raw_ipairs = ipairs
+function ipairs(t)
+	if type(t) == "userdata" then
+		return sgs.ListNext, sgs.ListView(t) or t, 0
+	end
+
+	return raw_ipairs(t)
+end
+
+-- the indices of the views are 0-based here as well, like at()
+local view_iterator = function(view, n)
+	local i, elem = sgs.ListNext(view, n+1)
+	if i then
+		return n+1, elem
+	end
+end
+
 function sgs.qlist(list)
+	local view = sgs.ListView(list)
+	if view then
+		return view_iterator, view, -1
+	end
+
 	return qlist_iterator, list, -1
 end
 
@@ -52,14 +52,18 @@ ResponseSkill::ResponseSkill()
 }
 
 void ResponseSkill::setPattern(const QString &pattern){
-    this->pattern = Sanguosha->getPattern(pattern);
+    this->pattern = pattern;
 }
 
 bool ResponseSkill::matchPattern(const Player *player, const Card *card) const{
     if(player->isJilei(card))
         return false;
 
-    return pattern && pattern->match(player, card);
+    if(pattern.isEmpty())
+        return false;
+
+    const CardPattern *card_pattern = Sanguosha->getPattern(pattern);
+    return card_pattern && card_pattern->match(player, card);
 }
 
 bool ResponseSkill::viewFilter(const CardItem *to_select) const{
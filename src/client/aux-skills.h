@@ -35,7 +35,8 @@ public:
     virtual const Card *viewAs(CardItem *card_item) const;
 
 private:
-    const CardPattern *pattern;
+    // the compiled pattern is owned by the cache of Engine, so only the name is kept
+    QString pattern;
 };
 
 class FreeDiscardSkill: public ViewAsSkill{
@@ -28,6 +28,7 @@ Client::Client(QObject *parent, const QString &filename)
     ClientInstance = this;
 
     callbacks["checkVersion"] = &Client::checkVersion;
+    callbacks["protocol"] = &Client::protocol;
 
     callbacks["roomBegin"] = &Client::roomBegin;
     callbacks["room"] = &Client::room;
@@ -98,6 +99,7 @@ Client::Client(QObject *parent, const QString &filename)
     callbacks["askForSkillInvoke"] = &Client::askForSkillInvoke;
     callbacks["askForChoice"] = &Client::askForChoice;
     callbacks["askForNullification"] = &Client::askForNullification;
+    callbacks["cancelNullification"] = &Client::cancelNullification;
     callbacks["askForCardShow"] = &Client::askForCardShow;
     callbacks["askForPindian"] = &Client::askForPindian;
     callbacks["askForYiji"] = &Client::askForYiji;
@@ -120,11 +122,14 @@ Client::Client(QObject *parent, const QString &filename)
     callbacks["askForDirection"] = &Client::askForDirection;
     callbacks["recoverGeneral"] = &Client::recoverGeneral;
     callbacks["revealGeneral"] = &Client::revealGeneral;
+    callbacks["randomSeed"] = &Client::randomSeed;
 
     callbacks["askForAssign"] = &Client::askForAssign;
 
     ask_dialog = NULL;
     use_card = false;
+    random_seed = 0;
+    binary_offered = false;
 
     Self = new ClientPlayer(this);
     Self->setScreenName(Config.UserName);
@@ -165,6 +170,11 @@ void Client::signup(){
     if(replayer)
         replayer->start();
     else{
+        // ask for binary frames only if the server offered them, an old server takes
+        // any line before the signup as a bad signup, the answer is the protocol it will send
+        if(binary_offered && Config.value("BinaryProtocol", true).toBool())
+            request("protocol binary");
+
         QString base64 = Config.UserName.toUtf8().toBase64();
         QString command = Config.value("EnableReconnection", false).toBool() ? "signupr" : "signup";
         QString signup_str = QString("%1 %2:%3").arg(command).arg(base64).arg(Config.UserAvatar);
@@ -188,6 +198,9 @@ void Client::checkVersion(const QString &server_version){
         QStringList texts = server_version.split(QChar(':'));
         version_number = texts.value(0);
         mod_name = texts.value(1);
+
+        // the fields after the MOD name are the features of the server
+        binary_offered = texts.mid(2).contains("binary");
     }else{
         version_number = server_version;
         mod_name = "official";
@@ -196,6 +209,11 @@ void Client::checkVersion(const QString &server_version){
     emit version_checked(version_number, mod_name);
 }
 
+void Client::protocol(const QString &protocol_name){
+    if(socket)
+        socket->setBinary(protocol_name == "binary");
+}
+
 void Client::setup(const QString &setup_str){
     if(socket && !socket->isConnected())
         return;
@@ -215,8 +233,6 @@ void Client::disconnectFromHost(){
     }
 }
 
-typedef char buffer_t[1024];
-
 void Client::processCommand(const QString &cmd){
     processReply(cmd.toAscii().data());
 }
@@ -228,28 +244,31 @@ void Client::processReply(char *reply){
     static char self_prefix = '.';
     static char other_prefix = '#';
 
+    // split into words, long messages such as setup and marshal are never truncated
+    QList<QByteArray> words = QByteArray(reply).simplified().split(' ');
+
     if(reply[0] == self_prefix){
         // client it Self
         if(Self){
-            buffer_t property, value;
-            sscanf(reply, ".%s %s", property, value);
-            Self->setProperty(property, value);
+            QByteArray property = words.at(0).mid(1);
+            QString value = words.value(1);
+            Self->setProperty(property.constData(), value);
         }
     }else if(reply[0] == other_prefix){
         // others
-        buffer_t object_name, property, value;
-        sscanf(reply, "#%s %s %s", object_name, property, value);
+        QString object_name = words.at(0).mid(1);
+        QByteArray property = words.value(1);
+        QString value = words.value(2);
         ClientPlayer *player = getPlayer(object_name);
         if(player){
-            player->setProperty(property, value);
+            player->setProperty(property.constData(), value);
         }else
             QMessageBox::warning(NULL, tr("Warning"), tr("There is no player named %1").arg(object_name));
 
     }else{
         // invoke methods
-        buffer_t method_name, arg;
-        sscanf(reply, "%s %s", method_name, arg);
-        QString method = method_name;
+        QString method = words.at(0);
+        QString arg = words.value(1);
 
         if(replayer && (method.startsWith("askFor") || method.startsWith("do") || method == "activate"))
             return;
@@ -262,10 +281,9 @@ void Client::processReply(char *reply){
 
         Callback callback = callbacks.value(method, NULL);
         if(callback){
-            QString arg_str = arg;
-            (this->*callback)(arg_str);
+            (this->*callback)(arg);
         }else if(!deprecated.contains(method))
-            QMessageBox::information(NULL, tr("Warning"), tr("No such invokable method named \"%1\"").arg(method_name));
+            QMessageBox::information(NULL, tr("Warning"), tr("No such invokable method named \"%1\"").arg(method));
     }
 }
 
@@ -565,6 +583,14 @@ Replayer *Client::getReplayer() const{
     return replayer;
 }
 
+DistanceMatrix *Client::getDistanceMatrix(){
+    return &distance_matrix;
+}
+
+quint64 Client::getRandomSeed() const{
+    return random_seed;
+}
+
 QString Client::getPlayerName(const QString &str){
     QRegExp rx("sgs\\d+");
     QString general_name;
@@ -750,11 +776,13 @@ void Client::playSkillEffect(const QString &play_str){
 }
 
 void Client::askForNullification(const QString &ask_str){
-    QRegExp rx("(\\w+):(.+)->(.+)");
+    // the asks of a poll end with its serial, which is sent back with the reply
+    QRegExp rx("(\\w+):(.+)->(\\w+)(?:@(\\d+))?");
     if(!rx.exactMatch(ask_str))
         return;
 
     QStringList texts = rx.capturedTexts();
+    nullification_poll = texts.at(4);
     QString trick_name = texts.at(1);
     const Card *trick_card = Sanguosha->findChild<const Card *>(trick_name);
 
@@ -786,6 +814,12 @@ void Client::askForNullification(const QString &ask_str){
     setStatus(Responsing);
 }
 
+void Client::cancelNullification(const QString &){
+    // someone else has answered first, the server expects one reply all the same and drops it
+    if(status == Responsing && card_pattern == "nullification")
+        responseCard(NULL);
+}
+
 void Client::playAudio(const QString &name){
     Sanguosha->playAudio(name);
 }
@@ -906,10 +940,13 @@ int Client::alivePlayerCount() const{
 }
 
 void Client::responseCard(const Card *card){
-    if(card)
-        request(QString("responseCard %1").arg(card->toString()));
-    else
-        request("responseCard .");
+    QString reply = card ? card->toString() : QString(".");
+    if(!nullification_poll.isEmpty()){
+        reply.append(" " + nullification_poll);
+        nullification_poll.clear();
+    }
+
+    request("responseCard " + reply);
 
     card_pattern.clear();
     setStatus(NotActive);
@@ -1788,6 +1825,11 @@ void Client::revealGeneral(const QString &reveal_str){
     emit general_revealed(self, general);
 }
 
+// the seed of the room, it is kept in the recording so that the game can be played again
+void Client::randomSeed(const QString &seed_str){
+    random_seed = seed_str.toULongLong();
+}
+
 void Client::selectOrder(){
     OptionButton *button = qobject_cast<OptionButton *>(sender());
 
@@ -6,6 +6,7 @@
 #include "skill.h"
 #include "socket.h"
 #include "clientstruct.h"
+#include "distancematrix.h"
 
 class NullificationDialog;
 class Recorder;
@@ -63,6 +64,8 @@ public:
     void setLines(const QString &skill_name);
     QString getSkillLine() const;
     Replayer *getReplayer() const;
+    DistanceMatrix *getDistanceMatrix();
+    quint64 getRandomSeed() const;
     QString getPlayerName(const QString &str);
     QString getPattern() const;
     QString getSkillNameToInvoke() const;
@@ -74,6 +77,7 @@ public:
     typedef void (Client::*Callback)(const QString &);
 
     void checkVersion(const QString &server_version);
+    void protocol(const QString &protocol_name);
     void setup(const QString &setup_str);
     void addPlayer(const QString &player_info);
     void removePlayer(const QString &player_name);
@@ -136,6 +140,7 @@ public:
     void askForSuit(const QString &);
     void askForKingdom(const QString &);
     void askForNullification(const QString &ask_str);
+    void cancelNullification(const QString &);
     void askForPindian(const QString &ask_str);
     void askForYiji(const QString &card_list);
     void askForCardChosen(const QString &ask_str);
@@ -152,6 +157,7 @@ public:
     void askForDirection(const QString &);
     void recoverGeneral(const QString &);
     void revealGeneral(const QString &);
+    void randomSeed(const QString &seed_str);
 
     void attachSkill(const QString &skill_name);
     void detachSkill(const QString &skill_name);
@@ -191,11 +197,15 @@ private:
     QStringList ban_packages;
     Recorder *recorder;
     Replayer *replayer;
+    quint64 random_seed;
+    bool binary_offered;
+    DistanceMatrix distance_matrix;
     QTextDocument *lines_doc, *prompt_doc;
     int pile_num;
     QString skill_title, skill_line;
     QString choose_command;
     QString card_pattern;
+    QString nullification_poll;
     QString skill_to_invoke;
     int swap_pile;
 
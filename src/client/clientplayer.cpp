@@ -12,6 +12,9 @@ ClientPlayer *Self = NULL;
 ClientPlayer::ClientPlayer(Client *client)
     :Player(client), handcard_num(0)
 {
+    if(client)
+        setDistanceMatrix(client->getDistanceMatrix());
+
     mark_doc = new QTextDocument(this);
     mark_doc->setTextWidth(128);
     mark_doc->setDefaultTextOption(QTextOption(Qt::AlignRight));
@@ -50,6 +53,8 @@ void ClientPlayer::addCard(const Card *card, Place place){
         // FIXME
         ;
     }
+
+    invalidateDistances();
 }
 
 void ClientPlayer::addKnownHandCard(const Card *card){
@@ -86,6 +91,8 @@ void ClientPlayer::removeCard(const Card *card, Place place){
         // FIXME
         ;
     }
+
+    invalidateDistances();
 }
 
 QList<const Card *> ClientPlayer::getCards() const{
@@ -110,6 +117,7 @@ void ClientPlayer::changePile(const QString &name, bool add, int card_id){
     else
         piles[name].removeOne(card_id);
 
+    invalidateDistances();
     emit pile_changed(name);
 }
 
@@ -134,6 +142,7 @@ QString ClientPlayer::getDeathPixmapPath() const{
 
 void ClientPlayer::setHandcardNum(int n){
     handcard_num = n;
+    invalidateDistances();
 }
 
 QString ClientPlayer::getGameMode() const{
@@ -150,10 +159,11 @@ void ClientPlayer::setFlags(const QString &flag){
 }
 
 void ClientPlayer::setMark(const QString &mark, int value){
-    if(marks[mark] == value)
+    if(marks.value(mark, 0) == value)
         return;
 
-    marks[mark] = value;
+    // the ids and the distances are kept by Player
+    Player::setMark(mark, value);
 
     if(!mark.startsWith("@"))
         return;
@@ -5,6 +5,8 @@
 #include "room.h"
 #include "carditem.h"
 #include "lua-wrapper.h"
+#include "cardarena.h"
+#include "cardstring.h"
 #include <QFile>
 
 const Card::Suit Card::AllSuits[4] = {
@@ -15,7 +17,8 @@ const Card::Suit Card::AllSuits[4] = {
 };
 
 Card::Card(Suit suit, int number, bool target_fixed)
-    :target_fixed(target_fixed), once(false), mute(false), will_throw(true), suit(suit), number(number), id(-1)
+    :target_fixed(target_fixed), once(false), mute(false), will_throw(true), suit(suit), number(number), id(-1),
+      arena(NULL)
 {
     can_jilei = will_throw;
 
@@ -23,6 +26,11 @@ Card::Card(Suit suit, int number, bool target_fixed)
         number = 0;
 }
 
+Card::~Card(){
+    if(arena)
+        arena->forget(this);
+}
+
 QString Card::getSuitString() const{
     return Suit2String(suit);
 }
@@ -263,120 +271,70 @@ bool Card::isVirtualCard() const{
 }
 
 const Card *Card::Parse(const QString &str){
-    if(str.startsWith(QChar('@'))){
-        // skill card
-        QRegExp pattern("@(\\w+)=([^:]+)(:.+)?");
-        if(!pattern.exactMatch(str))
-            return NULL;
+    const CardDescriptor *desc = Sanguosha->getCardDescriptor(str);
 
-        QStringList texts = pattern.capturedTexts();
-        QString card_name = texts.at(1);
-        QStringList subcard_ids;
-        QString subcard_str = texts.at(2);
-        if(subcard_str != ".")
-           subcard_ids = subcard_str.split("+");
-        QString user_string = texts.at(3);
-        SkillCard *card = Sanguosha->cloneSkillCard(card_name);
+    switch(desc->kind){
+    case CardDescriptor::Real: return Sanguosha->getCard(desc->card_id);
 
-        if(card == NULL)
-            return NULL;
+    case CardDescriptor::Skill:{
+            SkillCard *card = Sanguosha->cloneSkillCard(desc->name);
+            if(card == NULL)
+                return NULL;
 
-        foreach(QString subcard_id, subcard_ids)
-            card->addSubcard(subcard_id.toInt());
+            foreach(int subcard_id, desc->subcards)
+                card->addSubcard(subcard_id);
 
-        // skill name
-        QString skill_name = card_name.remove("Card").toLower();
-        card->setSkillName(skill_name);
+            card->setSkillName(desc->skill_name);
+            if(!desc->user_string.isEmpty())
+                card->setUserString(desc->user_string);
 
-        if(!user_string.isEmpty()){
-            user_string.remove(0, 1);
-            card->setUserString(user_string);
+            return card;
         }
 
-        return card;
-    }else if(str.startsWith(QChar('$'))){
-        QString copy = str;
-        copy.remove(QChar('$'));
-        QStringList card_strs = copy.split("+");
-        DummyCard *dummy = new DummyCard;
-        foreach(QString card_str, card_strs){
-            dummy->addSubcard(card_str.toInt());
-        }
+    case CardDescriptor::Dummy:{
+            DummyCard *dummy = CardArena::Adopt(new DummyCard);
+            foreach(int subcard_id, desc->subcards)
+                dummy->addSubcard(subcard_id);
 
-        return dummy;
-    }else if(str.startsWith(QChar('#'))){
-        LuaSkillCard *new_card =  LuaSkillCard::Parse(str);
-        return new_card;
-    }if(str.contains(QChar('='))){
-        QRegExp pattern("(\\w+):(\\w*)\\[(\\w+):(.+)\\]=(.+)");
-        if(!pattern.exactMatch(str))
-            return NULL;
-
-        QStringList texts = pattern.capturedTexts();
-        QString name = texts.at(1);
-        QString skill_name = texts.at(2);
-        QString suit_string = texts.at(3);
-        QString number_string = texts.at(4);
-        QString subcard_str = texts.at(5);
-        QStringList subcard_ids;
-        if(subcard_str != ".")
-            subcard_ids = subcard_str.split("+");
-
-        static QMap<QString, Card::Suit> suit_map;
-        if(suit_map.isEmpty()){
-            suit_map.insert("spade", Card::Spade);
-            suit_map.insert("club", Card::Club);
-            suit_map.insert("heart", Card::Heart);
-            suit_map.insert("diamond", Card::Diamond);
-            suit_map.insert("no_suit", Card::NoSuit);
+            return dummy;
         }
 
-        Suit suit = suit_map.value(suit_string, Card::NoSuit);
-
-        int number = 0;
-        if(number_string == "A")
-            number = 1;
-        else if(number_string == "J")
-            number = 11;
-        else if(number_string == "Q")
-            number = 12;
-        else if(number_string == "K")
-            number = 13;
-        else
-            number = number_string.toInt();
+    case CardDescriptor::Lua: return CardArena::Adopt(LuaSkillCard::Parse(*desc));
 
-        Card *card = Sanguosha->cloneCard(name, suit, number);
-        if(card == NULL)
-            return NULL;
+    case CardDescriptor::Virtual:{
+            Card *card = Sanguosha->cloneCard(desc->name, desc->suit, desc->number);
+            if(card == NULL)
+                return NULL;
 
-        foreach(QString subcard_id, subcard_ids)
-            card->addSubcard(subcard_id.toInt());
+            foreach(int subcard_id, desc->subcards)
+                card->addSubcard(subcard_id);
 
-        card->setSkillName(skill_name);
-        return card;
-    }else{
-        bool ok;
-        int card_id = str.toInt(&ok);
-        if(ok)
-            return Sanguosha->getCard(card_id);
-        else
-            return NULL;
+            card->setSkillName(desc->skill_name);
+            return card;
+        }
+
+    default:
+        return NULL;
     }
 }
 
 Card *Card::Clone(const Card *card){
-    const QMetaObject *meta = card->metaObject();
     Card::Suit suit = card->getSuit();
     int number = card->getNumber();
 
-    QObject *card_obj = meta->newInstance(Q_ARG(Card::Suit, suit), Q_ARG(int, number));
-    if(card_obj){
-        Card *new_card = qobject_cast<Card *>(card_obj);
+    Card *new_card = Sanguosha->cloneCard(card->objectName(), suit, number);
+    if(new_card == NULL){
+        const QMetaObject *meta = card->metaObject();
+        QObject *card_obj = meta->newInstance(Q_ARG(Card::Suit, suit), Q_ARG(int, number));
+        if(card_obj == NULL)
+            return NULL;
+
+        new_card = CardArena::Adopt(qobject_cast<Card *>(card_obj));
         new_card->setObjectName(card->objectName());
-        new_card->addSubcard(card->getId());
-        return new_card;
-    }else
-        return NULL;
+    }
+
+    new_card->addSubcard(card->getId());
+    return new_card;
 }
 
 bool Card::targetFixed() const{
@@ -11,6 +11,7 @@ class ServerPlayer;
 class Client;
 class ClientPlayer;
 class CardItem;
+class CardArena;
 
 struct CardEffectStruct;
 struct CardMoveStruct;
@@ -50,6 +51,7 @@ public:
 
     // constructor
     Card(Suit suit, int number, bool target_fixed = false);
+    ~Card();
 
     // property getters/setters
     QString getSuitString() const;
@@ -144,6 +146,10 @@ private:
     Suit suit;
     int number;
     int id;
+
+    // the arena that deletes this card when the room is done, see cardarena.h
+    friend class CardArena;
+    CardArena *arena;
 };
 
 class SkillCard: public Card{
@@ -173,4 +179,17 @@ public:
     virtual QString toString() const;
 };
 
+// makes a card of a known class, without QMetaObject::newInstance and its boxed arguments
+typedef Card *(*CardFactory)(Card::Suit suit, int number);
+
+template<typename T>
+Card *CreateCard(Card::Suit suit, int number){
+    return new T(suit, number);
+}
+
+template<typename T>
+Card *CreateSkillCard(Card::Suit, int){
+    return new T;
+}
+
 #endif // CARD_H
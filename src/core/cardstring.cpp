@@ -0,0 +1,435 @@
+#include "cardstring.h"
+#include "engine.h"
+
+#include <QRegExp>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <climits>
+
+CardDescriptor::CardDescriptor()
+    :kind(Invalid), suit(Card::NoSuit), number(0), card_id(-1)
+{
+}
+
+bool CardDescriptor::operator ==(const CardDescriptor &other) const{
+    return kind == other.kind && name == other.name && skill_name == other.skill_name
+            && user_string == other.user_string && suit == other.suit && number == other.number
+            && card_id == other.card_id && subcards == other.subcards;
+}
+
+static inline bool IsWordChar(QChar c){
+    // what \w matches in QRegExp
+    return c.isLetterOrNumber() || c.isMark() || c == QChar('_');
+}
+
+static int ScanWord(const QChar *s, int from, int to){
+    while(from < to && IsWordChar(s[from]))
+        from ++;
+
+    return from;
+}
+
+// reads [from, to) like QString::toInt, which gives 0 for what it can not read
+static int ReadInt(const QChar *s, int from, int to){
+    while(from < to && s[from].isSpace())
+        from ++;
+    while(to > from && s[to - 1].isSpace())
+        to --;
+
+    bool negative = false;
+    if(from < to && (s[from] == QChar('+') || s[from] == QChar('-'))){
+        negative = s[from] == QChar('-');
+        from ++;
+    }
+
+    if(from == to)
+        return 0;
+
+    qint64 value = 0;
+    for(; from < to; from ++){
+        ushort c = s[from].unicode();
+        if(c < '0' || c > '9')
+            return 0;
+
+        value = value * 10 + (c - '0');
+        if(value > qint64(INT_MAX) + 1)
+            return 0;
+    }
+
+    if(negative)
+        value = -value;
+
+    if(value > INT_MAX || value < INT_MIN)
+        return 0;
+
+    return int(value);
+}
+
+// a single "." is no subcard at all, anything else is a list of ids joined by "+"
+static void ReadSubcards(const QChar *s, int from, int to, QList<int> &subcards){
+    if(to - from == 1 && s[from] == QChar('.'))
+        return;
+
+    int start = from, i;
+    for(i=from; i<=to; i++){
+        if(i == to || s[i] == QChar('+')){
+            subcards << ReadInt(s, start, i);
+            start = i + 1;
+        }
+    }
+}
+
+static Card::Suit ReadSuit(const QString &str, int from, int to){
+    QStringRef suit_string(&str, from, to - from);
+    if(suit_string == QLatin1String("spade"))
+        return Card::Spade;
+    else if(suit_string == QLatin1String("club"))
+        return Card::Club;
+    else if(suit_string == QLatin1String("heart"))
+        return Card::Heart;
+    else if(suit_string == QLatin1String("diamond"))
+        return Card::Diamond;
+    else
+        return Card::NoSuit;
+}
+
+static int ReadNumber(const QChar *s, int from, int to){
+    if(to - from == 1){
+        switch(s[from].unicode()){
+        case 'A': return 1;
+        case 'J': return 11;
+        case 'Q': return 12;
+        case 'K': return 13;
+        default: break;
+        }
+    }
+
+    return ReadInt(s, from, to);
+}
+
+bool CardDescriptor::Parse(const QString &str, CardDescriptor &desc){
+    desc = CardDescriptor();
+
+    const QChar *s = str.unicode();
+    int n = str.length();
+    QChar first = n > 0 ? s[0] : QChar();
+
+    if(first == QChar('@')){
+        // @name=subcards, then ":user_string" if the user string is not empty
+        int i = ScanWord(s, 1, n);
+        if(i == 1 || i == n || s[i] != QChar('='))
+            return false;
+
+        int colon = i + 1;
+        while(colon < n && s[colon] != QChar(':'))
+            colon ++;
+
+        if(colon == i + 1 || colon == n - 1)
+            return false;
+
+        desc.kind = Skill;
+        desc.name = QString(s + 1, i - 1);
+        ReadSubcards(s, i + 1, colon, desc.subcards);
+        if(colon < n)
+            desc.user_string = QString(s + colon + 1, n - colon - 1);
+
+        QString skill_name = desc.name;
+        desc.skill_name = skill_name.remove("Card").toLower();
+
+        return true;
+    }else if(first == QChar('$')){
+        // every "$" is dropped, not only the first one
+        desc.kind = Dummy;
+        if(str.indexOf(QChar('$'), 1) == -1)
+            ReadSubcards(s, 1, n, desc.subcards);
+        else{
+            QString copy = str;
+            copy.remove(QChar('$'));
+            ReadSubcards(copy.unicode(), 0, copy.length(), desc.subcards);
+        }
+
+        return true;
+    }else if(first == QChar('#')){
+        // #name:subcards:user_string, the subcards run to the last colon
+        int i = ScanWord(s, 1, n);
+        if(i == 1 || i == n || s[i] != QChar(':'))
+            return false;
+
+        int last = n - 1;
+        while(last > i && s[last] != QChar(':'))
+            last --;
+
+        if(last == i)
+            return false;
+
+        desc.kind = Lua;
+        desc.name = QString(s + 1, i - 1);
+        ReadSubcards(s, i + 1, last, desc.subcards);
+        desc.user_string = QString(s + last + 1, n - last - 1);
+        desc.skill_name = desc.name;
+
+        return true;
+    }else if(str.contains(QChar('='))){
+        // name:skill_name[suit:number]=subcards, the number runs to the last "]="
+        int i = ScanWord(s, 0, n);
+        if(i == 0 || i == n || s[i] != QChar(':'))
+            return false;
+
+        int j = ScanWord(s, i + 1, n);
+        if(j == n || s[j] != QChar('['))
+            return false;
+
+        int k = ScanWord(s, j + 1, n);
+        if(k == j + 1 || k == n || s[k] != QChar(':'))
+            return false;
+
+        int p = n - 3;
+        while(p >= k + 2 && !(s[p] == QChar(']') && s[p + 1] == QChar('=')))
+            p --;
+
+        if(p < k + 2)
+            return false;
+
+        desc.kind = Virtual;
+        desc.name = QString(s, i);
+        desc.skill_name = QString(s + i + 1, j - i - 1);
+        desc.suit = ReadSuit(str, j + 1, k);
+        desc.number = ReadNumber(s, k + 1, p);
+        ReadSubcards(s, p + 2, n, desc.subcards);
+
+        return true;
+    }else{
+        bool ok;
+        int card_id = str.toInt(&ok);
+        if(!ok)
+            return false;
+
+        desc.kind = Real;
+        desc.card_id = card_id;
+        return true;
+    }
+}
+
+// the regular expressions Card::Parse and LuaSkillCard::Parse used before
+static bool ReferenceParse(const QString &str, CardDescriptor &desc){
+    desc = CardDescriptor();
+
+    if(str.startsWith(QChar('@'))){
+        QRegExp pattern("@(\\w+)=([^:]+)(:.+)?");
+        if(!pattern.exactMatch(str))
+            return false;
+
+        QStringList texts = pattern.capturedTexts();
+        desc.kind = CardDescriptor::Skill;
+        desc.name = texts.at(1);
+        if(texts.at(2) != "."){
+            foreach(QString subcard_id, texts.at(2).split("+"))
+                desc.subcards << subcard_id.toInt();
+        }
+
+        QString skill_name = desc.name;
+        desc.skill_name = skill_name.remove("Card").toLower();
+        if(!texts.at(3).isEmpty())
+            desc.user_string = texts.at(3).mid(1);
+
+        return true;
+    }else if(str.startsWith(QChar('$'))){
+        QString copy = str;
+        copy.remove(QChar('$'));
+        desc.kind = CardDescriptor::Dummy;
+        if(copy != "."){
+            foreach(QString card_str, copy.split("+"))
+                desc.subcards << card_str.toInt();
+        }
+
+        return true;
+    }else if(str.startsWith(QChar('#'))){
+        QRegExp rx("#(\\w+):(.*):(.*)");
+        if(!rx.exactMatch(str))
+            return false;
+
+        QStringList texts = rx.capturedTexts();
+        desc.kind = CardDescriptor::Lua;
+        desc.name = desc.skill_name = texts.at(1);
+        if(texts.at(2) != "."){
+            foreach(QString subcard, texts.at(2).split("+"))
+                desc.subcards << subcard.toInt();
+        }
+        desc.user_string = texts.at(3);
+
+        return true;
+    }else if(str.contains(QChar('='))){
+        QRegExp pattern("(\\w+):(\\w*)\\[(\\w+):(.+)\\]=(.+)");
+        if(!pattern.exactMatch(str))
+            return false;
+
+        QStringList texts = pattern.capturedTexts();
+        desc.kind = CardDescriptor::Virtual;
+        desc.name = texts.at(1);
+        desc.skill_name = texts.at(2);
+
+        QString suit_string = texts.at(3);
+        if(suit_string == "spade")
+            desc.suit = Card::Spade;
+        else if(suit_string == "club")
+            desc.suit = Card::Club;
+        else if(suit_string == "heart")
+            desc.suit = Card::Heart;
+        else if(suit_string == "diamond")
+            desc.suit = Card::Diamond;
+
+        QString number_string = texts.at(4);
+        if(number_string == "A")
+            desc.number = 1;
+        else if(number_string == "J")
+            desc.number = 11;
+        else if(number_string == "Q")
+            desc.number = 12;
+        else if(number_string == "K")
+            desc.number = 13;
+        else
+            desc.number = number_string.toInt();
+
+        if(texts.at(5) != "."){
+            foreach(QString subcard_id, texts.at(5).split("+"))
+                desc.subcards << subcard_id.toInt();
+        }
+
+        return true;
+    }else{
+        bool ok;
+        int card_id = str.toInt(&ok);
+        if(!ok)
+            return false;
+
+        desc.kind = CardDescriptor::Real;
+        desc.card_id = card_id;
+        return true;
+    }
+}
+
+QString CardDescriptor::Benchmark(int rounds){
+    QStringList corpus;
+
+    // the strings that toString writes, for the round trip through Card::Parse
+    int i;
+    for(i=0; i<Sanguosha->getCardCount(); i++){
+        const Card *card = Sanguosha->getCard(i);
+        corpus << card->toString();
+
+        Card *virtual_card = Sanguosha->cloneCard(card->objectName(), card->getSuit(), card->getNumber());
+        if(virtual_card){
+            virtual_card->addSubcard(card);
+            if(i % 2 == 0)
+                virtual_card->addSubcard((i + 1) % Sanguosha->getCardCount());
+            virtual_card->setSkillName(i % 3 == 0 ? "wusheng" : "");
+            corpus << virtual_card->toString();
+            delete virtual_card;
+        }
+    }
+
+    QStringList skill_cards;
+    skill_cards << "RendeCard" << "ZhihengCard" << "LijianCard" << "QingnangCard"
+                << "KurouCard" << "JieyinCard" << "GuhuoCard" << "TianyiCard";
+    foreach(QString name, skill_cards){
+        SkillCard *card = Sanguosha->cloneSkillCard(name);
+        if(card == NULL)
+            continue;
+
+        corpus << card->toString();
+        card->addSubcard(3);
+        card->addSubcard(17);
+        corpus << card->toString();
+        card->setUserString("slash");
+        corpus << card->toString();
+        delete card;
+    }
+
+    corpus << "$." << "$12" << "$1+2+3+4";
+
+    QStringList round_trip = corpus;
+    int round_trip_failures = 0;
+    foreach(QString str, round_trip){
+        const Card *card = Card::Parse(str);
+        if(card == NULL || card->toString() != str)
+            round_trip_failures ++;
+
+        if(card && card->isVirtualCard())
+            delete card;
+    }
+
+    // Lua skill cards need their scripts, so they are only checked against the regular expressions
+    corpus << "#luarende:1+2:" << "#luarende:.:slash" << "#luarende:3:a:b";
+
+    // random edits of the valid strings, which both parsers have to read the same
+    static const char alphabet[] = "@$#=:[]+.- 0123456789AJQKCardslh_";
+    qsrand(20120101);
+    int fuzz_count = 20000, fuzz_mismatches = 0, fuzz_valid = 0;
+    for(i=0; i<fuzz_count; i++){
+        QString str = corpus.at(qrand() % corpus.length());
+        int edits = 1 + qrand() % 3, e;
+        for(e=0; e<edits; e++){
+            QChar c(alphabet[qrand() % (sizeof(alphabet) - 1)]);
+            int pos = str.isEmpty() ? 0 : qrand() % (str.length() + 1);
+            switch(qrand() % 3){
+            case 0: str.insert(pos, c); break;
+            case 1: if(pos < str.length()) str.remove(pos, 1); break;
+            default: if(pos < str.length()) str[pos] = c; break;
+            }
+        }
+
+        CardDescriptor expected, actual;
+        bool expected_ok = ReferenceParse(str, expected);
+        bool actual_ok = Parse(str, actual);
+        if(expected_ok != actual_ok || (expected_ok && !(expected == actual)))
+            fuzz_mismatches ++;
+        if(actual_ok)
+            fuzz_valid ++;
+    }
+
+    foreach(QString str, corpus){
+        CardDescriptor expected, actual;
+        bool expected_ok = ReferenceParse(str, expected);
+        if(expected_ok != Parse(str, actual) || !(expected == actual))
+            fuzz_mismatches ++;
+    }
+
+    QElapsedTimer timer;
+    qint64 regexp_msecs, scan_msecs, cached_msecs;
+    int r;
+    CardDescriptor desc;
+
+    timer.start();
+    for(r=0; r<rounds; r++){
+        foreach(QString str, corpus)
+            ReferenceParse(str, desc);
+    }
+    regexp_msecs = timer.elapsed();
+
+    timer.start();
+    for(r=0; r<rounds; r++){
+        foreach(QString str, corpus)
+            Parse(str, desc);
+    }
+    scan_msecs = timer.elapsed();
+
+    timer.start();
+    for(r=0; r<rounds; r++){
+        foreach(QString str, corpus)
+            Sanguosha->getCardDescriptor(str);
+    }
+    cached_msecs = timer.elapsed();
+
+    qreal calls = qMax(qreal(rounds) * corpus.length(), 1.0);
+    QStringList report;
+    report << QString("%1 card strings, %2 rounds").arg(corpus.length()).arg(rounds)
+           << QString("regular expressions: %1 ns/string").arg(regexp_msecs * 1e6 / calls, 0, 'f', 1)
+           << QString("scanner:             %1 ns/string").arg(scan_msecs * 1e6 / calls, 0, 'f', 1)
+           << QString("cached descriptors:  %1 ns/string").arg(cached_msecs * 1e6 / calls, 0, 'f', 1)
+           << QString("round trip: %1 of %2 strings did not come back from Card::Parse")
+              .arg(round_trip_failures).arg(round_trip.length())
+           << QString("fuzz: %1 edited strings, %2 valid, %3 read differently from the regular expressions")
+              .arg(fuzz_count).arg(fuzz_valid).arg(fuzz_mismatches);
+
+    return report.join("\n");
+}
@@ -0,0 +1,44 @@
+#ifndef CARDSTRING_H
+#define CARDSTRING_H
+
+#include "card.h"
+
+#include <QString>
+#include <QList>
+
+// the fields of a card string, in one of the forms that the toString functions write:
+//   12                              a real card
+//   @RendeCard=3+5[:user_string]    a skill card
+//   $3+5                            a dummy card
+//   #name:3+5:user_string           a Lua skill card
+//   slash:wusheng[heart:7]=3        a virtual card
+struct CardDescriptor{
+    enum Kind{
+        Invalid,
+        Real,
+        Skill,
+        Dummy,
+        Lua,
+        Virtual
+    };
+
+    CardDescriptor();
+    bool operator ==(const CardDescriptor &other) const;
+
+    // scans the string without building any intermediate string, only the fields are allocated
+    static bool Parse(const QString &str, CardDescriptor &desc);
+
+    // round-trips and fuzzes the parser against the regular expressions it replaced, and times both
+    static QString Benchmark(int rounds);
+
+    Kind kind;
+    QString name;
+    QString skill_name;
+    QString user_string;
+    Card::Suit suit;
+    int number;
+    int card_id;
+    QList<int> subcards;
+};
+
+#endif // CARDSTRING_H
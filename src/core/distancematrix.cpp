@@ -0,0 +1,73 @@
+#include "distancematrix.h"
+#include "player.h"
+
+static bool Enabled = true;
+
+// a cell that has not been computed since the last invalidation
+static const int Unknown = -1;
+
+DistanceMatrix::DistanceMatrix()
+    :capacity(0), dirty(false), hits(0), misses(0)
+{
+}
+
+bool DistanceMatrix::IsEnabled(){
+    return Enabled;
+}
+
+void DistanceMatrix::SetEnabled(bool enabled){
+    Enabled = enabled;
+}
+
+int DistanceMatrix::indexOf(const Player *player){
+    int index = indices.value(player, -1);
+    if(index != -1)
+        return index;
+
+    index = indices.size();
+    indices.insert(player, index);
+
+    // the cells are laid out by the capacity, so they are all thrown away when it grows
+    if(index >= capacity){
+        capacity = qMax(capacity * 2, 8);
+        cells.fill(Unknown, capacity * capacity);
+    }
+
+    return index;
+}
+
+int DistanceMatrix::distance(const Player *from, const Player *to){
+    if(dirty){
+        cells.fill(Unknown);
+        dirty = false;
+    }
+
+    int i = indexOf(from);
+    int j = indexOf(to);
+    int value = cells.at(i * capacity + j);
+    if(value != Unknown){
+        hits ++;
+        return value;
+    }
+
+    misses ++;
+
+    // a Lua distance skill may ask for other distances or change the room while this one is computed
+    value = from->computeDistance(to);
+    if(!dirty)
+        cells[indexOf(from) * capacity + indexOf(to)] = value;
+
+    return value;
+}
+
+void DistanceMatrix::invalidate(){
+    dirty = true;
+}
+
+int DistanceMatrix::getHitCount() const{
+    return hits;
+}
+
+int DistanceMatrix::getMissCount() const{
+    return misses;
+}
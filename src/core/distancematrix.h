@@ -0,0 +1,35 @@
+#ifndef DISTANCEMATRIX_H
+#define DISTANCEMATRIX_H
+
+class Player;
+
+#include <QHash>
+#include <QVector>
+
+// the distances between the players of one room, a distance is computed the first time
+// it is asked for and kept until something that can change a distance happens,
+// the players call invalidate() for that
+class DistanceMatrix{
+public:
+    DistanceMatrix();
+
+    static bool IsEnabled();
+    static void SetEnabled(bool enabled);
+
+    int distance(const Player *from, const Player *to);
+    void invalidate();
+
+    int getHitCount() const;
+    int getMissCount() const;
+
+private:
+    QHash<const Player *, int> indices;
+    QVector<int> cells;
+    int capacity;
+    bool dirty;
+    int hits, misses;
+
+    int indexOf(const Player *player);
+};
+
+#endif // DISTANCEMATRIX_H
@@ -7,6 +7,8 @@
 #include "lua.hpp"
 #include "banpair.h"
 #include "audio.h"
+#include "cardarena.h"
+#include "roomconfig.h"
 
 #include <QFile>
 #include <QTextStream>
@@ -15,6 +17,8 @@
 #include <QDir>
 #include <QLibrary>
 #include <QApplication>
+#include <QMutex>
+#include <QScopedPointer>
 
 Engine *Sanguosha = NULL;
 
@@ -134,20 +138,70 @@ Engine::Engine()
     }
 }
 
+// compiled chunks of the scripts, shared by every Lua state of this process
+static QHash<QString, QByteArray> LuaBytecodeCache;
+static QMutex LuaBytecodeMutex;
+
+static int WriteBytecode(lua_State *, const void *p, size_t sz, void *ud){
+    QByteArray *bytecode = static_cast<QByteArray *>(ud);
+    bytecode->append(static_cast<const char *>(p), sz);
+    return 0;
+}
+
+static int LoadCachedFile(lua_State *L, const char *filename){
+    QMutexLocker locker(&LuaBytecodeMutex);
+
+    QString key = filename;
+    if(LuaBytecodeCache.contains(key)){
+        const QByteArray &bytecode = LuaBytecodeCache[key];
+        return luaL_loadbuffer(L, bytecode.constData(), bytecode.size(), filename);
+    }
+
+    int error = luaL_loadfile(L, filename);
+    if(error)
+        return error;
+
+    QByteArray bytecode;
+    if(lua_dump(L, WriteBytecode, &bytecode) == 0)
+        LuaBytecodeCache.insert(key, bytecode);
+
+    return 0;
+}
+
+// replacement of the dofile in base library, only parses each script once
+static int CachedDofile(lua_State *L){
+    const char *filename = luaL_checkstring(L, 1);
+    int n = lua_gettop(L);
+    if(LoadCachedFile(L, filename) != 0)
+        lua_error(L);
+
+    lua_call(L, 0, LUA_MULTRET);
+    return lua_gettop(L) - n;
+}
+
+static int DoCachedFile(lua_State *L, const char *filename){
+    int error = LoadCachedFile(L, filename);
+    if(error)
+        return error;
+
+    return lua_pcall(L, 0, LUA_MULTRET, 0);
+}
+
 lua_State *Engine::createLuaState(bool load_ai, QString &error_msg){
     lua_State *L = luaL_newstate();
     luaL_openlibs(L);
+    lua_register(L, "dofile", CachedDofile);
 
     luaopen_sgs(L);
 
-    int error = luaL_dofile(L, "sanguosha.lua");
+    int error = DoCachedFile(L, "sanguosha.lua");
     if(error){
         error_msg = lua_tostring(L, -1);
         return NULL;
     }
 
     if(load_ai){
-        error = luaL_dofile(L, "lua/ai/smart-ai.lua");
+        error = DoCachedFile(L, "lua/ai/smart-ai.lua");
         if(error){
             error_msg = lua_tostring(L, -1);
             return NULL;
@@ -192,17 +246,24 @@ const Scenario *Engine::getScenario(const QString &name) const{
     return scenarios.value(name, NULL);
 }
 
-void Engine::addSkills(const QList<const Skill *> &all_skills){
+void Engine::addSkills(const QList<const Skill *> &all_skills, bool owned){
     foreach(const Skill *skill, all_skills){
         if(skills.contains(skill->objectName()))
             QMessageBox::warning(NULL, "", tr("Duplicated skill : %1").arg(skill->objectName()));
 
         skills.insert(skill->objectName(), skill);
+        Symbol::Intern(skill->objectName());
 
         if(skill->inherits("ProhibitSkill"))
             prohibit_skills << qobject_cast<const ProhibitSkill *>(skill);
-        else if(skill->inherits("DistanceSkill"))
-            distance_skills << qobject_cast<const DistanceSkill *>(skill);
+        else if(skill->inherits("DistanceSkill")){
+            const DistanceSkill *distance_skill = qobject_cast<const DistanceSkill *>(skill);
+            distance_skills << distance_skill;
+            if(owned)
+                owned_distance_skills << distance_skill;
+            else
+                global_distance_skills << distance_skill;
+        }
     }
 }
 
@@ -210,11 +271,20 @@ QList<const DistanceSkill *> Engine::getDistanceSkills() const{
     return distance_skills;
 }
 
+QList<const DistanceSkill *> Engine::getOwnedDistanceSkills() const{
+    return owned_distance_skills;
+}
+
+QList<const ProhibitSkill *> Engine::getProhibitSkills() const{
+    return prohibit_skills;
+}
+
 void Engine::addPackage(Package *package){
     if(findChild<const Package *>(package->objectName()))
         return;
 
     package->setParent(this);
+    factories.unite(package->getFactories());
 
     QList<Card *> all_cards = package->findChildren<Card *>();
     foreach(Card *card, all_cards){
@@ -223,13 +293,14 @@ void Engine::addPackage(Package *package){
 
         QString card_name = card->objectName();
         metaobjects.insert(card_name, card->metaObject());
+        class_ids.insert(card->metaObject(), Symbol::Intern(card->metaObject()->className()));
     }
 
     addSkills(package->getSkills());
 
     QList<General *> all_generals = package->findChildren<General *>();
     foreach(General *general, all_generals){
-        addSkills(general->findChildren<const Skill *>());
+        addSkills(general->findChildren<const Skill *>(), true);
 
         if(general->isHidden()){
             hidden_generals.insert(general->objectName(), general);
@@ -245,8 +316,10 @@ void Engine::addPackage(Package *package){
     }
 
     QList<const QMetaObject *> metas = package->getMetaObjects();
-    foreach(const QMetaObject *meta, metas)
+    foreach(const QMetaObject *meta, metas){
         metaobjects.insert(meta->className(), meta);
+        class_ids.insert(meta, Symbol::Intern(meta->className()));
+    }
 
     patterns.unite(package->getPatterns());
     related_skills.unite(package->getRelatedSkills());
@@ -280,7 +353,47 @@ const CardPattern *Engine::getPattern(const QString &name) const{
     const CardPattern * ptn = patterns.value(name, NULL);
     if(ptn)return ptn;
 
-    return new ExpPattern(name);
+    // a pattern stays valid until the same thread asks for more new patterns than the cache holds
+    QCache<QString, ExpPattern> *cache = pattern_caches.localData();
+    if(cache == NULL){
+        cache = new QCache<QString, ExpPattern>(qMax(Config.value("PatternCacheSize", 256).toInt(), 16));
+        pattern_caches.setLocalData(cache);
+    }
+
+    ExpPattern *exp_pattern = cache->object(name);
+    if(exp_pattern == NULL){
+        exp_pattern = new ExpPattern(name);
+        cache->insert(name, exp_pattern);
+    }
+
+    return exp_pattern;
+}
+
+QStringList Engine::getPatternNames() const{
+    return patterns.keys();
+}
+
+const CardDescriptor *Engine::getCardDescriptor(const QString &str) const{
+    // the same strings come back again and again, for every use, response and AI answer
+    QCache<QString, CardDescriptor> *cache = card_string_caches.localData();
+    if(cache == NULL){
+        cache = new QCache<QString, CardDescriptor>(qMax(Config.value("CardStringCacheSize", 512).toInt(), 16));
+        card_string_caches.setLocalData(cache);
+    }
+
+    CardDescriptor *desc = cache->object(str);
+    if(desc == NULL){
+        // an invalid string is kept too, as a descriptor of the Invalid kind
+        desc = new CardDescriptor;
+        CardDescriptor::Parse(str, *desc);
+        cache->insert(str, desc);
+    }
+
+    return desc;
+}
+
+int Engine::getCardClassId(const QMetaObject *meta) const{
+    return class_ids.value(meta, -1);
 }
 
 QList<const Skill *> Engine::getRelatedSkills(const QString &skill_name) const{
@@ -298,33 +411,35 @@ const General *Engine::getGeneral(const QString &name) const{
         return hidden_generals.value(name, NULL);
 }
 
-int Engine::getGeneralCount(bool include_banned) const{
+// the queries made outside a room see Config as it is at the moment
+static const RoomConfig *CurrentConfig(const RoomConfig *config, QScopedPointer<const RoomConfig> &snapshot){
+    if(config)
+        return config;
+
+    snapshot.reset(new RoomConfig(Config.GameMode));
+    return snapshot.data();
+}
+
+int Engine::getGeneralCount(bool include_banned, const RoomConfig *config) const{
     if(include_banned)
         return generals.size();
 
+    QScopedPointer<const RoomConfig> snapshot;
+    config = CurrentConfig(config, snapshot);
+
     int total = generals.size();
     QHashIterator<QString, const General *> itor(generals);
     while(itor.hasNext()){
         itor.next();
         const General *general = itor.value();
-        if(ban_package.contains(general->getPackage()))
+        if(config->isBannedPackage(general->getPackage()))
             total--;
 
-        else if( (ServerInfo.GameMode.endsWith("p") ||
-                  ServerInfo.GameMode.endsWith("pd"))
-                  && Config.value("Banlist/Roles").toStringList().contains(general->objectName()))
+        else if(config->isBannedGeneral(general->objectName()))
             total--;
 
-        else if(ServerInfo.Enable2ndGeneral && BanPair::isBanned(general->objectName()))
+        else if(config->Enable2ndGeneral && BanPair::isBanned(general->objectName()))
             total--;
-
-        else if(ServerInfo.EnableBasara &&
-                Config.value("Banlist/Basara").toStringList().contains(general->objectName()))
-            total -- ;
-
-        else if(ServerInfo.EnableHegemony &&
-                Config.value("Banlist/Hegemony").toStringList().contains(general->objectName()))
-            total -- ;
     }
 
     return total;
@@ -339,22 +454,43 @@ const Card *Engine::getCard(int index) const{
 
 Card *Engine::cloneCard(const QString &name, Card::Suit suit, int number) const{
     const QMetaObject *meta = metaobjects.value(name, NULL);
-    if(meta){
+    if(meta == NULL)
+        return NULL;
+
+    Card *card = NULL;
+    CardFactory factory = factories.value(meta, NULL);
+    if(factory)
+        card = factory(suit, number);
+    else{
+        // the classes without a factory are still made by reflection
         QObject *card_obj = meta->newInstance(Q_ARG(Card::Suit, suit), Q_ARG(int, number));
-        card_obj->setObjectName(name);
-        return qobject_cast<Card *>(card_obj);
-    }else
+        card = qobject_cast<Card *>(card_obj);
+    }
+
+    if(card == NULL)
         return NULL;
+
+    card->setObjectName(name);
+    return CardArena::Adopt(card);
 }
 
 SkillCard *Engine::cloneSkillCard(const QString &name) const{
     const QMetaObject *meta = metaobjects.value(name, NULL);
-    if(meta){
-        QObject *card_obj = meta->newInstance();
-        SkillCard *card = qobject_cast<SkillCard *>(card_obj);
-        return card;
-    }else
+    if(meta == NULL)
         return NULL;
+
+    CardFactory factory = factories.value(meta, NULL);
+    if(factory == NULL)
+        return CardArena::Adopt(qobject_cast<SkillCard *>(meta->newInstance()));
+
+    Card *card = factory(Card::NoSuit, 0);
+    SkillCard *skill_card = qobject_cast<SkillCard *>(card);
+    if(skill_card == NULL){
+        delete card;
+        return NULL;
+    }
+
+    return CardArena::Adopt(skill_card);
 }
 
 QString Engine::getVersionNumber() const{
@@ -588,42 +724,41 @@ QStringList Engine::getLords() const{
     return lords;
 }
 
-QStringList Engine::getRandomLords() const{
-    QStringList banlist_ban;
-    if(Config.EnableBasara)
-        banlist_ban = Config.value("Banlist/basara").toStringList();
-
-    if(Config.GameMode == "zombie_mode")
-        banlist_ban.append(Config.value("Banlist/zombie").toStringList());
-    else if((Config.GameMode.endsWith("p") ||
-             Config.GameMode.endsWith("pd")))
-        banlist_ban.append(Config.value("Banlist/Roles").toStringList());
+QStringList Engine::getRandomLords(RandomGenerator *rng, const RoomConfig *config) const{
+    QScopedPointer<const RoomConfig> snapshot;
+    config = CurrentConfig(config, snapshot);
 
     QStringList lords;
+    foreach(QString lord, lord_list){
+        const General *general = generals.value(lord);
+        if(config->isBannedPackage(general->getPackage()))
+            continue;
 
-    foreach(QString alord,getLords())
-    {
-        if(banlist_ban.contains(alord))continue;
+        if(config->Enable2ndGeneral && BanPair::isBanned(general->objectName()))
+            continue;
+
+        if(config->isBannedChoice(lord))
+            continue;
 
-        lords << alord;
+        lords << lord;
     }
 
     QStringList nonlord_list;
     foreach(QString nonlord, this->nonlord_list){
         const General *general = generals.value(nonlord);
-        if(ban_package.contains(general->getPackage()))
+        if(config->isBannedPackage(general->getPackage()))
             continue;
 
-        if(Config.Enable2ndGeneral && BanPair::isBanned(general->objectName()))
+        if(config->Enable2ndGeneral && BanPair::isBanned(general->objectName()))
             continue;
 
-        if(banlist_ban.contains(general->objectName()))
+        if(config->isBannedChoice(general->objectName()))
             continue;
 
         nonlord_list << nonlord;
     }
 
-    qShuffle(nonlord_list);
+    qShuffle(nonlord_list, rng);
 
     int i;
     const static int extra = 2;
@@ -633,12 +768,14 @@ QStringList Engine::getRandomLords() const{
     return lords;
 }
 
-QStringList Engine::getLimitedGeneralNames() const{
+QStringList Engine::getLimitedGeneralNames(const RoomConfig *config) const{
+    const QSet<QString> &banned = config ? config->BanPackages : ban_package;
+
     QStringList general_names;
     QHashIterator<QString, const General *> itor(generals);
     while(itor.hasNext()){
         itor.next();
-        if(!ban_package.contains(itor.value()->getPackage())){
+        if(!banned.contains(itor.value()->getPackage())){
             general_names << itor.key();
         }
     }
@@ -646,25 +783,20 @@ QStringList Engine::getLimitedGeneralNames() const{
     return general_names;
 }
 
-QStringList Engine::getRandomGenerals(int count, const QSet<QString> &ban_set) const{
-    QStringList all_generals = getLimitedGeneralNames();
+QStringList Engine::getRandomGenerals(int count, const QSet<QString> &ban_set, RandomGenerator *rng,
+                                      const RoomConfig *config) const{
+    QScopedPointer<const RoomConfig> snapshot;
+    config = CurrentConfig(config, snapshot);
+
+    QStringList all_generals = getLimitedGeneralNames(config);
     QSet<QString> general_set = all_generals.toSet();
 
     Q_ASSERT(all_generals.count() >= count);
 
-    if(Config.EnableBasara) general_set =
-            general_set.subtract(Config.value("Banlist/Basara", "").toStringList().toSet());
-    if(Config.EnableHegemony) general_set =
-            general_set.subtract(Config.value("Banlist/Hegemony", "").toStringList().toSet());
-
-    if(ServerInfo.GameMode.endsWith("p") ||
-                      ServerInfo.GameMode.endsWith("pd"))
-        general_set.subtract(Config.value("Banlist/Roles","").toStringList().toSet());
-
-    all_generals = general_set.subtract(ban_set).toList();
+    all_generals = general_set.subtract(config->GeneralBanSet).subtract(ban_set).toList();
 
     // shuffle them
-    qShuffle(all_generals);
+    qShuffle(all_generals, rng);
 
     QStringList general_list = all_generals.mid(0, count);
     Q_ASSERT(general_list.count() == count);
@@ -672,31 +804,27 @@ QStringList Engine::getRandomGenerals(int count, const QSet<QString> &ban_set) c
     return general_list;
 }
 
-QList<int> Engine::getRandomCards() const{
-    bool exclude_disaters = false;
-
-    if(Config.GameMode == "06_3v3")
-        exclude_disaters = Config.value("3v3/ExcludeDisasters", true).toBool();
-
-    if(Config.GameMode == "04_1v3")
-        exclude_disaters = true;
+QList<int> Engine::getRandomCards(RandomGenerator *rng, const RoomConfig *config) const{
+    QScopedPointer<const RoomConfig> snapshot;
+    config = CurrentConfig(config, snapshot);
 
     QList<int> list;
     foreach(Card *card, cards){
-        if(exclude_disaters && card->inherits("Disaster"))
+        if(config->ExcludeDisasters && card->inherits("Disaster"))
             continue;
 
-        if(!ban_package.contains(card->getPackage()))
+        if(!config->isBannedPackage(card->getPackage()))
             list << card->getId();
     }
 
-    qShuffle(list);
+    qShuffle(list, rng);
 
     return list;
 }
 
-QString Engine::getRandomGeneralName() const{
-    return generals.keys().at(qrand() % generals.size());
+QString Engine::getRandomGeneralName(RandomGenerator *rng) const{
+    int index = rng ? rng->bounded(generals.size()) : qrand() % generals.size();
+    return generals.keys().at(index);
 }
 
 void Engine::playAudio(const QString &name) const{
@@ -764,8 +892,8 @@ const ViewAsSkill *Engine::getViewAsSkill(const QString &skill_name) const{
 }
 
 const ProhibitSkill *Engine::isProhibited(const Player *from, const Player *to, const Card *card) const{
-    foreach(const ProhibitSkill *skill, prohibit_skills){
-        if(to->hasSkill(skill->objectName()) && skill->isProhibited(from, to, card))
+    foreach(const ProhibitSkill *skill, to->getProhibitSkills()){
+        if(skill->isProhibited(from, to, card))
             return skill;
     }
 
@@ -775,9 +903,27 @@ const ProhibitSkill *Engine::isProhibited(const Player *from, const Player *to,
 int Engine::correctDistance(const Player *from, const Player *to) const{
     int correct = 0;
 
-    foreach(const DistanceSkill *skill, distance_skills){
+    foreach(const DistanceSkill *skill, global_distance_skills)
         correct += skill->getCorrect(from, to);
+
+    QList<const DistanceSkill *> from_skills = from->getDistanceSkills();
+    foreach(const DistanceSkill *skill, from_skills)
+        correct += skill->getCorrect(from, to);
+
+    // a skill both players have is asked once, as it looks at both of them
+    int calls = global_distance_skills.length() + from_skills.length();
+    foreach(const DistanceSkill *skill, to->getDistanceSkills()){
+        if(!from_skills.contains(skill)){
+            correct += skill->getCorrect(from, to);
+            calls ++;
+        }
     }
 
+    correct_count.fetchAndAddRelaxed(calls);
+
     return correct;
 }
+
+int Engine::getCorrectCount() const{
+    return correct_count;
+}
@@ -6,14 +6,20 @@
 #include "skill.h"
 #include "package.h"
 #include "exppattern.h"
+#include "cardstring.h"
+#include "randomgenerator.h"
 
 #include <QHash>
 #include <QStringList>
 #include <QMetaObject>
+#include <QThreadStorage>
+#include <QCache>
+#include <QAtomicInt>
 
 class AI;
 class Scenario;
 class QLibrary;
+class RoomConfig;
 
 struct lua_State;
 
@@ -53,6 +59,9 @@ public:
     int getRoleIndex() const;
 
     const CardPattern *getPattern(const QString &name) const;
+    QStringList getPatternNames() const;
+    const CardDescriptor *getCardDescriptor(const QString &str) const;
+    int getCardClassId(const QMetaObject *meta) const;
     QList<const Skill *> getRelatedSkills(const QString &skill_name) const;
 
     QStringList getScenarioNames() const;
@@ -63,22 +72,27 @@ public:
     void addScenario(const QString &name);
 
     const General *getGeneral(const QString &name) const;
-    int getGeneralCount(bool include_banned = false) const;
+    int getGeneralCount(bool include_banned = false, const RoomConfig *config = NULL) const;
     const Skill *getSkill(const QString &skill_name) const;
     const TriggerSkill *getTriggerSkill(const QString &skill_name) const;
     const ViewAsSkill *getViewAsSkill(const QString &skill_name) const;
     QList<const DistanceSkill *> getDistanceSkills() const;
-    void addSkills(const QList<const Skill *> &skills);
+    QList<const DistanceSkill *> getOwnedDistanceSkills() const;
+    QList<const ProhibitSkill *> getProhibitSkills() const;
+    void addSkills(const QList<const Skill *> &skills, bool owned = false);
 
     int getCardCount() const;
     const Card *getCard(int index) const;
 
     QStringList getLords() const;
-    QStringList getRandomLords() const;
-    QStringList getRandomGenerals(int count, const QSet<QString> &ban_set = QSet<QString>()) const;
-    QList<int> getRandomCards() const;
-    QString getRandomGeneralName() const;
-    QStringList getLimitedGeneralNames() const;
+
+    // the rooms pass their own configuration, without one the current Config is taken
+    QStringList getRandomLords(RandomGenerator *rng = NULL, const RoomConfig *config = NULL) const;
+    QStringList getRandomGenerals(int count, const QSet<QString> &ban_set = QSet<QString>(), RandomGenerator *rng = NULL,
+                                  const RoomConfig *config = NULL) const;
+    QList<int> getRandomCards(RandomGenerator *rng = NULL, const RoomConfig *config = NULL) const;
+    QString getRandomGeneralName(RandomGenerator *rng = NULL) const;
+    QStringList getLimitedGeneralNames(const RoomConfig *config = NULL) const;
 
     void playAudio(const QString &name) const;
     void playEffect(const QString &filename) const;
@@ -87,19 +101,31 @@ public:
 
     const ProhibitSkill *isProhibited(const Player *from, const Player *to, const Card *card) const;
     int correctDistance(const Player *from, const Player *to) const;
+    int getCorrectCount() const;
 
 private:
     QHash<QString, QString> translations;
     QHash<QString, const General *> generals, hidden_generals;
     QHash<QString, const QMetaObject *> metaobjects;
+    QHash<const QMetaObject *, CardFactory> factories;
     QHash<QString, const Skill *> skills;
     QMap<QString, QString> modes;
     QMap<QString, const CardPattern *> patterns;
+    QHash<const QMetaObject *, int> class_ids;
+
+    // the compiled expressions, each thread has its own bounded cache
+    mutable QThreadStorage<QCache<QString, ExpPattern> *> pattern_caches;
+    mutable QThreadStorage<QCache<QString, CardDescriptor> *> card_string_caches;
+
+    // how many times DistanceSkill::getCorrect has been called, by every room
+    mutable QAtomicInt correct_count;
     QMultiMap<QString, QString> related_skills;
 
-    // special skills
+    // special skills, the distance skills of generals only matter when one of the two players has them,
+    // the others, such as the horses, apply to everyone
     QList<const ProhibitSkill *> prohibit_skills;
     QList<const DistanceSkill *> distance_skills;
+    QList<const DistanceSkill *> owned_distance_skills, global_distance_skills;
 
     QHash<QString, const Scenario *> scenarios;
 
@@ -114,11 +140,12 @@ private:
 
 extern Engine *Sanguosha;
 
+// the server passes the generator of the room, qrand is used otherwise
 template<typename T>
-void qShuffle(QList<T> &list){
+void qShuffle(QList<T> &list, RandomGenerator *rng = NULL){
     int i, n = list.length();
     for(i=0; i<n; i++){
-        int r = qrand() % (n - i) + i;
+        int r = (rng ? rng->bounded(n - i) : qrand() % (n - i)) + i;
         list.swap(i, r);
     }
 }
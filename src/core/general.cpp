@@ -74,14 +74,20 @@ void General::addSkill(Skill *skill){
     skill->setParent(this);
     skill->initMediaSource();
     skill_set << skill->objectName();
+    skill_ids.insert(Symbol::Intern(skill->objectName()));
 }
 
 void General::addSkill(const QString &skill_name){
     extra_set << skill_name;
+    skill_ids.insert(Symbol::Intern(skill_name));
 }
 
 bool General::hasSkill(const QString &skill_name) const{
-    return skill_set.contains(skill_name) || extra_set.contains(skill_name);
+    return skill_ids.contains(Symbol::Lookup(skill_name));
+}
+
+bool General::hasSkill(int skill_id) const{
+    return skill_ids.contains(skill_id);
 }
 
 QList<const Skill *> General::getVisibleSkillList() const{
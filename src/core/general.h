@@ -6,6 +6,8 @@ class TriggerSkill;
 class Package;
 class QSize;
 
+#include "symbol.h"
+
 #include <QObject>
 #include <QSet>
 #include <QMap>
@@ -42,6 +44,7 @@ public:
     void addSkill(Skill* skill);
     void addSkill(const QString &skill_name);
     bool hasSkill(const QString &skill_name) const;
+    bool hasSkill(int skill_id) const;
     QList<const Skill *> getVisibleSkillList() const;
     QSet<const Skill *> getVisibleSkills() const;
     QSet<const TriggerSkill *> getTriggerSkills() const;
@@ -64,6 +67,7 @@ private:
     bool lord;
     QSet<QString> skill_set;
     QSet<QString> extra_set;
+    SymbolSet skill_ids;
     bool hidden;
     bool never_shown;
 };
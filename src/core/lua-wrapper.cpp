@@ -1,4 +1,5 @@
 #include "lua-wrapper.h"
+#include "cardstring.h"
 
 LuaTriggerSkill::LuaTriggerSkill(const char *name, Frequency frequency)
     :TriggerSkill(name), on_trigger(0), can_trigger(0), priority(1)
@@ -18,6 +19,11 @@ int LuaTriggerSkill::getPriority() const{
     return priority;
 }
 
+bool LuaTriggerSkill::isGlobal() const{
+    // a custom can_trigger may accept players who do not own this skill
+    return can_trigger != 0;
+}
+
 LuaProhibitSkill::LuaProhibitSkill(const char *name)
     :ProhibitSkill(name), is_prohibited(0)
 {
@@ -78,30 +84,18 @@ void LuaSkillCard::setWillThrow(bool will_throw){
     this->will_throw = will_throw;;
 }
 
-LuaSkillCard *LuaSkillCard::Parse(const QString &str){
-    QRegExp rx("#(\\w+):(.*):(.*)");
-    if(!rx.exactMatch(str))
-        return NULL;
-
-    QStringList texts = rx.capturedTexts();
-    QString name = texts.at(1);
-    QString subcard_str = texts.at(2);
-    QString user_string = texts.at(3);
-
-    const LuaSkillCard *c = LuaSkillCards.value(name, NULL);
+LuaSkillCard *LuaSkillCard::Parse(const CardDescriptor &desc){
+    const LuaSkillCard *c = LuaSkillCards.value(desc.name, NULL);
     if(c == NULL)
         return NULL;
 
     LuaSkillCard *new_card = c->clone();
 
-    if(subcard_str != "."){
-        foreach(QString subcard, subcard_str.split("+")){
-            new_card->addSubcard(subcard.toInt());
-        }
-    }
+    foreach(int subcard, desc.subcards)
+        new_card->addSubcard(subcard);
 
-    new_card->setUserString(user_string);
-    new_card->setSkillName(name);
+    new_card->setUserString(desc.user_string);
+    new_card->setSkillName(desc.skill_name);
     return new_card;
 }
 
@@ -5,6 +5,19 @@
 
 typedef int LuaFunction;
 
+struct CardDescriptor;
+
+// how often the C++ side calls into a Lua state, and how many userdata it makes for the calls
+struct LuaCallCount{
+    int calls;
+    int userdata;
+    int cache_hits;
+};
+
+// these functions are defined at swig/luaskills.i
+LuaCallCount *GetLuaCallCount(lua_State *L);
+int LuaCall(lua_State *L, int nargs, int nresults);
+
 class LuaTriggerSkill: public TriggerSkill{
     Q_OBJECT
 
@@ -16,6 +29,7 @@ public:
     virtual int getPriority() const;
     virtual bool triggerable(const ServerPlayer *target) const;
     virtual bool trigger(TriggerEvent event, ServerPlayer *player, QVariant &data) const;
+    virtual bool isGlobal() const;
 
     LuaFunction on_trigger;
     LuaFunction can_trigger;
@@ -88,7 +102,7 @@ public:
     void setWillThrow(bool will_throw);
 
     // member functions that do not expose to Lua interpreter
-    static LuaSkillCard *Parse(const QString &str);
+    static LuaSkillCard *Parse(const CardDescriptor &desc);
     void pushSelf(lua_State *L) const;
 
     virtual QString toString() const;
@@ -0,0 +1,204 @@
+#include "luaprofiler.h"
+#include "lua.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+
+#include <cstring>
+
+static char LuaProfilerKey;
+
+LuaProfiler::LuaProfiler(lua_State *L, int period)
+    :L(L), period(qMax(period, 1)), last_sample(0), samples(0)
+{
+    lua_pushlightuserdata(L, &LuaProfilerKey);
+    lua_pushlightuserdata(L, this);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+
+    clock.start();
+    lua_sethook(L, Hook, LUA_MASKCALL | LUA_MASKCOUNT, this->period);
+}
+
+LuaProfiler::~LuaProfiler(){
+    lua_sethook(L, NULL, 0, 0);
+
+    lua_pushlightuserdata(L, &LuaProfilerKey);
+    lua_pushnil(L);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+}
+
+LuaProfiler *LuaProfiler::Get(lua_State *L){
+    if(lua_gethook(L) != Hook)
+        return NULL;
+
+    lua_pushlightuserdata(L, &LuaProfilerKey);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+    LuaProfiler *profiler = static_cast<LuaProfiler *>(lua_touserdata(L, -1));
+    lua_pop(L, 1);
+
+    return profiler;
+}
+
+void LuaProfiler::MarkEntry(lua_State *L, const char *entry){
+    LuaProfiler *profiler = Get(L);
+    if(profiler)
+        profiler->marked_entry = entry;
+}
+
+void LuaProfiler::enter(){
+    qint64 now = clock.nsecsElapsed();
+
+    // the time spent in C++ between two calls is not charged to the scripts
+    if(entry_stack.isEmpty())
+        last_sample = now;
+
+    entry_stack.push(marked_entry.isEmpty() ? QString("LuaCall") : marked_entry);
+    entry_start.push(now);
+    marked_entry.clear();
+}
+
+void LuaProfiler::leave(bool error){
+    if(entry_stack.isEmpty())
+        return;
+
+    Entry &entry = entries[entry_stack.pop()];
+    entry.calls ++;
+    entry.total += clock.nsecsElapsed() - entry_start.pop();
+    if(error)
+        entry.errors ++;
+}
+
+void LuaProfiler::Hook(lua_State *L, lua_Debug *ar){
+    LuaProfiler *profiler = Get(L);
+    if(profiler == NULL)
+        return;
+
+    if(ar->event == LUA_HOOKCOUNT)
+        profiler->sample(L);
+    else if(ar->event == LUA_HOOKCALL){
+        lua_getinfo(L, "S", ar);
+        if(strcmp(ar->what, "C") != 0)
+            profiler->function(L, ar).calls ++;
+    }
+}
+
+LuaProfiler::Function &LuaProfiler::function(lua_State *L, lua_Debug *ar){
+    // the source strings live as long as the functions, which is the whole game for the AI scripts
+    Function &function = functions[qMakePair(ar->source, ar->linedefined)];
+    if(!function.named){
+        lua_getinfo(L, "n", ar);
+
+        const char *name = ar->name;
+        if(name == NULL)
+            name = strcmp(ar->what, "main") == 0 ? "main" : "?";
+        else
+            function.named = true;
+
+        function.label = QString("%1@%2:%3").arg(name).arg(ar->short_src).arg(ar->linedefined);
+    }
+
+    return function;
+}
+
+void LuaProfiler::sample(lua_State *L){
+    qint64 now = clock.nsecsElapsed();
+    qint64 elapsed = now - last_sample;
+    last_sample = now;
+    samples ++;
+
+    // the stack is walked from the running function to the outermost one
+    QStringList frames;
+    QSet<FunctionKey> seen;
+    lua_Debug ar;
+    int level;
+    for(level=0; lua_getstack(L, level, &ar); level++){
+        lua_getinfo(L, "S", &ar);
+        if(strcmp(ar.what, "C") == 0)
+            continue;
+
+        Function &function = this->function(L, &ar);
+        if(frames.isEmpty())
+            function.self += elapsed;
+
+        // a recursive function is charged once per sample
+        FunctionKey key = qMakePair(ar.source, ar.linedefined);
+        if(!seen.contains(key)){
+            seen << key;
+            function.total += elapsed;
+        }
+
+        frames.prepend(function.label);
+    }
+
+    frames.prepend(entry_stack.isEmpty() ? QString("LuaCall") : entry_stack.top());
+    stacks[frames.join(";")] += elapsed;
+}
+
+bool LuaProfiler::dump(const QString &path) const{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QFile flat_file(path + ".txt");
+    QFile folded_file(path + ".folded");
+    if(!flat_file.open(QIODevice::WriteOnly | QIODevice::Text)
+        || !folded_file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream flat(&flat_file);
+    flat << QString("%1 samples, one every %2 instructions\n\n").arg(samples).arg(period);
+
+    QList<QPair<qint64, QString> > sorted;
+    QHashIterator<QString, Entry> entry_itor(entries);
+    while(entry_itor.hasNext()){
+        entry_itor.next();
+        sorted << qMakePair(entry_itor.value().total, entry_itor.key());
+    }
+    qSort(sorted.begin(), sorted.end(), qGreater<QPair<qint64, QString> >());
+
+    flat << QString("%1 %2 %3 %4 %5\n").arg("entry point", -32).arg("calls", 8).arg("errors", 8)
+            .arg("total ms", 12).arg("average ms", 12);
+
+    typedef QPair<qint64, QString> Cost;
+    foreach(Cost cost, sorted){
+        const Entry &entry = entries[cost.second];
+        flat << QString("%1 %2 %3 %4 %5\n").arg(cost.second, -32).arg(entry.calls, 8).arg(entry.errors, 8)
+                .arg(entry.total / 1e6, 12, 'f', 1).arg(entry.total / 1e6 / qMax(entry.calls, 1), 12, 'f', 3);
+    }
+
+    // the same function may have been loaded more than once, such as a file run by dofile twice
+    QHash<QString, Function> merged;
+    foreach(const Function &function, functions){
+        Function &total = merged[function.label];
+        total.calls += function.calls;
+        total.self += function.self;
+        total.total += function.total;
+    }
+
+    sorted.clear();
+    QHashIterator<QString, Function> function_itor(merged);
+    while(function_itor.hasNext()){
+        function_itor.next();
+        sorted << qMakePair(function_itor.value().self, function_itor.key());
+    }
+    qSort(sorted.begin(), sorted.end(), qGreater<QPair<qint64, QString> >());
+
+    flat << QString("\n%1 %2 %3 %4\n").arg("self ms", 12).arg("total ms", 12).arg("calls", 10).arg("function");
+    foreach(Cost cost, sorted){
+        const Function &function = merged[cost.second];
+        flat << QString("%1 %2 %3 %4\n").arg(function.self / 1e6, 12, 'f', 1).arg(function.total / 1e6, 12, 'f', 1)
+                .arg(function.calls, 10).arg(cost.second);
+    }
+
+    // the weights of the collapsed stacks are in microseconds
+    QTextStream folded(&folded_file);
+    QHashIterator<QString, qint64> stack_itor(stacks);
+    while(stack_itor.hasNext()){
+        stack_itor.next();
+        if(stack_itor.value() >= 1000)
+            folded << stack_itor.key() << " " << stack_itor.value() / 1000 << "\n";
+    }
+
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef LUAPROFILER_H
+#define LUAPROFILER_H
+
+struct lua_State;
+struct lua_Debug;
+
+#include <QHash>
+#include <QPair>
+#include <QStack>
+#include <QStringList>
+#include <QElapsedTimer>
+
+// a sampling profiler for the scripts of a Lua state, built on lua_sethook: every period
+// instructions the Lua stack is sampled and the time since the last sample is charged to it,
+// the calls of the Lua functions are counted as well, see LuaProfiler and LuaProfilePeriod
+class LuaProfiler{
+public:
+    // the hook is set in the constructor and removed in the destructor
+    LuaProfiler(lua_State *L, int period);
+    ~LuaProfiler();
+
+    // the profiler attached to the state, if any, it costs nothing more than a check of
+    // lua_gethook while no profiler is attached
+    static LuaProfiler *Get(lua_State *L);
+
+    // names the entry point of the next call, LuaAI gives the name of its askFor* methods
+    static void MarkEntry(lua_State *L, const char *entry);
+
+    // around each call from C++ into Lua, see LuaCall
+    void enter();
+    void leave(bool error);
+
+    // writes the flat profile to path.txt and the collapsed stacks to path.folded,
+    // the latter is read by flamegraph.pl, returns false if either can not be written
+    bool dump(const QString &path) const;
+
+private:
+    typedef QPair<const char *, int> FunctionKey;
+
+    struct Function{
+        QString label;
+        bool named;
+        int calls;
+        qint64 self, total;
+    };
+
+    struct Entry{
+        int calls, errors;
+        qint64 total;
+    };
+
+    static void Hook(lua_State *L, lua_Debug *ar);
+
+    Function &function(lua_State *L, lua_Debug *ar);
+    void sample(lua_State *L);
+
+    lua_State *L;
+    int period;
+    QElapsedTimer clock;
+    qint64 last_sample;
+    int samples;
+
+    QHash<FunctionKey, Function> functions;
+    QHash<QString, qint64> stacks;
+    QHash<QString, Entry> entries;
+
+    QString marked_entry;
+    QStack<QString> entry_stack;
+    QStack<qint64> entry_start;
+};
+
+#endif // LUAPROFILER_H
@@ -4,13 +4,25 @@
 #include "client.h"
 #include "standard.h"
 #include "settings.h"
+#include "distancematrix.h"
+
+#include <QElapsedTimer>
+
+// the names looked up on every canSlash and distance check
+static const int Kongcheng = Symbol::Intern("kongcheng");
+static const int Paoxiao = Symbol::Intern("paoxiao");
+static const int Zhengfeng = Symbol::Intern("zhengfeng");
+static const int Juejing = Symbol::Intern("juejing");
+static const int Shenwei = Symbol::Intern("shenwei");
+static const int TianyiSuccess = Symbol::Intern("tianyi_success");
+static const int Qinggang = Symbol::Intern("qinggang");
 
 Player::Player(QObject *parent)
     :QObject(parent), owner(false), ready(false), general(NULL), general2(NULL),
     hp(-1), max_hp(-1), state("online"), seat(0), alive(true),
     phase(NotActive),
     weapon(NULL), armor(NULL), defensive_horse(NULL), offensive_horse(NULL),
-    face_up(true), chained(false)
+    face_up(true), chained(false), distance_matrix(NULL), skill_lists_dirty(true)
 {
 }
 
@@ -47,6 +59,7 @@ void Player::setReady(bool ready){
 void Player::setHp(int hp){
     if(hp <= max_hp && this->hp != hp){
         this->hp = hp;
+        invalidateDistances();
         emit state_changed();
     }
 }
@@ -67,6 +80,8 @@ void Player::setMaxHP(int max_hp){
     if(hp > max_hp)
         hp = max_hp;
 
+    invalidateDistances();
+
     emit state_changed();
 }
 
@@ -94,6 +109,7 @@ int Player::getSeat() const{
 
 void Player::setSeat(int seat){
     this->seat = seat;
+    invalidateDistances();
 }
 
 bool Player::isAlive() const{
@@ -106,6 +122,7 @@ bool Player::isDead() const{
 
 void Player::setAlive(bool alive){
     this->alive = alive;
+    invalidateDistances();
 }
 
 QString Player::getFlags() const{
@@ -122,26 +139,36 @@ void Player::setFlags(const QString &flag){
         QString copy = flag;
         copy.remove(unset_symbol);
         flags.remove(copy);
+        flag_ids.remove(Symbol::Lookup(copy));
     }else{
         flags.insert(flag);
+        flag_ids.insert(Symbol::Intern(flag));
     }
+
+    invalidateDistances();
 }
 
 bool Player::hasFlag(const QString &flag) const{
-    return flags.contains(flag);
+    return flag_ids.contains(Symbol::Lookup(flag));
+}
+
+bool Player::hasFlag(int flag_id) const{
+    return flag_ids.contains(flag_id);
 }
 
 void Player::clearFlags(){
     flags.clear();
+    flag_ids.clear();
+    invalidateDistances();
 }
 
 int Player::getAttackRange() const{
-    if(hasFlag("tianyi_success"))
+    if(hasFlag(TianyiSuccess))
         return 1000;
 
     if(weapon)
         return weapon->getRange();
-    else if(hasSkill("zhengfeng"))
+    else if(hasSkill(Zhengfeng))
         return hp;
     else
         return 1;
@@ -156,9 +183,69 @@ void Player::setFixedDistance(const Player *player, int distance){
         fixed_distance.remove(player);
     else
         fixed_distance.insert(player, distance);
+
+    invalidateDistances();
 }
 
 int Player::distanceTo(const Player *other) const{
+    if(distance_matrix && DistanceMatrix::IsEnabled())
+        return distance_matrix->distance(this, other);
+    else
+        return computeDistance(other);
+}
+
+DistanceMatrix *Player::getDistanceMatrix() const{
+    return distance_matrix;
+}
+
+void Player::setDistanceMatrix(DistanceMatrix *distance_matrix){
+    this->distance_matrix = distance_matrix;
+    invalidateDistances();
+}
+
+// anything a distance skill may look at goes through here when it changes
+void Player::invalidateDistances() const{
+    if(distance_matrix)
+        distance_matrix->invalidate();
+}
+
+QList<const ProhibitSkill *> Player::getProhibitSkills() const{
+    if(skill_lists_dirty)
+        updateSkillLists();
+
+    return prohibit_skills;
+}
+
+QList<const DistanceSkill *> Player::getDistanceSkills() const{
+    if(skill_lists_dirty)
+        updateSkillLists();
+
+    return distance_skills;
+}
+
+void Player::updateSkillLists() const{
+    prohibit_skills.clear();
+    foreach(const ProhibitSkill *skill, Sanguosha->getProhibitSkills()){
+        if(hasSkill(skill->objectName()))
+            prohibit_skills << skill;
+    }
+
+    distance_skills.clear();
+    foreach(const DistanceSkill *skill, Sanguosha->getOwnedDistanceSkills()){
+        if(hasSkill(skill->objectName()))
+            distance_skills << skill;
+    }
+
+    skill_lists_dirty = false;
+}
+
+// called when a general or an acquired skill changes, which is also what a transfiguration does
+void Player::skillsChanged(){
+    skill_lists_dirty = true;
+    invalidateDistances();
+}
+
+int Player::computeDistance(const Player *other) const{
     if(this == other)
         return 0;
 
@@ -181,6 +268,7 @@ int Player::distanceTo(const Player *other) const{
 void Player::setGeneral(const General *new_general){
     if(this->general != new_general){
         this->general = new_general;
+        skillsChanged();
 
         if(new_general && kingdom.isEmpty())
             setKingdom(new_general->getKingdom());
@@ -205,6 +293,7 @@ void Player::setGeneral2Name(const QString &general_name){
     const General *new_general = Sanguosha->getGeneral(general_name);
     if(general2 != new_general){
         general2 = new_general;
+        skillsChanged();
 
         emit general2_changed();
     }
@@ -274,15 +363,23 @@ bool Player::isLord() const{
 }
 
 bool Player::hasSkill(const QString &skill_name) const{
-    return hasInnateSkill(skill_name)
-            || acquired_skills.contains(skill_name);
+    return hasSkill(Symbol::Lookup(skill_name));
+}
+
+bool Player::hasSkill(int skill_id) const{
+    return hasInnateSkill(skill_id)
+            || acquired_skill_ids.contains(skill_id);
 }
 
 bool Player::hasInnateSkill(const QString &skill_name) const{
-    if(general && general->hasSkill(skill_name))
+    return hasInnateSkill(Symbol::Lookup(skill_name));
+}
+
+bool Player::hasInnateSkill(int skill_id) const{
+    if(general && general->hasSkill(skill_id))
         return true;
 
-    if(general2 && general2->hasSkill(skill_name))
+    if(general2 && general2->hasSkill(skill_id))
         return true;
 
     return false;
@@ -311,14 +408,20 @@ bool Player::hasLordSkill(const QString &skill_name) const{
 
 void Player::acquireSkill(const QString &skill_name){
     acquired_skills.insert(skill_name);
+    acquired_skill_ids.insert(Symbol::Intern(skill_name));
+    skillsChanged();
 }
 
 void Player::loseSkill(const QString &skill_name){
     acquired_skills.remove(skill_name);
+    acquired_skill_ids.remove(Symbol::Lookup(skill_name));
+    skillsChanged();
 }
 
 void Player::loseAllSkills(){
     acquired_skills.clear();
+    acquired_skill_ids.clear();
+    skillsChanged();
 }
 
 QString Player::getPhaseString() const{
@@ -357,6 +460,8 @@ void Player::setEquip(const EquipCard *card){
     case EquipCard::DefensiveHorseLocation: defensive_horse = qobject_cast<const Horse*>(card); break;
     case EquipCard::OffensiveHorseLocation: offensive_horse = qobject_cast<const Horse*>(card); break;
     }
+
+    invalidateDistances();
 }
 
 void Player::removeEquip(const EquipCard *equip){
@@ -366,6 +471,8 @@ void Player::removeEquip(const EquipCard *equip){
     case EquipCard::DefensiveHorseLocation: defensive_horse = NULL; break;
     case EquipCard::OffensiveHorseLocation:offensive_horse = NULL; break;
     }
+
+    invalidateDistances();
 }
 
 bool Player::hasEquip(const Card *card) const{
@@ -424,7 +531,7 @@ bool Player::hasWeapon(const QString &weapon_name) const{
 }
 
 bool Player::hasArmorEffect(const QString &armor_name) const{
-    return armor && getMark("qinggang") == 0 && armor->objectName() == armor_name;
+    return armor && getMark(Qinggang) == 0 && armor->objectName() == armor_name;
 }
 
 QList<const Card *> Player::getJudgingArea() const{
@@ -437,6 +544,7 @@ Player::Phase Player::getPhase() const{
 
 void Player::setPhase(Phase phase){
     this->phase = phase;
+    invalidateDistances();
 
     emit phase_changed();
 }
@@ -461,7 +569,7 @@ int Player::getMaxCards() const{
             extra = 1;
     }
 
-    int juejing = hasSkill("juejing") ? 2 : 0;
+    int juejing = hasSkill(Juejing) ? 2 : 0;
 
     int xueyi = 0;
     if(hasLordSkill("xueyi")){
@@ -473,7 +581,7 @@ int Player::getMaxCards() const{
     }
 
     int shenwei = 0;
-    if(hasSkill("shenwei"))
+    if(hasSkill(Shenwei))
         shenwei = 2;
 
     return qMax(hp,0) + extra + juejing + xueyi + shenwei;
@@ -573,15 +681,39 @@ void Player::removeMark(const QString &mark){
 void Player::setMark(const QString &mark, int value){
     if(marks[mark] != value){
         marks[mark] = value;
+
+        int id = Symbol::Intern(mark);
+        if(id >= mark_values.size()){
+            int i = mark_values.size();
+            mark_values.resize(Symbol::Count());
+            for(; i<mark_values.size(); i++)
+                mark_values[i] = 0;
+        }
+
+        mark_values[id] = value;
+        invalidateDistances();
     }
 }
 
 int Player::getMark(const QString &mark) const{
-    return marks.value(mark, 0);
+    return getMark(Symbol::Lookup(mark));
+}
+
+int Player::getMark(int mark_id) const{
+    if(mark_id < 0 || mark_id >= mark_values.size())
+        return 0;
+
+    return mark_values.at(mark_id);
+}
+
+void Player::clearMarks(){
+    marks.clear();
+    mark_values.clear();
+    invalidateDistances();
 }
 
 bool Player::canSlash(const Player *other, bool distance_limit) const{
-    if(other->hasSkill("kongcheng") && other->isKongcheng())
+    if(other->hasSkill(Kongcheng) && other->isKongcheng())
         return false;
 
     if(other == this)
@@ -705,11 +837,11 @@ bool Player::isProhibited(const Player *to, const Card *card) const{
 }
 
 bool Player::canSlashWithoutCrossbow() const{
-    if(hasSkill("paoxiao"))
+    if(hasSkill(Paoxiao))
         return true;
 
     int slash_count = getSlashCount();
-    if(hasFlag("tianyi_success"))
+    if(hasFlag(TianyiSuccess))
         return slash_count < 2;
     else
         return slash_count < 1;
@@ -767,6 +899,9 @@ void Player::copyFrom(Player* p)
     b->piles            = QMap<QString, QList<int> > (a->piles);
     b->acquired_skills  = QSet<QString> (a->acquired_skills);
     b->flags            = QSet<QString> (a->flags);
+    b->acquired_skill_ids = a->acquired_skill_ids;
+    b->flag_ids         = a->flag_ids;
+    b->mark_values      = a->mark_values;
     b->history          = QHash<QString, int> (a->history);
 
     b->hp               = a->hp;
@@ -789,6 +924,8 @@ void Player::copyFrom(Player* p)
     b->jilei_set        = QSet<Card::CardType> (a->jilei_set);
 
     b->tag              = QVariantMap(a->tag);
+
+    skillsChanged();
 }
 
 QList<const Player *> Player::getSiblings() const{
@@ -800,3 +937,96 @@ QList<const Player *> Player::getSiblings() const{
 
     return siblings;
 }
+
+// a player with nothing behind it, only used to time canSlash
+class BenchmarkPlayer: public Player{
+public:
+    BenchmarkPlayer(QObject *parent, int alive_count, int handcard_num)
+        :Player(parent), alive_count(alive_count), handcard_num(handcard_num)
+    {
+    }
+
+    virtual int aliveCount() const{ return alive_count; }
+    virtual QString getGameMode() const{ return "08p"; }
+    virtual int getHandcardNum() const{ return handcard_num; }
+    virtual void removeCard(const Card *, Place){}
+    virtual void addCard(const Card *, Place){}
+    virtual bool isLastHandCard(const Card *) const{ return false; }
+
+private:
+    int alive_count, handcard_num;
+};
+
+// canSlash as it was written before the symbol ids, every lookup goes through a name
+static bool CanSlashByName(const Player *from, const Player *to){
+    if(to->hasSkill("kongcheng") && to->isKongcheng())
+        return false;
+
+    if(to == from)
+        return false;
+
+    int range = 1;
+    if(from->hasFlag("tianyi_success"))
+        range = 1000;
+    else if(from->getWeapon())
+        range = from->getWeapon()->getRange();
+    else if(from->hasSkill("zhengfeng"))
+        range = from->getHp();
+
+    return from->distanceTo(to) <= range;
+}
+
+QString Player::BenchmarkCanSlash(int rounds){
+    QStringList general_names = Sanguosha->getLimitedGeneralNames();
+    if(general_names.isEmpty())
+        return "No general is found";
+
+    static const int count = 8;
+    QObject parent;
+    QList<Player *> players;
+    int i, j, r;
+    for(i=0; i<count; i++){
+        BenchmarkPlayer *player = new BenchmarkPlayer(&parent, count, i % 2 == 0 ? 0 : 4);
+        player->setSeat(i + 1);
+        player->setGeneralName(general_names.at(i % general_names.length()));
+        players << player;
+    }
+
+    // every general takes a turn in the first seat
+    QElapsedTimer timer;
+    int by_id = 0, by_name = 0;
+
+    timer.start();
+    for(r=0; r<rounds; r++){
+        players.first()->setGeneralName(general_names.at(r % general_names.length()));
+        for(i=0; i<count; i++){
+            for(j=0; j<count; j++){
+                if(players.at(i)->canSlash(players.at(j)))
+                    by_id ++;
+            }
+        }
+    }
+    qint64 id_msecs = timer.elapsed();
+
+    timer.start();
+    for(r=0; r<rounds; r++){
+        players.first()->setGeneralName(general_names.at(r % general_names.length()));
+        for(i=0; i<count; i++){
+            for(j=0; j<count; j++){
+                if(CanSlashByName(players.at(i), players.at(j)))
+                    by_name ++;
+            }
+        }
+    }
+    qint64 name_msecs = timer.elapsed();
+
+    qreal calls = qreal(rounds) * count * count;
+    QStringList report;
+    report << QString("%1 canSlash calls over %2 players, %3 symbols")
+              .arg(calls, 0, 'f', 0).arg(count).arg(Symbol::Count())
+           << QString("symbol ids: %1 ns/call").arg(id_msecs * 1e6 / calls, 0, 'f', 1)
+           << QString("names:      %1 ns/call").arg(name_msecs * 1e6 / calls, 0, 'f', 1)
+           << QString("results %1").arg(by_id == by_name ? "agree" : "differ");
+
+    return report.join("\n");
+}
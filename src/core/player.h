@@ -13,12 +13,16 @@ class Armor;
 class Horse;
 class DelayedTrick;
 class DistanceSkill;
+class ProhibitSkill;
 class TriggerSkill;
+class DistanceMatrix;
 
 class Player : public QObject
 {
     Q_OBJECT
 
+    friend class PlayerState;
+
     Q_PROPERTY(QString screenname READ screenName WRITE setScreenName)
     Q_PROPERTY(int hp READ getHp WRITE setHp)
     Q_PROPERTY(int maxhp READ getMaxHP WRITE setMaxHP)
@@ -113,6 +117,7 @@ public:
     QString getFlags() const;
     virtual void setFlags(const QString &flag);
     bool hasFlag(const QString &flag) const;
+    bool hasFlag(int flag_id) const;
     void clearFlags();
 
     bool faceUp() const;
@@ -121,6 +126,15 @@ public:
     virtual int aliveCount() const = 0;
     void setFixedDistance(const Player *player, int distance);
     int distanceTo(const Player *other) const;
+
+    // the distances are cached by the room, or by the client, which owns the matrix
+    DistanceMatrix *getDistanceMatrix() const;
+    void setDistanceMatrix(DistanceMatrix *distance_matrix);
+    void invalidateDistances() const;
+
+    // the prohibit and distance skills this player has, kept until the generals or skills change
+    QList<const ProhibitSkill *> getProhibitSkills() const;
+    QList<const DistanceSkill *> getDistanceSkills() const;
     const General *getAvatarGeneral() const;
     const General *getGeneral() const;
 
@@ -130,7 +144,9 @@ public:
     void loseSkill(const QString &skill_name);
     void loseAllSkills();
     bool hasSkill(const QString &skill_name) const;
+    bool hasSkill(int skill_id) const;
     bool hasInnateSkill(const QString &skill_name) const;
+    bool hasInnateSkill(int skill_id) const;
     bool hasLordSkill(const QString &skill_name) const;
     virtual QString getGameMode() const = 0;
 
@@ -168,6 +184,7 @@ public:
     void removeMark(const QString &mark);
     virtual void setMark(const QString &mark, int value);
     int getMark(const QString &mark) const;
+    int getMark(int mark_id) const;
 
     void setChained(bool chained);
     bool isChained() const;
@@ -202,6 +219,9 @@ public:
 
     QList<const Player *> getSiblings() const;
 
+    // times canSlash over every pair of players, through the symbol ids and through the names
+    static QString BenchmarkCanSlash(int rounds);
+
     QVariantMap tag;
 
 protected:
@@ -211,7 +231,25 @@ protected:
     QSet<QString> flags;
     QHash<QString, int> history;
 
+    void clearMarks();
+
 private:
+    friend class DistanceMatrix;
+    int computeDistance(const Player *other) const;
+
+    DistanceMatrix *distance_matrix;
+
+    mutable bool skill_lists_dirty;
+    mutable QList<const ProhibitSkill *> prohibit_skills;
+    mutable QList<const DistanceSkill *> distance_skills;
+    void updateSkillLists() const;
+    void skillsChanged();
+
+    // the same as acquired_skills, flags and marks, indexed by symbol id
+    SymbolSet acquired_skill_ids;
+    SymbolSet flag_ids;
+    QVector<int> mark_values;
+
     QString screen_name;
     bool owner;
     bool ready;
@@ -0,0 +1,68 @@
+#include "randomgenerator.h"
+
+#include <QDateTime>
+#include <QAtomicInt>
+
+static inline quint32 RotateLeft(quint32 x, int k){
+    return (x << k) | (x >> (32 - k));
+}
+
+// splitmix64, it turns any seed, even 0, into a well mixed state
+static quint64 SplitMix(quint64 &x){
+    quint64 z = (x += Q_UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+quint64 RandomGenerator::MakeSeed(){
+    // rooms created in the same millisecond still get different seeds
+    static QAtomicInt counter;
+    quint64 now = QDateTime::currentMSecsSinceEpoch();
+    return (now << 16) ^ quint64(counter.fetchAndAddRelaxed(1));
+}
+
+RandomGenerator::RandomGenerator(quint64 seed){
+    this->seed(seed);
+}
+
+void RandomGenerator::seed(quint64 seed){
+    initial_seed = seed;
+
+    quint64 x = seed;
+    quint64 a = SplitMix(x), b = SplitMix(x);
+    state[0] = quint32(a);
+    state[1] = quint32(a >> 32);
+    state[2] = quint32(b);
+    state[3] = quint32(b >> 32);
+}
+
+quint64 RandomGenerator::getSeed() const{
+    return initial_seed;
+}
+
+quint32 RandomGenerator::next(){
+    quint32 result = RotateLeft(state[1] * 5, 7) * 9;
+    quint32 t = state[1] << 9;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = RotateLeft(state[3], 11);
+
+    return result;
+}
+
+int RandomGenerator::bounded(int n){
+    if(n <= 0)
+        return 0;
+
+    // multiply and shift instead of modulo, it is faster and nearly unbiased
+    return int((quint64(next()) * quint32(n)) >> 32);
+}
+
+double RandomGenerator::real(){
+    return next() / 4294967296.0;
+}
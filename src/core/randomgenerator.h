@@ -0,0 +1,29 @@
+#ifndef RANDOMGENERATOR_H
+#define RANDOMGENERATOR_H
+
+#include <QtGlobal>
+
+// a small xoshiro128** generator, every room has its own one,
+// so that the same seed and the same replies give the same game
+class RandomGenerator{
+public:
+    static quint64 MakeSeed();
+
+    explicit RandomGenerator(quint64 seed = MakeSeed());
+    void seed(quint64 seed);
+    quint64 getSeed() const;
+
+    quint32 next();
+
+    // a number in [0, n), or 0 if n is not positive
+    int bounded(int n);
+
+    // a number in [0, 1)
+    double real();
+
+private:
+    quint64 initial_seed;
+    quint32 state[4];
+};
+
+#endif // RANDOMGENERATOR_H
@@ -0,0 +1,73 @@
+#include "roomconfig.h"
+#include "settings.h"
+
+static QSet<QString> BanList(const QString &key){
+    return Config.value(key).toStringList().toSet();
+}
+
+RoomConfig::RoomConfig(const QString &mode)
+    :GameMode(mode)
+{
+    BanPackages = Config.BanPackages.toSet();
+    ContestMode = Config.ContestMode;
+    FreeChoose = Config.FreeChoose;
+    FreeAssign = Config.value("FreeAssign", false).toBool();
+    FreeAssignSelf = Config.FreeAssignSelf;
+    // every player takes the general of the lord in 08same, there is no second general to choose
+    Enable2ndGeneral = Config.Enable2ndGeneral && mode != "08same";
+    EnableScene = Config.EnableScene;
+    EnableBasara = Config.EnableBasara;
+    EnableHegemony = Config.EnableHegemony;
+    EnableAI = Config.EnableAI;
+    AIDelay = Config.AIDelay;
+    MaxHpScheme = Config.MaxHpScheme;
+    MaxChoice = Config.value("MaxChoice", 5).toInt();
+    CountDownSeconds = Config.CountDownSeconds;
+    OperationTimeout = Config.OperationTimeout;
+    DeadlineGrace = Config.value("DeadlineGrace", 5000).toInt();
+    KeyframeInterval = qMax(Config.value("KeyframeInterval", 1).toInt(), 1);
+    ParallelNullification = Config.value("ParallelNullification", true).toBool();
+
+    if(EnableBasara)
+        GeneralBanSet.unite(BanList("Banlist/Basara"));
+    if(EnableHegemony)
+        GeneralBanSet.unite(BanList("Banlist/Hegemony"));
+    if(isRoleMode())
+        GeneralBanSet.unite(BanList("Banlist/Roles"));
+
+    if(EnableBasara)
+        ChoiceBanSet.unite(BanList("Banlist/Basara"));
+    if(mode == "zombie_mode")
+        ChoiceBanSet.unite(BanList("Banlist/Zombie"));
+    else if(isRoleMode())
+        ChoiceBanSet.unite(BanList("Banlist/Roles"));
+
+    if(mode == "02_1v1")
+        Ban1v1Set = BanList("Banlist/1v1");
+
+    if(mode == "06_3v3")
+        ExcludeDisasters = Config.value("3v3/ExcludeDisasters", true).toBool();
+    else
+        ExcludeDisasters = (mode == "04_1v3");
+
+    RoleChoose3v3 = Config.value("3v3/RoleChoose", "Normal").toString();
+    UsingExtension3v3 = Config.value("3v3/UsingExtension", false).toBool();
+    if(UsingExtension3v3)
+        ExtensionGenerals3v3 = Config.value("3v3/ExtensionGenerals").toStringList();
+}
+
+bool RoomConfig::isRoleMode() const{
+    return GameMode.endsWith("p") || GameMode.endsWith("pd");
+}
+
+bool RoomConfig::isBannedPackage(const QString &package) const{
+    return BanPackages.contains(package);
+}
+
+bool RoomConfig::isBannedGeneral(const QString &general) const{
+    return GeneralBanSet.contains(general);
+}
+
+bool RoomConfig::isBannedChoice(const QString &general) const{
+    return ChoiceBanSet.contains(general);
+}
@@ -0,0 +1,55 @@
+#ifndef ROOMCONFIG_H
+#define ROOMCONFIG_H
+
+#include <QString>
+#include <QStringList>
+#include <QSet>
+
+// the configuration a room plays with, taken from Config when the room is created,
+// so the hot paths read plain members instead of QSettings, and the rooms of one
+// server may play different modes at the same time
+class RoomConfig{
+public:
+    explicit RoomConfig(const QString &mode);
+
+    // the modes of roles, such as 08p and 08pd
+    bool isRoleMode() const;
+
+    bool isBannedPackage(const QString &package) const;
+
+    // by the ban lists of this mode, the ban pairs are left to BanPair
+    bool isBannedGeneral(const QString &general) const;
+    bool isBannedChoice(const QString &general) const;
+
+    QString GameMode;
+    QSet<QString> BanPackages;
+    bool ContestMode;
+    bool FreeChoose;
+    bool FreeAssign;
+    bool FreeAssignSelf;
+    bool Enable2ndGeneral;
+    bool EnableScene;
+    bool EnableBasara;
+    bool EnableHegemony;
+    bool EnableAI;
+    int AIDelay;
+    int MaxHpScheme;
+    int MaxChoice;
+    int CountDownSeconds;
+    int OperationTimeout;
+    int DeadlineGrace;
+    int KeyframeInterval;
+    bool ParallelNullification;
+
+    // the generals counted and drawn at random, and the lords and the generals robots choose
+    QSet<QString> GeneralBanSet;
+    QSet<QString> ChoiceBanSet;
+    QSet<QString> Ban1v1Set;
+
+    bool ExcludeDisasters;
+    QString RoleChoose3v3;
+    bool UsingExtension3v3;
+    QStringList ExtensionGenerals3v3;
+};
+
+#endif // ROOMCONFIG_H
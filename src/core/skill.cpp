@@ -191,7 +191,7 @@ FilterSkill::FilterSkill(const QString &name)
 }
 
 TriggerSkill::TriggerSkill(const QString &name)
-    :Skill(name), view_as_skill(NULL)
+    :Skill(name), view_as_skill(NULL), global(false)
 {
 
 }
@@ -217,10 +217,15 @@ bool TriggerSkill::triggerable(const ServerPlayer *target) const{
     return target->isAlive() && target->hasSkill(objectName());
 }
 
+bool TriggerSkill::isGlobal() const{
+    return global;
+}
+
 ScenarioRule::ScenarioRule(Scenario *scenario)
     :TriggerSkill(scenario->objectName())
 {
     setParent(scenario);
+    global = true;
 }
 
 int ScenarioRule::getPriority() const{
@@ -346,6 +351,7 @@ DistanceSkill::DistanceSkill(const QString &name)
 WeaponSkill::WeaponSkill(const QString &name)
     :TriggerSkill(name)
 {
+    global = true;
 }
 
 bool WeaponSkill::triggerable(const ServerPlayer *target) const{
@@ -355,7 +361,7 @@ bool WeaponSkill::triggerable(const ServerPlayer *target) const{
 ArmorSkill::ArmorSkill(const QString &name)
     :TriggerSkill(name)
 {
-
+    global = true;
 }
 
 bool ArmorSkill::triggerable(const ServerPlayer *target) const{
@@ -118,9 +118,14 @@ public:
     virtual bool triggerable(const ServerPlayer *target) const;
     virtual bool trigger(TriggerEvent event, ServerPlayer *player, QVariant &data) const = 0;
 
+    // a global skill may be triggered by players who do not own it,
+    // the room thread has to try it on every target
+    virtual bool isGlobal() const;
+
 protected:
     const ViewAsSkill *view_as_skill;
     QList<TriggerEvent> events;
+    bool global;
 };
 
 class Scenario;
@@ -0,0 +1,114 @@
+#include "symbol.h"
+
+#include <QHash>
+#include <QStringList>
+#include <QReadWriteLock>
+#include <QThreadStorage>
+#include <QAtomicInt>
+
+// flags and marks may be interned by several room threads at once
+static QReadWriteLock &SymbolLock(){
+    static QReadWriteLock lock;
+    return lock;
+}
+
+static QHash<QString, int> &SymbolIds(){
+    static QHash<QString, int> ids;
+    return ids;
+}
+
+static QStringList &SymbolNames(){
+    static QStringList names;
+    return names;
+}
+
+// the number of names, it is changed only under the write lock
+static QAtomicInt &SymbolCount(){
+    static QAtomicInt count;
+    return count;
+}
+
+// each thread looks up its own copy of the ids without a lock, the copy shares the data
+// of the table until a new name is interned, and it is taken again when a name is not
+// found in it while the table has grown since
+struct SymbolCache{
+    QHash<QString, int> ids;
+    int count;
+};
+
+// the statics of other files intern their names before main, so these are made on first use as well
+static QThreadStorage<SymbolCache *> &SymbolCaches(){
+    static QThreadStorage<SymbolCache *> caches;
+    return caches;
+}
+
+int Symbol::Intern(const QString &name){
+    int id = Lookup(name);
+    if(id != -1)
+        return id;
+
+    QWriteLocker locker(&SymbolLock());
+    id = SymbolIds().value(name, -1);
+    if(id == -1){
+        id = SymbolNames().length();
+        SymbolNames() << name;
+        SymbolIds().insert(name, id);
+        SymbolCount() = SymbolNames().length();
+    }
+
+    return id;
+}
+
+int Symbol::Lookup(const QString &name){
+    QThreadStorage<SymbolCache *> &caches = SymbolCaches();
+    if(!caches.hasLocalData()){
+        SymbolCache *cache = new SymbolCache;
+        cache->count = -1;
+        caches.setLocalData(cache);
+    }
+
+    SymbolCache *cache = caches.localData();
+    int id = cache->ids.value(name, -1);
+    if(id != -1 || cache->count == int(SymbolCount()))
+        return id;
+
+    QReadLocker locker(&SymbolLock());
+    cache->ids = SymbolIds();
+    cache->count = SymbolNames().length();
+
+    return cache->ids.value(name, -1);
+}
+
+QString Symbol::Name(int id){
+    QReadLocker locker(&SymbolLock());
+    return SymbolNames().value(id);
+}
+
+int Symbol::Count(){
+    return SymbolCount();
+}
+
+void SymbolSet::insert(int id){
+    if(id < 0)
+        return;
+
+    int index = id >> 5;
+    if(index >= words.size()){
+        int i = words.size();
+        words.resize(index + 1);
+        for(; i<words.size(); i++)
+            words[i] = 0;
+    }
+
+    words[index] |= 1u << (id & 31);
+}
+
+void SymbolSet::remove(int id){
+    int index = id >> 5;
+    if(id >= 0 && index < words.size())
+        words[index] &= ~(1u << (id & 31));
+}
+
+void SymbolSet::clear(){
+    words.clear();
+}
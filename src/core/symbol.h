@@ -0,0 +1,38 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <QString>
+#include <QVector>
+
+// names of skills, flags and marks turned into small integers,
+// the skills are interned by Engine when the packages are loaded
+class Symbol{
+public:
+    // returns the id of the name, a new one is given if the name is not known yet
+    static int Intern(const QString &name);
+
+    // returns -1 if the name has never been interned, the lookup reads a copy
+    // kept by the calling thread and takes no lock while that copy is up to date
+    static int Lookup(const QString &name);
+
+    static QString Name(int id);
+    static int Count();
+};
+
+// a set of symbol ids, stored as bits
+class SymbolSet{
+public:
+    void insert(int id);
+    void remove(int id);
+    void clear();
+
+    inline bool contains(int id) const{
+        int index = id >> 5;
+        return id >= 0 && index < words.size() && (words.at(index) & (1u << (id & 31)));
+    }
+
+private:
+    QVector<quint32> words;
+};
+
+#endif // SYMBOL_H
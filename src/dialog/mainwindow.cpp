@@ -3,13 +3,14 @@
 #include "roomscene.h"
 #include "server.h"
 #include "client.h"
+#include "recorder.h"
 #include "generaloverview.h"
 #include "cardoverview.h"
 #include "ui_mainwindow.h"
 #include "scenario-overview.h"
 #include "window.h"
 #include "halldialog.h"
-#include "pixmapanimation.h"
+#include "assetloader.h"
 
 #include <cmath>
 #include <QGraphicsView>
@@ -252,7 +253,7 @@ void MainWindow::on_actionReplay_triggered()
     QString filename = QFileDialog::getOpenFileName(this,
                                                     tr("Select a reply file"),
                                                     location,
-                                                    tr("Pure text replay file (*.txt);; Image replay file (*.png)"));
+                                                    tr("Pure text replay file (*.txt);; Image replay file (*.png);; Streaming replay file (*.qsgs)"));
 
     if(filename.isEmpty())
         return;
@@ -263,6 +264,17 @@ void MainWindow::on_actionReplay_triggered()
 
     Client *client = new Client(this, filename);
 
+    // a streaming replay with keyframes can start from a later turn
+    Replayer *replayer = client->getReplayer();
+    QList<int> turns = replayer->getKeyframeTurns();
+    if(!turns.isEmpty()){
+        bool ok;
+        int turn = QInputDialog::getInt(this, tr("Replay"), tr("Start from turn (0 means the beginning)"),
+                                        0, 0, turns.last(), 1, &ok);
+        if(ok && turn > 0)
+            replayer->seek(turn);
+    }
+
     connect(client, SIGNAL(server_connected()), SLOT(enterRoom()));
 
     client->signup();
@@ -274,51 +286,6 @@ void MainWindow::networkError(const QString &error_msg){
 }
 
 
-BackLoader::BackLoader(QObject * parent)
-    :QThread(parent)
-{
-}
-
-void BackLoader::run()
-{
-    QStringList emotions;
-    emotions << "peach"
-            << "analeptic"
-            << "chain"
-            << "damage"
-            << "fire_slash"
-            << "thunder_slash"
-            << "killer"
-            << "jink"
-            << "no-success"
-            << "slash_black"
-            << "slash_red"
-            << "success";
-
-    double total = 0;
-    foreach(QString emotion, emotions){
-        int n = PixmapAnimation::GetFrameCount(emotion);
-        total += n;
-    }
-
-    int loaded = 0;
-    foreach(QString emotion, emotions){
-        int n = PixmapAnimation::GetFrameCount(emotion);
-        for(int i=0; i<n; i++){
-            QString filename = QString("image/system/emotion/%1/%2.png").arg(emotion).arg(i);
-            PixmapAnimation::GetFrameFromCache(filename);
-
-            loaded ++;
-
-            double process = (loaded / total) * 100;
-            emit completed(static_cast<int>(process));
-        }
-    }
-
-    emit finished();
-}
-
-
 void MainWindow::enterRoom(){
     // add current ip to history
     if(!Config.HistoryIPs.contains(Config.HostAddress)){
@@ -330,10 +297,10 @@ void MainWindow::enterRoom(){
     QGraphicsScene *loading_scene = new QGraphicsScene;
     gotoScene(loading_scene);
 
-    BackLoader *loader = new BackLoader(this);
-    loader->start();
-
-    connect(loader,SIGNAL(completed(int)),this,SLOT(updateLoadingProgress(int)));
+    // the assets decoded for the last room are still cached, only the missing ones are loaded
+    AssetLoader *loader = AssetLoader::GetInstance();
+    connect(loader, SIGNAL(progress(int)), this, SLOT(updateLoadingProgress(int)), Qt::UniqueConnection);
+    loader->preload(AssetLoader::RoomAssets());
 
     ui->actionStart_Game->setEnabled(false);
     ui->actionStart_Server->setEnabled(false);
@@ -958,7 +925,6 @@ void MainWindow::on_actionAI_Melee_triggered()
     dialog->exec();
 }
 
-#include "recorder.h"
 
 void MainWindow::on_actionReplay_file_convert_triggered()
 {
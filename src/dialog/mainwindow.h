@@ -74,17 +74,6 @@ private:
     QList<RoomItem*> room_items;
 };
 
-class BackLoader: public QThread
-{
-    Q_OBJECT
-public:
-    BackLoader(QObject *parent =0 );
-signals:
-    void completed(int progress);
-protected:
-    virtual void run();
-};
-
 class AcknowledgementScene : public QGraphicsScene
 {
     Q_OBJECT
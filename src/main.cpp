@@ -11,6 +11,10 @@
 #include "banpair.h"
 #include "server.h"
 #include "audio.h"
+#include "roomscheduler.h"
+#include "simulator.h"
+#include "distancematrix.h"
+#include "benchmark.h"
 
 int main(int argc, char *argv[])
 {
@@ -18,7 +22,8 @@ int main(int argc, char *argv[])
     if(dir_name == "release" || dir_name == "debug")
         QDir::setCurrent("..");
 
-    if(argc > 1 && strcmp(argv[1], "-server") == 0)
+    if(argc > 1 && (strcmp(argv[1], "-server") == 0 || strcmp(argv[1], "-simulate") == 0
+                    || Benchmark::IsRequested(argc, argv)))
         new QCoreApplication(argc, argv);
     else
         new QApplication(argc, argv);
@@ -37,7 +42,53 @@ int main(int argc, char *argv[])
     Config.init();
     BanPair::loadBanPairs();
 
+    // the benchmarks print their reports and exit, see Benchmark
+    if(Benchmark::IsRequested(argc, argv))
+        return Benchmark::Run(qApp->arguments());
+
+    // -simulate N [--mode 08p] [--threads K] [--seed S] [--no-distance-cache] [--tasks] [--ramp] plays N robot-only games and prints the statistics
+    QStringList args = qApp->arguments();
+    if(args.contains("-simulate")){
+        int total = args.value(args.indexOf("-simulate") + 1).toInt();
+        QString mode = Config.GameMode;
+        int threads = QThread::idealThreadCount();
+        uint seed = 20120101;
+
+        if(args.contains("--mode"))
+            mode = args.value(args.indexOf("--mode") + 1);
+        if(args.contains("--threads"))
+            threads = args.value(args.indexOf("--threads") + 1).toInt();
+        if(args.contains("--seed"))
+            seed = args.value(args.indexOf("--seed") + 1).toUInt();
+        if(args.contains("--no-distance-cache"))
+            DistanceMatrix::SetEnabled(false);
+        if(args.contains("--tasks"))
+            RoomScheduler::SetEnabled(true);
+
+        if(total <= 0 || Sanguosha->getPlayerCount(mode) <= 0){
+            printf("Usage: -simulate N [--mode 08p] [--threads K] [--seed S] [--no-distance-cache] [--tasks] [--ramp]\n");
+            return 1;
+        }
+
+        Config.GameMode = mode;
+        Config.AIDelay = 0;
+
+        Simulator *simulator = new Simulator(qApp, mode, total, threads, seed);
+
+        // with --ramp, N is the most games at once, compare the thread counts with and without --tasks
+        if(args.contains("--ramp"))
+            simulator->startRamp(total);
+        else
+            simulator->start();
+
+        return qApp->exec();
+    }
+
     if(qApp->arguments().contains("-server")){
+        // run the rooms as tasks on a few worker threads instead of two threads per room
+        if(qApp->arguments().contains("-tasks"))
+            RoomScheduler::SetEnabled(true);
+
         Server *server = new Server(qApp);
         printf("Server is starting on port %u\n", Config.ServerPort);
 
@@ -104,6 +104,7 @@ public:
     Lihun():TriggerSkill("lihun"){
         events << PhaseChange;
         view_as_skill = new LihunSelect;
+        global = true;
     }
 
     virtual int getPriority() const{
@@ -1,16 +1,29 @@
 #include <exppattern.h>
+#include "engine.h"
+#include "player.h"
+
+#include <QElapsedTimer>
+
+enum PlaceFlag{
+    HandPlace = 0x1,
+    EquippedPlace = 0x2
+};
+
+enum ColorFlag{
+    RedColor = 0x1,
+    BlackColor = 0x2
+};
+
+static const uint AllSuits = 0xFFFFFFFF;
+static const uint AllPlaces = HandPlace | EquippedPlace;
+static const uint AllColors = RedColor | BlackColor;
 
 ExpPattern::ExpPattern(const QString &exp)
 {
     this->exp = exp;
-}
 
-bool ExpPattern::match(const Player *player, const Card *card) const
-{
-    foreach(QString one_exp,this->exp.split('#'))
-        if(this->matchOne(player,card,one_exp))return true;
-
-    return false;
+    foreach(QString one_exp, exp.split('#'))
+        terms << Compile(one_exp);
 }
 
 // '|' means 'and', '#' means 'or'.
@@ -19,60 +32,290 @@ bool ExpPattern::match(const Player *player, const Card *card) const
 // 2nd patt means the card suit, and ',' means more than one options.
 // 3rd part means the card number, and ',' means more than one options,
 // the number uses '~' to make a scale for valid expressions
-bool ExpPattern::matchOne(const Player *player, const Card *card, QString exp) const
+ExpPattern::Term ExpPattern::Compile(const QString &exp)
 {
     QStringList factors = exp.split('|');
 
-    bool checkpoint = false;
-    QStringList card_types = factors.at(0).split(',');
-    foreach(QString name,card_types)
-        if(card->inherits(name.toLocal8Bit().data()) || name == ".")checkpoint = true;
-    if(!checkpoint)return false;
-    if(factors.size()<2)return true;
-
-    checkpoint = false;
-    QStringList card_suits = factors.at(1).split(',');
-    foreach(QString suit,card_suits)
-        if(card->getSuitString() == suit || suit == ".")checkpoint = true;
-    if(!checkpoint)return false;
-    if(factors.size()<3)return true;
-
-    checkpoint = false;
-    QStringList card_numbers = factors.at(2).split(',');
-    int cdn = card->getNumber();
-
-    foreach(QString number,card_numbers)
-    {
-        if(number.contains('~'))
-        {
-            QStringList params = number.split('~');
-            int from,to;
-            if(!params.at(0).size())from = 1;
-            else from = params.at(0).toInt();
-            if(!params.at(1).size())to = 13;
-            else to =params.at(1).toInt();
-
-            if(from<= cdn && cdn <= to)checkpoint = true;
+    Term term;
+    term.any_class = false;
+    term.suits = AllSuits;
+    term.any_number = true;
+    term.numbers = 0;
+    term.places = AllPlaces;
+    term.colors = AllColors;
+
+    foreach(QString name, factors.at(0).split(',')){
+        if(name == ".")
+            term.any_class = true;
+        else
+            term.class_names << name.toLocal8Bit();
+    }
+
+    if(factors.size() >= 2){
+        term.suits = 0;
+        foreach(QString suit, factors.at(1).split(',')){
+            if(suit == ".")
+                term.suits = AllSuits;
+
+            int i;
+            for(i=Card::Spade; i<=Card::NoSuit; i++){
+                if(Card::Suit2String(Card::Suit(i)) == suit)
+                    term.suits |= 1u << i;
+            }
+        }
+    }
+
+    if(factors.size() >= 3){
+        term.any_number = false;
+        foreach(QString number, factors.at(2).split(',')){
+            if(number.contains('~')){
+                QStringList params = number.split('~');
+                int from, to;
+                if(!params.at(0).size()) from = 1;
+                else from = params.at(0).toInt();
+                if(!params.at(1).size()) to = 13;
+                else to = params.at(1).toInt();
+
+                int n;
+                for(n=qMax(from, 0); n<=qMin(to, 31); n++)
+                    term.numbers |= 1u << n;
+            }else if(number == ".")
+                term.any_number = true;
+            else{
+                int n = number.toInt();
+                if(n >= 0 && n <= 31)
+                    term.numbers |= 1u << n;
+            }
+        }
+    }
+
+    if(factors.size() >= 4){
+        QString place = factors.at(3);
+        if(place == ".") term.places = AllPlaces;
+        else if(place == "equipped") term.places = EquippedPlace;
+        else if(place == "hand") term.places = HandPlace;
+        else term.places = 0;
+    }
+
+    if(factors.size() >= 5){
+        QString color = factors.at(4);
+        if(color == ".") term.colors = AllColors;
+        else if(color == "red") term.colors = RedColor;
+        else if(color == "black") term.colors = BlackColor;
+        else term.colors = 0;
+    }
+
+    return term;
+}
+
+bool ExpPattern::MatchClass(const Term &term, const Card *card)
+{
+    if(term.any_class)
+        return true;
+
+    const QMetaObject *meta = card->metaObject();
+    int class_id = Sanguosha->getCardClassId(meta);
+    if(class_id != -1 && term.known_classes.contains(class_id))
+        return term.matched_classes.contains(class_id);
+
+    // the inheritance is only walked the first time a class is met,
+    // or every time for a class that is not in any package, such as a card made by Lua
+    bool matched = false;
+    const QMetaObject *super = meta;
+    while(super){
+        if(term.class_names.contains(super->className())){
+            matched = true;
+            break;
+        }
+
+        super = super->superClass();
+    }
+
+    if(class_id != -1){
+        term.known_classes.insert(class_id);
+        if(matched)
+            term.matched_classes.insert(class_id);
+    }
+
+    return matched;
+}
+
+bool ExpPattern::match(const Player *player, const Card *card) const
+{
+    Q_UNUSED(player);
+
+    foreach(const Term &term, terms){
+        if(!MatchClass(term, card))
+            continue;
+
+        if(!(term.suits & (1u << card->getSuit())))
+            continue;
+
+        int number = card->getNumber();
+        if(!term.any_number && (number < 0 || number > 31 || !(term.numbers & (1u << number))))
+            continue;
+
+        if(term.places != AllPlaces){
+            uint place = card->isEquipped() ? EquippedPlace : HandPlace;
+            if(!(term.places & place))
+                continue;
+        }
+
+        if(term.colors != AllColors){
+            uint color = card->isRed() ? RedColor : (card->isBlack() ? BlackColor : 0);
+            if(!(term.colors & color))
+                continue;
         }
-        else if(number.toInt() == cdn)checkpoint = true;
-        else if(number == ".")checkpoint = true;
+
+        return true;
     }
-    if(!checkpoint)return false;
-    if(factors.size()<4)return true;
-
-    checkpoint = false;
-    QString place = factors.at(3);
-    if(place == ".")checkpoint = true;
-    else if(place == "equipped" && card->isEquipped())checkpoint = true;
-    else if(place == "hand" && !card->isEquipped())checkpoint = true;
-    if(!checkpoint)return false;
-    if(factors.size()<5)return true;
-
-    QString color = factors.at(4);
-    if(color == ".")return true;
-    else if (color == "red" && card->isRed())return true;
-    else if (color == "black" && card->isBlack())return true;
 
     return false;
+}
+
+// the matcher as it was before the compilation, every call splits the expression again
+static bool MatchByString(const Card *card, const QString &exp){
+    foreach(QString one_exp, exp.split('#')){
+        QStringList factors = one_exp.split('|');
+
+        bool checkpoint = false;
+        foreach(QString name, factors.at(0).split(','))
+            if(card->inherits(name.toLocal8Bit().data()) || name == ".") checkpoint = true;
+        if(!checkpoint) continue;
+        if(factors.size() < 2) return true;
+
+        checkpoint = false;
+        foreach(QString suit, factors.at(1).split(','))
+            if(card->getSuitString() == suit || suit == ".") checkpoint = true;
+        if(!checkpoint) continue;
+        if(factors.size() < 3) return true;
+
+        checkpoint = false;
+        int cdn = card->getNumber();
+        foreach(QString number, factors.at(2).split(',')){
+            if(number.contains('~')){
+                QStringList params = number.split('~');
+                int from = params.at(0).size() ? params.at(0).toInt() : 1;
+                int to = params.at(1).size() ? params.at(1).toInt() : 13;
+                if(from <= cdn && cdn <= to) checkpoint = true;
+            }
+            else if(number.toInt() == cdn) checkpoint = true;
+            else if(number == ".") checkpoint = true;
+        }
+        if(!checkpoint) continue;
+        if(factors.size() < 4) return true;
+
+        QString place = factors.at(3);
+        if(place != "." && !(place == "equipped" && card->isEquipped()) && !(place == "hand" && !card->isEquipped()))
+            continue;
+        if(factors.size() < 5) return true;
+
+        QString color = factors.at(4);
+        if(color == "." || (color == "red" && card->isRed()) || (color == "black" && card->isBlack()))
+            return true;
+    }
+
+    return false;
+}
+
+// a player without a room or a client, holding no cards, for the package patterns to look at
+class PatternBenchmarkPlayer: public Player{
+public:
+    PatternBenchmarkPlayer()
+        :Player(NULL)
+    {
+    }
+
+    virtual int aliveCount() const{ return 8; }
+    virtual QString getGameMode() const{ return "08p"; }
+    virtual int getHandcardNum() const{ return 0; }
+    virtual void removeCard(const Card *, Place){}
+    virtual void addCard(const Card *, Place){}
+    virtual bool isLastHandCard(const Card *) const{ return false; }
+};
+
+QString ExpPattern::Benchmark(int rounds)
+{
+    QList<const Card *> cards;
+    int i;
+    for(i=0; i<Sanguosha->getCardCount(); i++)
+        cards << Sanguosha->getCard(i);
+
+    // the patterns registered by the packages, they never go through the compiler
+    QList<const CardPattern *> package_patterns;
+    foreach(QString name, Sanguosha->getPatternNames())
+        package_patterns << Sanguosha->getPattern(name);
+
+    // the kinds of expressions the AI and the skills ask for, without the place filters,
+    // which look at Self and there is none when no client is running
+    QStringList expressions;
+    expressions << "Slash" << "Jink" << "Peach,Analeptic" << "TrickCard"
+                << ".|spade" << ".|heart,diamond" << ".|.|2~9" << ".|.|~5,J,13"
+                << ".|.|.|.|red"
+                << "BasicCard#TrickCard|club" << "Weapon,Armor|spade,club|1~13|.|black"
+                << "@guidao" << "..";
+
+    PatternBenchmarkPlayer player;
+
+    QElapsedTimer timer;
+    qint64 package_msecs, compiled_msecs, string_msecs;
+    int matched = 0, mismatched = 0, r;
+
+    timer.start();
+    for(r=0; r<rounds; r++){
+        foreach(const CardPattern *pattern, package_patterns){
+            foreach(const Card *card, cards){
+                if(pattern->match(&player, card))
+                    matched ++;
+            }
+        }
+    }
+    package_msecs = timer.elapsed();
+
+    QList<ExpPattern *> compiled;
+    foreach(QString expression, expressions)
+        compiled << new ExpPattern(expression);
+
+    timer.start();
+    for(r=0; r<rounds; r++){
+        foreach(ExpPattern *pattern, compiled){
+            foreach(const Card *card, cards){
+                if(pattern->match(NULL, card))
+                    matched ++;
+            }
+        }
+    }
+    compiled_msecs = timer.elapsed();
+
+    timer.start();
+    for(r=0; r<rounds; r++){
+        foreach(QString expression, expressions){
+            foreach(const Card *card, cards){
+                if(MatchByString(card, expression))
+                    matched ++;
+            }
+        }
+    }
+    string_msecs = timer.elapsed();
+
+    for(i=0; i<expressions.length(); i++){
+        foreach(const Card *card, cards){
+            if(compiled.at(i)->match(NULL, card) != MatchByString(card, expressions.at(i)))
+                mismatched ++;
+        }
+    }
+
+    qDeleteAll(compiled);
+
+    qreal package_calls = qreal(rounds) * package_patterns.length() * cards.length();
+    qreal exp_calls = qreal(rounds) * expressions.length() * cards.length();
+    QStringList report;
+    report << QString("%1 cards, %2 package patterns, %3 expressions, %4 rounds")
+              .arg(cards.length()).arg(package_patterns.length()).arg(expressions.length()).arg(rounds)
+           << QString("package patterns:     %1 ns/match").arg(package_msecs * 1e6 / qMax(package_calls, 1.0), 0, 'f', 1)
+           << QString("compiled expressions: %1 ns/match").arg(compiled_msecs * 1e6 / qMax(exp_calls, 1.0), 0, 'f', 1)
+           << QString("split expressions:    %1 ns/match").arg(string_msecs * 1e6 / qMax(exp_calls, 1.0), 0, 'f', 1)
+           << QString("%1 matches, %2 cards matched differently").arg(matched).arg(mismatched);
 
+    return report.join("\n");
 }
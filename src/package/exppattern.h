@@ -4,15 +4,37 @@
 #include <package.h>
 #include <card.h>
 #include <player.h>
+#include <symbol.h>
 
+// the expression is compiled once, matching a card only tests masks,
+// a pattern learns which classes match as it meets them, so it belongs to one thread
 class ExpPattern : public CardPattern
 {
 public:
     ExpPattern(const QString &exp);
     virtual bool match(const Player *player, const Card *card) const;
+
+    // matches every card against the patterns of the packages and some expressions
+    static QString Benchmark(int rounds);
+
 private:
+    // one of the expressions joined by '#'
+    struct Term{
+        bool any_class;
+        QList<QByteArray> class_names;
+        mutable SymbolSet known_classes, matched_classes;
+        uint suits;
+        bool any_number;
+        quint32 numbers;
+        uint places;
+        uint colors;
+    };
+
     QString exp;
-    bool matchOne(const Player *player,const Card *card, QString exp) const;
+    QList<Term> terms;
+
+    static Term Compile(const QString &exp);
+    static bool MatchClass(const Term &term, const Card *card);
 };
 
 #endif // EXPPATTERN_H
@@ -41,6 +41,7 @@ class WuhunRevenge: public TriggerSkill{
 public:
     WuhunRevenge():TriggerSkill("#wuhun"){
         events << Death;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -548,6 +549,7 @@ public:
     Wuqian():TriggerSkill("wuqian"){
         events << CardUsed << CardFinished << PhaseChange << Death;
         view_as_skill = new WuqianViewAsSkill;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -631,8 +633,8 @@ public:
         Room *room = shenzhuge->getRoom();
         room->fillAG(stars, shenzhuge);
 
-        int ai_delay = Config.AIDelay;
-        Config.AIDelay = 0;
+        // the stars are exchanged one by one without the delay of the robots
+        room->setProperty("no_delay", true);
 
         int n = 0;
         while(!stars.isEmpty()){
@@ -646,7 +648,7 @@ public:
             room->moveCardTo(Sanguosha->getCard(card_id), shenzhuge, Player::Hand, false);
         }
 
-        Config.AIDelay = ai_delay;
+        room->setProperty("no_delay", false);
 
         shenzhuge->invoke("clearAG");
 
@@ -754,6 +756,7 @@ public:
         view_as_skill = new KuangfengViewAsSkill;
 
         events << Predamaged;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -871,6 +874,7 @@ public:
         view_as_skill = new DawuViewAsSkill;
 
         events << Predamaged;
+        global = true;
     }
 
     virtual int getPriority() const{
@@ -930,6 +934,7 @@ class LianpoCount: public TriggerSkill{
 public:
     LianpoCount():TriggerSkill("#lianpo-count"){
         events << Death;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -1107,6 +1112,7 @@ public:
 class Lianpo: public PhaseChangeSkill{
 public:
     Lianpo():PhaseChangeSkill("lianpo"){
+        global = true;
     }
 
     virtual int getPriority() const{
@@ -1324,7 +1330,7 @@ GodPackage::GodPackage()
     addMetaObject<GreatYeyanCard>();
     addMetaObject<MediumYeyanCard>();
     addMetaObject<SmallYeyanCard>();
-    addMetaObject<WushenSlash>();
+    addCardMetaObject<WushenSlash>();
     addMetaObject<KuangfengCard>();
     addMetaObject<DawuCard>();
     addMetaObject<WuqianCard>();
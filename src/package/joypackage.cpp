@@ -255,6 +255,7 @@ class GrabPeach: public TriggerSkill{
 public:
     GrabPeach():TriggerSkill("grab_peach"){
         events << CardUsed;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *) const{
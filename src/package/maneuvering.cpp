@@ -441,6 +441,13 @@ ManeuveringPackage::ManeuveringPackage()
     foreach(Card *card, cards)
         card->setParent(this);
 
+    addCardFactory<ThunderSlash>();
+    addCardFactory<FireSlash>();
+    addCardFactory<Analeptic>();
+    addCardFactory<IronChain>();
+    addCardFactory<FireAttack>();
+    addCardFactory<SupplyShortage>();
+
     type = CardPack;
 }
 
@@ -149,6 +149,7 @@ class Beige: public TriggerSkill{
 public:
     Beige():TriggerSkill("beige"){
         events << Damaged;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -538,6 +539,7 @@ class SunceZhiba: public TriggerSkill{
 public:
     SunceZhiba():TriggerSkill("sunce_zhiba$"){
         events << GameStart << Pindian;
+        global = true;
     }
 
     virtual int getPriority() const{
@@ -700,6 +702,7 @@ class Guzheng: public TriggerSkill{
 public:
     Guzheng():TriggerSkill("guzheng"){
         events << CardDiscarded;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -731,7 +734,7 @@ public:
 class GuzhengGet: public PhaseChangeSkill{
 public:
     GuzhengGet():PhaseChangeSkill("#guzheng-get"){
-
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -878,6 +881,7 @@ class Ruoyu: public PhaseChangeSkill{
 public:
     Ruoyu():PhaseChangeSkill("ruoyu$"){
         frequency = Wake;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -2,9 +2,10 @@
 #define PACKAGE_H
 
 class Skill;
-class Card;
 class Player;
 
+#include "card.h"
+
 #include <QObject>
 #include <QHash>
 #include <QStringList>
@@ -40,6 +41,10 @@ public:
         return metaobjects;
     }
 
+    QHash<const QMetaObject *, CardFactory> getFactories() const{
+        return factories;
+    }
+
     QList<const Skill *> getSkills() const{
         return skills;
     }
@@ -59,10 +64,25 @@ public:
     template<typename T>
     void addMetaObject(){
         metaobjects << &T::staticMetaObject;
+        factories.insert(&T::staticMetaObject, &CreateSkillCard<T>);
+    }
+
+    // for the classes that are constructed with a suit and a number
+    template<typename T>
+    void addCardMetaObject(){
+        metaobjects << &T::staticMetaObject;
+        addCardFactory<T>();
+    }
+
+    // lets Engine::cloneCard make the cards of this class without reflection
+    template<typename T>
+    void addCardFactory(){
+        factories.insert(&T::staticMetaObject, &CreateCard<T>);
     }
 
 protected:
     QList<const QMetaObject *> metaobjects;
+    QHash<const QMetaObject *, CardFactory> factories;
     QList<const Skill *> skills;
     QMap<QString, const CardPattern *> patterns;
     QMultiMap<QString, QString> related_skills;
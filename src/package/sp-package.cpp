@@ -66,7 +66,7 @@ public:
 class JileiClear: public PhaseChangeSkill{
 public:
     JileiClear():PhaseChangeSkill("#jilei-clear"){
-
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -895,6 +895,7 @@ class IceSwordSkill: public TriggerSkill{
 public:
     IceSwordSkill():TriggerSkill("ice_sword"){
         events << SlashHit;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -1117,6 +1118,23 @@ StandardCardPackage::StandardCardPackage()
     foreach(Card *card, cards)
         card->setParent(this);
 
+    // the cards that the view-as skills and the AI clone most
+    addCardFactory<Slash>();
+    addCardFactory<Jink>();
+    addCardFactory<Peach>();
+    addCardFactory<AmazingGrace>();
+    addCardFactory<GodSalvation>();
+    addCardFactory<SavageAssault>();
+    addCardFactory<ArcheryAttack>();
+    addCardFactory<Duel>();
+    addCardFactory<ExNihilo>();
+    addCardFactory<Snatch>();
+    addCardFactory<Dismantlement>();
+    addCardFactory<Collateral>();
+    addCardFactory<Nullification>();
+    addCardFactory<Indulgence>();
+    addCardFactory<Lightning>();
+
     skills << new SpearSkill << new AxeViewAsSkill;
 }
 
@@ -33,6 +33,7 @@ public:
     Hujia():TriggerSkill("hujia$"){
         events << CardAsked;
         default_choice = "ignore";
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -300,6 +301,7 @@ class LuoyiBuff: public TriggerSkill{
 public:
     LuoyiBuff():TriggerSkill("#luoyi"){
         events << Predamage;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -478,6 +480,7 @@ public:
         default_choice = "ignore";
 
         view_as_skill = new JijiangViewAsSkill;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -740,6 +743,7 @@ public:
     Jiuyuan():TriggerSkill("jiuyuan$"){
         events << Dying << AskForPeachesDone << CardEffected;
         frequency = Compulsory;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
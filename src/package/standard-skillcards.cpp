@@ -4,7 +4,6 @@
 #include "clientplayer.h"
 #include "engine.h"
 #include "client.h"
-#include "settings.h"
 
 ZhihengCard::ZhihengCard(){
     target_fixed = true;
@@ -288,7 +287,7 @@ CheatCard::CheatCard(){
 }
 
 void CheatCard::use(Room *room, ServerPlayer *source, const QList<ServerPlayer *> &targets) const{
-    if(Config.FreeChoose)
+    if(room->getConfig().FreeChoose)
         room->obtainCard(source, subcards.first());
 }
 
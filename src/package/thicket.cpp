@@ -13,6 +13,7 @@ class Xingshang: public TriggerSkill{
 public:
     Xingshang():TriggerSkill("xingshang"){
         events << Death;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -107,6 +108,7 @@ class Songwei: public TriggerSkill{
 public:
     Songwei():TriggerSkill("songwei$"){
         events << FinishJudge;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -190,6 +192,7 @@ public:
     Huoshou():TriggerSkill("huoshou"){
         events << Predamage << CardEffected;
         frequency = Compulsory;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -308,6 +311,7 @@ class Juxiang: public TriggerSkill{
 public:
     Juxiang():TriggerSkill("juxiang"){
         events << CardFinished;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -724,6 +728,7 @@ public:
         events << SlashProceed;
 
         frequency = Compulsory;
+        global = true;
     }
 
     const Card *askForDoubleJink(ServerPlayer *player, const QString &reason) const{
@@ -832,6 +837,7 @@ class Baonue: public TriggerSkill{
 public:
     Baonue():TriggerSkill("baonue$"){
         events << Damage;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -378,6 +378,7 @@ public:
     Kuanggu():TriggerSkill("kuanggu"){
         frequency = Compulsory;
         events << Damage << DamageDone;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -57,6 +57,7 @@ class Juao: public PhaseChangeSkill{
 public:
     Juao():PhaseChangeSkill("juao"){
         view_as_skill = new JuaoViewAsSkill;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -126,6 +127,7 @@ public:
     Shicai():TriggerSkill("shicai"){
         events << Pindian;
         frequency = Compulsory;
+        global = true;
     }
 
     virtual int getPriority() const{
@@ -436,6 +438,7 @@ public:
         events << Dying;
         default_choice = "ignore";
         view_as_skill = new WeidaiViewAsSkill;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -489,6 +492,7 @@ class Fuzuo: public TriggerSkill{
 public:
     Fuzuo():TriggerSkill("fuzuo"){
         events << Pindian;
+        global = true;
     }
 
     virtual int getPriority() const{
@@ -606,6 +610,7 @@ public:
     Wenjiu():TriggerSkill("wenjiu"){
         events << Predamage << SlashProceed;
         frequency = Compulsory;
+        global = true;
     }
     virtual bool triggerable(const ServerPlayer *target) const{
         return true;
@@ -656,6 +661,7 @@ class Shipo: public TriggerSkill{
 public:
     Shipo():TriggerSkill("shipo"){
         events << PhaseChange;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -793,6 +799,7 @@ public:
     Jiehuo():TriggerSkill("jiehuo"){
         events << CardFinished;
         frequency = Wake;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -824,6 +831,7 @@ class Shien:public TriggerSkill{
 public:
     Shien():TriggerSkill("shien"){
         events << CardUsed << CardResponsed;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
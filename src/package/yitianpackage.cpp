@@ -504,6 +504,7 @@ class LianliSlash: public TriggerSkill{
 public:
     LianliSlash():TriggerSkill("#lianli-slash"){
         events << CardAsked;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -621,6 +622,7 @@ public:
 class Tongxin: public MasochismSkill{
 public:
     Tongxin():MasochismSkill("tongxin"){
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -719,6 +721,7 @@ class WulingExEffect: public TriggerSkill{
 public:
     WulingExEffect():TriggerSkill("#wuling-ex-effect"){
         events << CardEffected << Predamaged;
+        global = true;
     }
 
     virtual int getPriority() const{
@@ -770,6 +773,7 @@ class WulingEffect: public TriggerSkill{
 public:
     WulingEffect():TriggerSkill("#wuling-effect"){
         events << Predamaged;
+        global = true;
     }
 
     virtual int getPriority() const{
@@ -1057,6 +1061,7 @@ class Shaoying: public TriggerSkill{
 public:
     Shaoying():TriggerSkill("shaoying"){
         events << DamageComplete;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -1139,7 +1144,7 @@ public:
 class GongmouExchange:public PhaseChangeSkill{
 public:
     GongmouExchange():PhaseChangeSkill("#gongmou-exchange"){
-
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -1490,6 +1495,7 @@ class Zhenggong: public TriggerSkill{
 public:
     Zhenggong():TriggerSkill("zhenggong"){
         events << TurnStart;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -1708,6 +1714,7 @@ public:
         default_choice = "obtain";
 
         frequency = Frequent;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
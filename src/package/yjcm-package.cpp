@@ -46,6 +46,7 @@ public:
         events << CardDiscarded << CardUsed << FinishJudge;
         frequency = Frequent;
         default_choice = "no";
+        global = true;
     }
 
     virtual int getPriority() const{
@@ -180,6 +181,7 @@ public:
     Wuyan():TriggerSkill("wuyan"){
         events << CardEffect << CardEffected;
         frequency = Compulsory;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -696,6 +698,7 @@ class ZhichiClear: public TriggerSkill{
 public:
     ZhichiClear():TriggerSkill("#zhichi-clear"){
         events << PhaseChange;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -825,6 +828,7 @@ class Buyi: public TriggerSkill{
 public:
     Buyi():TriggerSkill("buyi"){
         events << Dying;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *player) const{
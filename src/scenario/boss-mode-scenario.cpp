@@ -6,7 +6,6 @@
 #include "carditem.h"
 #include "room.h"
 
-#include <QTime>
 
 class Silue: public PhaseChangeSkill{
 public:
@@ -69,6 +68,7 @@ class Jishi: public PhaseChangeSkill{
 public:
     Jishi():PhaseChangeSkill("jishi"){
         frequency = Compulsory;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -272,7 +272,6 @@ public:
 
     void getRandomSkill(ServerPlayer *player, bool need_trans = false) const{
         Room *room = player->getRoom();
-        qsrand(QTime(0,0,0).secsTo(QTime::currentTime()));
 
         QStringList all_generals = Sanguosha->getLimitedGeneralNames();
         QList<ServerPlayer *> players = room->getAllPlayers();
@@ -284,7 +283,7 @@ public:
             QString new_lord;
 
             do{
-                int seed = qrand() % all_generals.length();
+                int seed = room->getRandomGenerator()->bounded(all_generals.length());
                 new_lord = all_generals[seed];
             }while(boss_banlist.contains(new_lord));
 
@@ -311,7 +310,7 @@ public:
         do{
             int index;
             do{
-                index = qrand() % all_skills.length();
+                index = room->getRandomGenerator()->bounded(all_skills.length());
             }while(player->isLord() && boss_skillbanned.contains(all_skills[index]));
             got_skill = all_skills[index];
 
@@ -372,8 +371,7 @@ public:
                     removeLordSkill(player);
 
                     room->installEquip(player, "silver_lion");
-                    qsrand(QTime(0,0,0).secsTo(QTime::currentTime()));
-                    if((qrand() % 2) == 1){
+                    if(room->getRandomGenerator()->bounded(2) == 1){
                         room->acquireSkill(player, "silue");
                         room->acquireSkill(player, "kedi");
                     }
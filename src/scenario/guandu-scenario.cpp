@@ -121,6 +121,7 @@ class SmallTuxi:public PhaseChangeSkill{
 public:
     SmallTuxi():PhaseChangeSkill("smalltuxi"){
         view_as_skill = new SmallTuxiViewAsSkill;
+        global = true;
     }
 
     virtual bool triggerable(const ServerPlayer *target) const{
@@ -82,8 +82,9 @@ bool MiniSceneRule::trigger(TriggerEvent event, ServerPlayer *player, QVariant &
             {
                 QStringList available,all,existed;
                 existed = existedGenerals();
-                all = Sanguosha->getRandomGenerals(Sanguosha->getGeneralCount());
-                qShuffle(all);
+                const RoomConfig *config = &room->getConfig();
+                all = Sanguosha->getRandomGenerals(Sanguosha->getGeneralCount(false, config), QSet<QString>(),
+                                                   room->getRandomGenerator(), config);
                 for(int i=0;i<5;i++)
                 {
                     sp->setGeneral(NULL);
@@ -109,8 +110,9 @@ bool MiniSceneRule::trigger(TriggerEvent event, ServerPlayer *player, QVariant &
             {
                 QStringList available,all,existed;
                 existed = existedGenerals();
-                all = Sanguosha->getRandomGenerals(Sanguosha->getGeneralCount());
-                qShuffle(all);
+                const RoomConfig *config = &room->getConfig();
+                all = Sanguosha->getRandomGenerals(Sanguosha->getGeneralCount(false, config), QSet<QString>(),
+                                                   room->getRandomGenerator(), config);
                 for(int i=0;i<5;i++)
                 {
                     room->setPlayerProperty(sp,"general2", QVariant());
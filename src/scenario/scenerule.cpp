@@ -5,7 +5,6 @@
 #include "carditem.h"
 #include "scenerule.h"
 
-#include <QTime>
 
 class SceneDistanceEffect : public DistanceSkill {
 public:
@@ -38,7 +37,7 @@ public:
 
 class Scene26Effect : public TriggerSkill {
 public:
-    Scene26Effect(const QString &name) : TriggerSkill(name) { events << PhaseChange; }
+    Scene26Effect(const QString &name) : TriggerSkill(name) { events << PhaseChange; global = true; }
 
     virtual bool triggerable(const ServerPlayer *target) const {
         Q_UNUSED(target);
@@ -115,8 +114,6 @@ class Scene27Skill : public OneCardViewAsSkill {
 };
 
 SceneRule::SceneRule(QObject *parent) : GameRule(parent) {
-    qsrand(QTime(0,0,0).secsTo(QTime::currentTime()));
-
     events << CardEffect << Predamaged << Damaged;
 
     if(!Sanguosha->getSkill("#scene_dst_effect")) {
@@ -179,16 +176,18 @@ bool SceneRule::trigger(TriggerEvent event, ServerPlayer *player, QVariant &data
 
                 }
 
-                qsrand(QTime(0, 0).secsTo(QTime::currentTime()));
                 QList<int> bannedScenesList;
                 int nextSceneID;
                 bannedScenesList << 2 << 3 << 9 << 19 << 23 << 25 << 27 << 28 << 30;
                 do {
-                    nextSceneID = qrand() % 32 + 1;
+                    nextSceneID = room->getRandomGenerator()->bounded(32) + 1;
                 } while(bannedScenesList.indexOf(nextSceneID) != -1);
                 room->setTag("SceneID", room->getTag("NextSceneID").toInt());
                 room->setTag("NextSceneID", nextSceneID);
 
+                // the scenes 11 to 13 change the distances, see SceneDistanceEffect
+                room->getDistanceMatrix()->invalidate();
+
                 logMsg.type = "#SceneChanged";
                 logMsg.arg = QString("Scene%1").arg(room->getTag("SceneID").toInt());
                 logMsg.arg2 = QString("Scene%1Effect").arg(room->getTag("SceneID").toInt());
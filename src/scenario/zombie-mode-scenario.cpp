@@ -109,7 +109,7 @@ public:
                     player->gainMark("@round");
 
                     QList<ServerPlayer *> players = room->getOtherPlayers(player);
-                    qShuffle(players);
+                    qShuffle(players, room->getRandomGenerator());
 
                     bool hasZombie=false;
                     foreach(ServerPlayer *p,players)
@@ -353,7 +353,7 @@ ZombieScenario::ZombieScenario()
     zombie->addSkill("wansha");
 
     addMetaObject<PeachingCard>();
-    addMetaObject<GanranEquip>();
+    addCardMetaObject<GanranEquip>();
 }
 
 ADD_SCENARIO(Zombie)
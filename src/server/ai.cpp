@@ -2,11 +2,12 @@
 #include "serverplayer.h"
 #include "engine.h"
 #include "standard.h"
-#include "settings.h"
 #include "maneuvering.h"
 #include "lua.hpp"
 #include "scenario.h"
 #include "aux-skills.h"
+#include "lua-wrapper.h"
+#include "luaprofiler.h"
 
 AI::AI(ServerPlayer *player)
     :self(player)
@@ -132,7 +133,7 @@ AI::Relation AI::relationTo(const ServerPlayer *other) const{
         return GetRelation3v3(self, other);
     else if(room->getMode() == "08_boss")
         return GetRelationBoss(self, other);
-    else if(Config.EnableHegemony)
+    else if(room->getConfig().EnableHegemony)
         return GetRelationHegemony(self, other);
 
     return GetRelation(self, other);
@@ -221,7 +222,7 @@ bool TrustAI::useCard(const Card *card){
 }
 
 Card::Suit TrustAI::askForSuit(){
-    return Card::AllSuits[qrand() % 4];
+    return Card::AllSuits[room->getRandomGenerator()->bounded(4)];
 }
 
 QString TrustAI::askForKingdom(){
@@ -247,7 +248,7 @@ QString TrustAI::askForChoice(const QString &skill_name, const QString &choice){
         return skill->getDefaultChoice(self);
     else{
         QStringList choices = choice.split("+");
-        return choices.at(qrand() % choices.length());
+        return choices.at(room->getRandomGenerator()->bounded(choices.length()));
     }
 }
 
@@ -287,7 +288,7 @@ const Card *TrustAI::askForNullification(const TrickCard *trick, ServerPlayer *,
 
 int TrustAI::askForCardChosen(ServerPlayer *who, const QString &flags, const QString &) {
     QList<const Card *> cards = who->getCards(flags);
-    int r = qrand() % cards.length();
+    int r = room->getRandomGenerator()->bounded(cards.length());
     return cards.at(r)->getId();
 }
 
@@ -310,7 +311,7 @@ int TrustAI::askForAG(const QList<int> &card_ids, bool refusable, const QString
     if(refusable)
         return -1;
 
-    int r = qrand() % card_ids.length();
+    int r = room->getRandomGenerator()->bounded(card_ids.length());
     return card_ids.at(r);
 }
 
@@ -337,7 +338,7 @@ const Card *TrustAI::askForPindian(ServerPlayer *requestor, const QString &reaso
 }
 
 ServerPlayer *TrustAI::askForPlayerChosen(const QList<ServerPlayer *> &targets, const QString &reason){
-    int r = qrand() % targets.length();
+    int r = room->getRandomGenerator()->bounded(targets.length());
     return targets.at(r);
 }
 
@@ -412,15 +413,11 @@ QString LuaAI::askForUseCard(const QString &pattern, const QString &prompt){
 
     lua_State *L = room->getLuaState();
 
-    lua_rawgeti(L, LUA_REGISTRYINDEX, callback);
-
-    lua_pushstring(L, __func__);
-
+    pushCallback(L, __func__);
     lua_pushstring(L, pattern.toAscii());
-
     lua_pushstring(L, prompt.toAscii());
 
-    int error = lua_pcall(L, 3, 1, 0);
+    int error = LuaCall(L, 3, 1);
     const char *result = lua_tostring(L, -1);
     lua_pop(L, 1);
 
@@ -442,7 +439,7 @@ QList<int> LuaAI::askForDiscard(const QString &reason, int discard_num, bool opt
     lua_pushboolean(L, optional);
     lua_pushboolean(L, include_equip);
 
-    int error = lua_pcall(L, 5, 1, 0);
+    int error = LuaCall(L, 5, 1);
     if(error){
         reportError(L);
         return TrustAI::askForDiscard(reason, discard_num, optional, include_equip);
@@ -482,7 +479,7 @@ QString LuaAI::askForChoice(const QString &skill_name, const QString &choices){
     lua_pushstring(L, skill_name.toAscii());
     lua_pushstring(L, choices.toAscii());
 
-    int error = lua_pcall(L, 3, 1, 0);
+    int error = LuaCall(L, 3, 1);
     const char *result = lua_tostring(L, -1);
     lua_pop(L, 1);
     if(error){
@@ -501,7 +498,7 @@ int LuaAI::askForAG(const QList<int> &card_ids, bool refusable, const QString &r
     lua_pushboolean(L, refusable);
     lua_pushstring(L, reason.toAscii());
 
-    int error = lua_pcall(L, 4, 1, 0);
+    int error = LuaCall(L, 4, 1);
     if(error){
         reportError(L);
         return TrustAI::askForAG(card_ids, refusable, reason);
@@ -516,6 +513,8 @@ int LuaAI::askForAG(const QList<int> &card_ids, bool refusable, const QString &r
 void LuaAI::pushCallback(lua_State *L, const char *function_name){
     Q_ASSERT(callback);
 
+    LuaProfiler::MarkEntry(L, function_name);
+
     lua_rawgeti(L, LUA_REGISTRYINDEX, callback);
     lua_pushstring(L, function_name);
 }
@@ -543,7 +542,7 @@ void LuaAI::askForGuanxing(const QList<int> &cards, QList<int> &up, QList<int> &
     pushQIntList(L, cards);
     lua_pushboolean(L, up_only);
 
-    int error = lua_pcall(L, 3, 2, 0);
+    int error = LuaCall(L, 3, 2);
     if(error){
         reportError(L);
         return TrustAI::askForGuanxing(cards, up, bottom, up_only);
@@ -0,0 +1,133 @@
+#include "benchmark.h"
+#include "binaryprotocol.h"
+#include "player.h"
+#include "exppattern.h"
+#include "contestwriter.h"
+#include "cardstring.h"
+#include "engine.h"
+#include "lua.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+typedef QString (*BenchmarkFunction)(const QString &argument);
+
+struct BenchmarkEntry{
+    const char *name;
+    const char *usage;
+    BenchmarkFunction function;
+};
+
+static int Count(const QString &argument, int default_count){
+    int count = argument.isEmpty() ? default_count : argument.toInt();
+    return qMax(count, 1);
+}
+
+// compare the text and binary protocols on a recorded game
+static QString ProtocolBenchmark(const QString &argument){
+    if(argument.isEmpty())
+        return QString();
+
+    return BinaryProtocol::Benchmark(argument);
+}
+
+// time canSlash through the symbol ids and through the names
+static QString SlashBenchmark(const QString &argument){
+    return Player::BenchmarkCanSlash(Count(argument, 100000));
+}
+
+// match every card against the package patterns and compiled expressions
+static QString PatternBenchmark(const QString &argument){
+    return ExpPattern::Benchmark(Count(argument, 1000));
+}
+
+// write many contest results to a scratch database and time the commits
+static QString ContestBenchmark(const QString &argument){
+    return ContestWriter::Benchmark(Count(argument, 5000));
+}
+
+// parse card strings through the scanner and through the old regular expressions
+static QString ParseBenchmark(const QString &argument){
+    return CardDescriptor::Benchmark(Count(argument, 1000));
+}
+
+// copy the card lists in a fresh AI state by at() and by the native sgs.QList2Table
+static QString ListBenchmark(const QString &argument){
+    QString error_msg;
+    lua_State *L = Sanguosha->createLuaState(true, error_msg);
+    if(L == NULL)
+        return error_msg;
+
+    lua_getglobal(L, "sgs");
+    lua_getfield(L, -1, "benchmarkLists");
+    lua_pushinteger(L, Count(argument, 1000));
+
+    // the report on success and the error message otherwise
+    lua_pcall(L, 1, 1, 0);
+    QString report = lua_tostring(L, -1);
+
+    lua_close(L);
+    return report;
+}
+
+static const BenchmarkEntry BenchmarkEntries[] = {
+    {"protocol", "-benchmark:protocol:<replay.txt|replay.png>", ProtocolBenchmark},
+    {"slash", "-benchmark:slash[:rounds]", SlashBenchmark},
+    {"pattern", "-benchmark:pattern[:rounds]", PatternBenchmark},
+    {"contest", "-benchmark:contest[:count]", ContestBenchmark},
+    {"parse", "-benchmark:parse[:rounds]", ParseBenchmark},
+    {"lists", "-benchmark:lists[:rounds]", ListBenchmark},
+};
+
+static const int BenchmarkCount = sizeof(BenchmarkEntries) / sizeof(BenchmarkEntry);
+
+static void PrintUsage(){
+    printf("Usage:\n");
+
+    int i;
+    for(i=0; i<BenchmarkCount; i++)
+        printf("  %s\n", BenchmarkEntries[i].usage);
+}
+
+bool Benchmark::IsRequested(int argc, char *argv[]){
+    int i;
+    for(i=1; i<argc; i++){
+        if(strncmp(argv[i], "-benchmark", 10) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+int Benchmark::Run(const QStringList &arguments){
+    QString spec;
+    foreach(QString arg, arguments){
+        if(arg.startsWith("-benchmark")){
+            spec = arg.mid(11);
+            break;
+        }
+    }
+
+    QString name = spec.section(':', 0, 0);
+    QString argument = spec.section(':', 1);
+
+    int i;
+    for(i=0; i<BenchmarkCount; i++){
+        const BenchmarkEntry &entry = BenchmarkEntries[i];
+        if(name != entry.name)
+            continue;
+
+        // an empty report means the argument is missing
+        QString report = (*entry.function)(argument);
+        if(report.isEmpty()){
+            printf("Usage: %s\n", entry.usage);
+            return 1;
+        }
+
+        printf("%s\n", qPrintable(report));
+        return 0;
+    }
+
+    PrintUsage();
+    return name.isEmpty() ? 0 : 1;
+}
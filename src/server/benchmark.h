@@ -0,0 +1,18 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+
+// the benchmarks that are run from the command line as -benchmark:name or -benchmark:name:argument,
+// each one prints its report and the program exits, -benchmark alone lists them
+class Benchmark{
+public:
+    // the benchmarks need no window, so a QCoreApplication is enough for them
+    static bool IsRequested(int argc, char *argv[]);
+
+    // runs the benchmark named in the arguments and returns the exit code
+    static int Run(const QStringList &arguments);
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,91 @@
+#include "cardarena.h"
+#include "card.h"
+#include "room.h"
+#include "roomthread.h"
+#include "roomscheduler.h"
+
+#include <QMutexLocker>
+
+QAtomicInt CardArena::total_live(0);
+
+CardArena::CardArena()
+    :adopted(0), peak(0)
+{
+}
+
+CardArena::~CardArena(){
+    release();
+}
+
+CardArena *CardArena::Current(){
+    const QObject *owner = RoomScheduler::CurrentOwner();
+
+    const RoomThread *thread = qobject_cast<const RoomThread *>(owner);
+    if(thread)
+        return thread->getRoom()->getCardArena();
+
+    return NULL;
+}
+
+int CardArena::GetTotalLiveCount(){
+    return total_live;
+}
+
+void CardArena::adopt(Card *card){
+    QMutexLocker locker(&mutex);
+
+    if(card->arena)
+        return;
+
+    card->arena = this;
+    cards.insert(card);
+
+    adopted ++;
+    peak = qMax(peak, cards.size());
+    total_live.ref();
+}
+
+void CardArena::forget(Card *card){
+    QMutexLocker locker(&mutex);
+
+    if(cards.remove(card))
+        total_live.deref();
+
+    card->arena = NULL;
+}
+
+int CardArena::release(){
+    int count = 0;
+
+    // a card leaves the set in its destructor, together with the cards that are its children
+    forever{
+        mutex.lock();
+        if(cards.isEmpty()){
+            mutex.unlock();
+            break;
+        }
+
+        Card *card = *cards.begin();
+        mutex.unlock();
+
+        delete card;
+        count ++;
+    }
+
+    return count;
+}
+
+int CardArena::getLiveCount() const{
+    QMutexLocker locker(&mutex);
+    return cards.size();
+}
+
+int CardArena::getAdoptedCount() const{
+    QMutexLocker locker(&mutex);
+    return adopted;
+}
+
+int CardArena::getPeakCount() const{
+    QMutexLocker locker(&mutex);
+    return peak;
+}
@@ -0,0 +1,47 @@
+#ifndef CARDARENA_H
+#define CARDARENA_H
+
+class Card;
+
+#include <QSet>
+#include <QMutex>
+#include <QAtomicInt>
+
+// keeps the cards that the game flow of a room makes on the fly: the virtual cards of
+// the view-as skills, the cards parsed from the replies and the cards the AI clones,
+// the ones that nobody deletes are deleted when the room is done with them
+class CardArena{
+public:
+    CardArena();
+    ~CardArena();
+
+    // the arena of the room whose game flow runs in the current thread or task, NULL elsewhere
+    static CardArena *Current();
+    static int GetTotalLiveCount();
+
+    template<typename T>
+    static T *Adopt(T *card){
+        CardArena *arena = Current();
+        if(arena && card)
+            arena->adopt(card);
+
+        return card;
+    }
+
+    void adopt(Card *card);
+    void forget(Card *card);
+    int release();
+
+    int getLiveCount() const;
+    int getAdoptedCount() const;
+    int getPeakCount() const;
+
+private:
+    QSet<Card *> cards;
+    int adopted, peak;
+    mutable QMutex mutex;
+
+    static QAtomicInt total_live;
+};
+
+#endif // CARDARENA_H
@@ -0,0 +1,136 @@
+#include "cardpile.h"
+#include "engine.h"
+
+// prev_ids holds this for the cards that are not in the pile
+static const int NotInPile = -2;
+
+CardPile::CardPile()
+    :head(-1), tail(-1), count(0)
+{
+}
+
+CardPile::CardPile(const QList<int> &card_ids)
+    :head(-1), tail(-1), count(0)
+{
+    reset(card_ids);
+}
+
+void CardPile::reserve(int card_id){
+    int old_size = prev_ids.size();
+    int size = qMax(card_id + 1, Sanguosha->getCardCount());
+    if(size <= old_size)
+        return;
+
+    next_ids.resize(size);
+    prev_ids.resize(size);
+
+    int i;
+    for(i=old_size; i<size; i++)
+        prev_ids[i] = NotInPile;
+}
+
+void CardPile::reset(const QList<int> &card_ids){
+    next_ids.clear();
+    prev_ids.clear();
+    head = tail = -1;
+    count = 0;
+
+    foreach(int card_id, card_ids)
+        append(card_id);
+}
+
+void CardPile::clear(){
+    reset(QList<int>());
+}
+
+bool CardPile::isEmpty() const{
+    return count == 0;
+}
+
+int CardPile::length() const{
+    return count;
+}
+
+bool CardPile::contains(int card_id) const{
+    return card_id >= 0 && card_id < prev_ids.size() && prev_ids.at(card_id) != NotInPile;
+}
+
+int CardPile::first() const{
+    return head;
+}
+
+int CardPile::takeFirst(){
+    int card_id = head;
+    removeOne(card_id);
+    return card_id;
+}
+
+void CardPile::prepend(int card_id){
+    removeOne(card_id);
+    reserve(card_id);
+
+    prev_ids[card_id] = -1;
+    next_ids[card_id] = head;
+    if(head != -1)
+        prev_ids[head] = card_id;
+    else
+        tail = card_id;
+
+    head = card_id;
+    count++;
+}
+
+void CardPile::append(int card_id){
+    removeOne(card_id);
+    reserve(card_id);
+
+    prev_ids[card_id] = tail;
+    next_ids[card_id] = -1;
+    if(tail != -1)
+        next_ids[tail] = card_id;
+    else
+        head = card_id;
+
+    tail = card_id;
+    count++;
+}
+
+bool CardPile::removeOne(int card_id){
+    if(!contains(card_id))
+        return false;
+
+    int prev = prev_ids.at(card_id);
+    int next = next_ids.at(card_id);
+
+    if(prev != -1)
+        next_ids[prev] = next;
+    else
+        head = next;
+
+    if(next != -1)
+        prev_ids[next] = prev;
+    else
+        tail = prev;
+
+    prev_ids[card_id] = NotInPile;
+    count--;
+
+    return true;
+}
+
+void CardPile::shuffle(RandomGenerator *rng){
+    QList<int> card_ids = toList();
+    qShuffle(card_ids, rng);
+    reset(card_ids);
+}
+
+QList<int> CardPile::toList() const{
+    QList<int> card_ids;
+    int card_id = head;
+    while(card_id != -1){
+        card_ids << card_id;
+        card_id = next_ids.at(card_id);
+    }
+
+    return card_ids;
+}
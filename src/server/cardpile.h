@@ -0,0 +1,38 @@
+#ifndef CARDPILE_H
+#define CARDPILE_H
+
+class RandomGenerator;
+
+#include <QList>
+#include <QVector>
+
+// an ordered pile of card ids, linked through arrays indexed by card id,
+// so any card can be removed from it in constant time
+class CardPile{
+public:
+    CardPile();
+    CardPile(const QList<int> &card_ids);
+
+    void reset(const QList<int> &card_ids);
+    void clear();
+
+    bool isEmpty() const;
+    int length() const;
+    bool contains(int card_id) const;
+    int first() const;
+    int takeFirst();
+    void prepend(int card_id);
+    void append(int card_id);
+    bool removeOne(int card_id);
+    void shuffle(RandomGenerator *rng = NULL);
+
+    QList<int> toList() const;
+
+private:
+    QVector<int> next_ids, prev_ids;
+    int head, tail, count;
+
+    void reserve(int card_id);
+};
+
+#endif // CARDPILE_H
@@ -2,6 +2,7 @@
 #include "engine.h"
 #include "settings.h"
 #include "serverplayer.h"
+#include "contestwriter.h"
 #include "lua.hpp"
 
 #include <QSqlDatabase>
@@ -10,6 +11,7 @@
 #include <QMessageBox>
 #include <QCryptographicHash>
 #include <QDateTime>
+#include <QCoreApplication>
 
 const QString ContestDB::TimeFormat = "MMdd-hhmmss";
 
@@ -27,21 +29,10 @@ ContestDB::ContestDB(QObject *parent) :
     }
 
 
-    QSqlQuery query;
-    query.exec("CREATE TABLE IF NOT EXISTS results"
-               "(start_time TEXT PRIMARY KEY,"
-               "username TEXT,"
-               "general TEXT,"
-               "role TEXT,"
-               "score INTEGER,"
-               "victims TEXT,"
-               "alive INTEGER)");
-
-    QSqlQuery query2;
-    query2.exec("CREATE TABLE IF NOT EXISTS rooms"
-               "(start_time TEXT PROMARY KEY"
-               "end_time TEXT,"
-               "winner TEXT)");
+    // the results are written on another thread, so that the rooms do not wait for the disk
+    writer = new ContestWriter(filename, this);
+    writer->start();
+    connect(qApp, SIGNAL(aboutToQuit()), writer, SLOT(stop()));
 }
 
 ContestDB *ContestDB::GetInstance(){
@@ -85,50 +76,29 @@ bool ContestDB::checkPassword(const QString &username, const QString &password){
 
 void ContestDB::saveResult(const QList<ServerPlayer *> &players, const QString &winner){
     Room *room = players.first()->getRoom();
-    QString start_time = room->getTag("StartTime").toDateTime().toString(TimeFormat);
 
-    QSqlQuery query;
-    query.prepare("INSERT INTO results (start_time, username, general, role, score, victims, alive)"
-                  "VALUES (?, ?, ?, ?, ?, ?, ?)");
+    ContestResult result;
+    result.start_time = room->getTag("StartTime").toDateTime().toString(TimeFormat);
+    result.end_time = QDateTime::currentDateTime().toString(TimeFormat);
+    result.winner = winner;
 
-    QVariantList start_times, usernames, generals, roles, scores, victims, alives;
     foreach(ServerPlayer *player, players){
-        start_times << start_time;
-        usernames << player->screenName();
-        generals << player->getGeneralName();
-        roles << player->getRole();
-        scores << getScore(player, winner);
+        result.usernames << player->screenName();
+        result.generals << player->getGeneralName();
+        result.roles << player->getRole();
+        result.scores << getScore(player, winner);
 
         QStringList victim_list;
         foreach(ServerPlayer *victim, player->getVictims()){
             victim_list << victim->getGeneralName();
         }
 
-        victims << victim_list.join("+");
+        result.victims << victim_list.join("+");
 
-        alives << player->isAlive();
+        result.alives << player->isAlive();
     }
 
-    query.addBindValue(start_times);
-    query.addBindValue(usernames);
-    query.addBindValue(generals);
-    query.addBindValue(roles);
-    query.addBindValue(scores);
-    query.addBindValue(victims);
-    query.addBindValue(alives);
-
-    if(!query.execBatch())
-        room->output(query.lastError().text());
-
-    QSqlQuery query2;
-    query2.prepare("INSERT INTO rooms (start_time, end_time, winner)"
-                   "VALUES (?, ?, ?)");
-    query2.addBindValue(start_time);
-    query2.addBindValue(QDateTime::currentDateTime().toString(TimeFormat));
-    query2.addBindValue(winner);
-
-    if(!query2.exec())
-        room->output(query2.lastError().text());
+    writer->submit(result);
 }
 
 int ContestDB::getScore(ServerPlayer *player, const QString &winner){
@@ -198,6 +168,9 @@ int ContestDB::getScore(ServerPlayer *player, const QString &winner){
 void ContestDB::sendResult(Room *room){
     QString start_time = room->getTag("StartTime").toDateTime().toString(TimeFormat);
 
+    // the script reads the result of this room back from the database
+    writer->flush();
+
     lua_State *L = room->getLuaState();
 
     int error = luaL_loadfile(L, "lua/tools/send-result.lua");
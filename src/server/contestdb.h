@@ -6,6 +6,7 @@
 
 class ServerPlayer;
 class Room;
+class ContestWriter;
 
 class ContestDB : public QObject
 {
@@ -24,6 +25,7 @@ private:
     explicit ContestDB(QObject *parent);
     int getScore(ServerPlayer *player, const QString &winner);
 
+    ContestWriter *writer;
 
     struct Member{
         QString password;
@@ -0,0 +1,317 @@
+#include "contestwriter.h"
+#include "settings.h"
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QFile>
+#include <QDir>
+
+ContestWriter::ContestWriter(const QString &filename, QObject *parent)
+    :QThread(parent), filename(filename), stopping(false),
+      submitted(0), written(0), dropped(0), transactions(0), max_batch(0),
+      latency_sum(0), latency_max(0), commit_msecs(0)
+{
+    batch_size = qMax(Config.value("Contest/BatchSize", 64).toInt(), 1);
+    clock.start();
+}
+
+ContestWriter::~ContestWriter(){
+    stop();
+}
+
+void ContestWriter::CreateTables(QSqlDatabase &db){
+    // every player of a game has a row in results, and two rooms may start in the same second,
+    // so start_time is a key of neither table
+    QSqlQuery query(db);
+    query.exec("CREATE TABLE IF NOT EXISTS results"
+               "(start_time TEXT,"
+               "username TEXT,"
+               "general TEXT,"
+               "role TEXT,"
+               "score INTEGER,"
+               "victims TEXT,"
+               "alive INTEGER)");
+
+    QSqlQuery query2(db);
+    query2.exec("CREATE TABLE IF NOT EXISTS rooms"
+               "(start_time TEXT,"
+               "end_time TEXT,"
+               "winner TEXT)");
+}
+
+QString ContestWriter::SynchronousMode(){
+    static QStringList modes;
+    if(modes.isEmpty())
+        modes << "OFF" << "NORMAL" << "FULL" << "EXTRA" << "0" << "1" << "2" << "3";
+
+    // the setting goes into the PRAGMA as it is, so only the known modes are taken
+    QString mode = Config.value("Contest/Synchronous", "NORMAL").toString().trimmed().toUpper();
+    if(modes.contains(mode))
+        return mode;
+
+    qWarning("Contest/Synchronous %s is not a synchronous mode, NORMAL is used", qPrintable(mode));
+    return "NORMAL";
+}
+
+void ContestWriter::submit(const ContestResult &result){
+    QMutexLocker locker(&mutex);
+
+    queue << result;
+    queue.last().submit_time = clock.elapsed();
+    submitted ++;
+
+    queue_ready.wakeOne();
+}
+
+void ContestWriter::flush(){
+    QMutexLocker locker(&mutex);
+
+    qint64 target = submitted;
+    while(written + dropped < target && isRunning())
+        committed.wait(&mutex, 1000);
+}
+
+void ContestWriter::stop(){
+    if(!isRunning())
+        return;
+
+    mutex.lock();
+    stopping = true;
+    queue_ready.wakeOne();
+    mutex.unlock();
+
+    // the queue is drained before the thread finishes
+    wait();
+}
+
+void ContestWriter::run(){
+    QString connection = QString("ContestWriter-%1").arg(quintptr(this));
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
+        db.setDatabaseName(filename);
+
+        if(db.open()){
+            // readers no longer block the writer, and a commit does not wait for every fsync
+            QSqlQuery pragma(db);
+            pragma.exec("PRAGMA journal_mode=WAL");
+            pragma.exec(QString("PRAGMA synchronous=%1").arg(SynchronousMode()));
+
+            CreateTables(db);
+        }else
+            qWarning("Contest database %s can not be opened: %s", qPrintable(filename), qPrintable(db.lastError().text()));
+
+        forever{
+            QList<ContestResult> batch;
+
+            mutex.lock();
+            while(queue.isEmpty() && !stopping)
+                queue_ready.wait(&mutex);
+
+            while(!queue.isEmpty() && batch.length() < batch_size)
+                batch << queue.takeFirst();
+            mutex.unlock();
+
+            if(batch.isEmpty())
+                break;
+
+            QElapsedTimer timer;
+            timer.start();
+
+            // the results are dropped when the database is not open, so that flush does not wait for ever
+            QList<ContestResult> done;
+            int commits = 0;
+            if(db.isOpen()){
+                if(write(db, batch)){
+                    done = batch;
+                    commits = 1;
+                }else if(batch.length() > 1){
+                    // one bad result or a passing error must not lose the results of the other rooms,
+                    // so they are written again one at a time
+                    foreach(const ContestResult &result, batch){
+                        QList<ContestResult> single;
+                        single << result;
+                        if(write(db, single))
+                            done << result;
+                    }
+
+                    commits = done.length();
+                }
+            }
+
+            if(done.length() < batch.length())
+                qWarning("%d contest results are dropped", batch.length() - done.length());
+
+            QMutexLocker locker(&mutex);
+            written += done.length();
+            dropped += batch.length() - done.length();
+            if(!done.isEmpty()){
+                transactions += commits;
+                max_batch = qMax(max_batch, done.length() / commits);
+                commit_msecs += timer.elapsed();
+
+                qint64 now = clock.elapsed();
+                foreach(const ContestResult &result, done){
+                    qint64 latency = now - result.submit_time;
+                    latency_sum += latency;
+                    latency_max = qMax(latency_max, latency);
+                }
+            }
+
+            committed.wakeAll();
+        }
+
+        db.close();
+    }
+
+    QSqlDatabase::removeDatabase(connection);
+
+    mutex.lock();
+    committed.wakeAll();
+    mutex.unlock();
+}
+
+bool ContestWriter::write(QSqlDatabase &db, const QList<ContestResult> &batch){
+    QVariantList start_times, usernames, generals, roles, scores, victims, alives;
+    QVariantList room_start_times, end_times, winners;
+
+    foreach(const ContestResult &result, batch){
+        int i;
+        for(i=0; i<result.usernames.length(); i++)
+            start_times << result.start_time;
+
+        usernames << result.usernames;
+        generals << result.generals;
+        roles << result.roles;
+        scores << result.scores;
+        victims << result.victims;
+        alives << result.alives;
+
+        room_start_times << result.start_time;
+        end_times << result.end_time;
+        winners << result.winner;
+    }
+
+    if(!db.transaction()){
+        qWarning("Contest database error: %s", qPrintable(db.lastError().text()));
+        return false;
+    }
+
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO results (start_time, username, general, role, score, victims, alive)"
+                  "VALUES (?, ?, ?, ?, ?, ?, ?)");
+
+    query.addBindValue(start_times);
+    query.addBindValue(usernames);
+    query.addBindValue(generals);
+    query.addBindValue(roles);
+    query.addBindValue(scores);
+    query.addBindValue(victims);
+    query.addBindValue(alives);
+
+    if(!query.execBatch()){
+        qWarning("Contest database error: %s", qPrintable(query.lastError().text()));
+        db.rollback();
+        return false;
+    }
+
+    QSqlQuery query2(db);
+    query2.prepare("INSERT INTO rooms (start_time, end_time, winner)"
+                   "VALUES (?, ?, ?)");
+    query2.addBindValue(room_start_times);
+    query2.addBindValue(end_times);
+    query2.addBindValue(winners);
+
+    if(!query2.execBatch()){
+        qWarning("Contest database error: %s", qPrintable(query2.lastError().text()));
+        db.rollback();
+        return false;
+    }
+
+    if(!db.commit()){
+        qWarning("Contest database error: %s", qPrintable(db.lastError().text()));
+        db.rollback();
+        return false;
+    }
+
+    return true;
+}
+
+QString ContestWriter::getStatistics() const{
+    QMutexLocker locker(&mutex);
+
+    int results = written;
+    QStringList report;
+    report << QString("%1 results in %2 transactions, %3 results per transaction at most, %4 results dropped")
+              .arg(results).arg(transactions).arg(max_batch).arg(dropped)
+           << QString("commit: %1 ms per transaction")
+              .arg(commit_msecs / qMax(double(transactions), 1.0), 0, 'f', 2)
+           << QString("latency: %1 ms on average, %2 ms at most")
+              .arg(latency_sum / qMax(double(results), 1.0), 0, 'f', 2).arg(latency_max);
+
+    return report.join("\n");
+}
+
+QString ContestWriter::Benchmark(int count){
+    QString filename = QDir::temp().filePath("qsanguosha-contest-benchmark.db");
+    QStringList files;
+    files << filename << filename + "-wal" << filename + "-shm";
+    foreach(QString file, files)
+        QFile::remove(file);
+
+    ContestWriter *writer = new ContestWriter(filename);
+    writer->start();
+
+    QStringList roles;
+    roles << "lord" << "loyalist" << "loyalist" << "rebel" << "rebel" << "rebel" << "rebel" << "renegade";
+
+    QDateTime start = QDateTime::currentDateTime();
+
+    // what a room pays at game over is the time to hand its result over
+    QElapsedTimer timer;
+    timer.start();
+
+    int i;
+    for(i=0; i<count; i++){
+        ContestResult result;
+        result.start_time = QString("%1-%2").arg(start.toString("MMdd-hhmmss")).arg(i);
+        result.end_time = start.toString("MMdd-hhmmss");
+        result.winner = "lord+loyalist";
+
+        int j;
+        for(j=0; j<roles.length(); j++){
+            result.usernames << QString("player%1").arg(j);
+            result.generals << "caocao";
+            result.roles << roles.at(j);
+            result.scores << j;
+            result.victims << QString();
+            result.alives << (j % 2 == 0);
+        }
+
+        writer->submit(result);
+    }
+
+    qint64 submit_msecs = timer.elapsed();
+
+    writer->flush();
+    qint64 total_msecs = qMax(timer.elapsed(), qint64(1));
+
+    QString statistics = writer->getStatistics();
+    delete writer;
+
+    foreach(QString file, files)
+        QFile::remove(file);
+
+    QStringList report;
+    report << QString("%1 results submitted in %2 ms, %3 us per result")
+              .arg(count).arg(submit_msecs).arg(submit_msecs * 1000.0 / qMax(count, 1), 0, 'f', 2)
+           << QString("all committed in %1 ms, %2 results per second")
+              .arg(total_msecs).arg(count * 1000.0 / total_msecs, 0, 'f', 1)
+           << statistics;
+
+    return report.join("\n");
+}
@@ -0,0 +1,65 @@
+#ifndef CONTESTWRITER_H
+#define CONTESTWRITER_H
+
+class QSqlDatabase;
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QVariantList>
+#include <QList>
+
+// the rows of one finished game, built by the room and written later
+struct ContestResult{
+    QString start_time, end_time, winner;
+    QVariantList usernames, generals, roles, scores, victims, alives;
+
+    qint64 submit_time;
+};
+
+// writes the contest results on its own thread and its own connection,
+// the results that pile up while a transaction commits go into the next one
+class ContestWriter : public QThread{
+    Q_OBJECT
+
+public:
+    explicit ContestWriter(const QString &filename, QObject *parent = 0);
+    ~ContestWriter();
+
+    void submit(const ContestResult &result);
+
+    // blocks until every result submitted before the call is committed
+    void flush();
+    QString getStatistics() const;
+
+    // submits many results at once and reports how long they take to be committed
+    static QString Benchmark(int count);
+
+public slots:
+    void stop();
+
+protected:
+    virtual void run();
+
+private:
+    QString filename;
+    int batch_size;
+
+    mutable QMutex mutex;
+    QWaitCondition queue_ready, committed;
+    QList<ContestResult> queue;
+    bool stopping;
+
+    QElapsedTimer clock;
+    // the results that could not be written are dropped, not counted as written
+    qint64 submitted, written, dropped;
+    int transactions, max_batch;
+    qint64 latency_sum, latency_max, commit_msecs;
+
+    static void CreateTables(QSqlDatabase &db);
+    static QString SynchronousMode();
+    bool write(QSqlDatabase &db, const QList<ContestResult> &batch);
+};
+
+#endif // CONTESTWRITER_H
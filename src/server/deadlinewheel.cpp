@@ -0,0 +1,153 @@
+#include "deadlinewheel.h"
+
+#include <QMutexLocker>
+#include <QStringList>
+
+DeadlineWheel *DeadlineWheel::GetInstance(){
+    static DeadlineWheel *wheel;
+    if(wheel == NULL)
+        wheel = new DeadlineWheel;
+
+    return wheel;
+}
+
+DeadlineWheel::DeadlineWheel()
+    :now(0), next_id(1)
+{
+    clock.start();
+}
+
+int DeadlineWheel::schedule(QObject *receiver, const char *method, int msecs){
+    QMutexLocker locker(&mutex);
+
+    // the ticks are not advanced while nothing is scheduled
+    if(places.isEmpty())
+        now = clock.elapsed() / TickMsecs;
+
+    Deadline deadline;
+    deadline.id = next_id ++;
+    deadline.expires = now + qMax((msecs + TickMsecs - 1) / TickMsecs, 1);
+    deadline.receiver = receiver;
+    deadline.method = method;
+    insert(deadline);
+
+    if(!isRunning())
+        start();
+
+    condition.wakeOne();
+
+    return deadline.id;
+}
+
+void DeadlineWheel::cancel(int id){
+    QMutexLocker locker(&mutex);
+
+    if(!places.contains(id))
+        return;
+
+    QPair<int, int> place = places.take(id);
+    QList<Deadline> &slot = wheel[place.first][place.second];
+
+    int i;
+    for(i=0; i<slot.length(); i++){
+        if(slot.at(i).id == id){
+            slot.removeAt(i);
+            break;
+        }
+    }
+}
+
+void DeadlineWheel::record(const QString &reply_func, qint64 latency, bool expired){
+    QMutexLocker locker(&mutex);
+
+    Latency &entry = latencies[reply_func];
+    entry.replies ++;
+    entry.total += latency;
+    entry.worst = qMax(entry.worst, latency);
+    if(expired)
+        entry.expired ++;
+}
+
+QString DeadlineWheel::getStatistics() const{
+    QMutexLocker locker(&mutex);
+
+    QStringList lines;
+    QHashIterator<QString, Latency> itor(latencies);
+    while(itor.hasNext()){
+        itor.next();
+
+        const Latency &entry = itor.value();
+        lines << QString("%1: %2 replies, %3 ms on average, %4 ms at most, %5 expired")
+                 .arg(itor.key()).arg(entry.replies).arg(entry.total / qMax(entry.replies, 1))
+                 .arg(entry.worst).arg(entry.expired);
+    }
+
+    lines.sort();
+    return lines.join("\n");
+}
+
+void DeadlineWheel::run(){
+    QMutexLocker locker(&mutex);
+
+    forever{
+        if(places.isEmpty())
+            condition.wait(&mutex);
+        else
+            condition.wait(&mutex, TickMsecs);
+
+        qint64 target = clock.elapsed() / TickMsecs;
+        while(now < target && !places.isEmpty())
+            advance();
+    }
+}
+
+void DeadlineWheel::insert(const Deadline &deadline){
+    Deadline entry = deadline;
+    qint64 delta = entry.expires - now;
+
+    int level;
+    if(delta < Slots)
+        level = 0;
+    else if(delta < Slots * Slots)
+        level = 1;
+    else{
+        level = 2;
+        entry.expires = qMin(entry.expires, now + Slots * Slots * Slots - 1);
+    }
+
+    int slot = (entry.expires >> (level * SlotBits)) & (Slots - 1);
+    wheel[level][slot] << entry;
+    places.insert(entry.id, qMakePair(level, slot));
+}
+
+void DeadlineWheel::cascade(int level){
+    int slot = (now >> (level * SlotBits)) & (Slots - 1);
+
+    QList<Deadline> deadlines = wheel[level][slot];
+    wheel[level][slot].clear();
+
+    foreach(Deadline deadline, deadlines)
+        insert(deadline);
+}
+
+void DeadlineWheel::advance(){
+    now ++;
+
+    // the upper levels are poured into the lower ones as each turn of a lower one completes
+    if((now & (Slots - 1)) == 0){
+        if(((now >> SlotBits) & (Slots - 1)) == 0)
+            cascade(2);
+
+        cascade(1);
+    }
+
+    QList<Deadline> &slot = wheel[0][now & (Slots - 1)];
+
+    // posted with the lock held, so a deadline is not posted once it has been cancelled
+    foreach(Deadline deadline, slot){
+        places.remove(deadline.id);
+        QMetaObject::invokeMethod(deadline.receiver, deadline.method, Qt::QueuedConnection, Q_ARG(int, deadline.id));
+    }
+
+    slot.clear();
+}
@@ -0,0 +1,70 @@
+#ifndef DEADLINEWHEEL_H
+#define DEADLINEWHEEL_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QPair>
+
+// the deadlines of all the rooms of a server, kept in a hierarchical timer wheel of three
+// levels with 64 slots each, so scheduling and cancelling cost the same for any number of rooms
+class DeadlineWheel : public QThread{
+    Q_OBJECT
+
+public:
+    static DeadlineWheel *GetInstance();
+
+    // the method of the receiver is invoked in its own thread with the id as its only argument,
+    // a call posted just before cancel still arrives, so the receiver checks the id
+    int schedule(QObject *receiver, const char *method, int msecs);
+    void cancel(int id);
+
+    // the latency of the replies and the deadlines that expired, by reply function
+    void record(const QString &reply_func, qint64 latency, bool expired);
+    QString getStatistics() const;
+
+protected:
+    virtual void run();
+
+private:
+    DeadlineWheel();
+
+    struct Deadline{
+        int id;
+        qint64 expires;
+        QObject *receiver;
+        const char *method;
+    };
+
+    struct Latency{
+        int replies, expired;
+        qint64 total, worst;
+    };
+
+    enum{
+        SlotBits = 6,
+        Slots = 1 << SlotBits,
+        Levels = 3,
+        TickMsecs = 100
+    };
+
+    void insert(const Deadline &deadline);
+    void cascade(int level);
+    void advance();
+
+    QList<Deadline> wheel[Levels][Slots];
+    QHash<int, QPair<int, int> > places;
+    qint64 now;
+    int next_id;
+
+    QElapsedTimer clock;
+    mutable QMutex mutex;
+    QWaitCondition condition;
+
+    QHash<QString, Latency> latencies;
+};
+
+#endif // DEADLINEWHEEL_H
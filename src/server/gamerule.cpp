@@ -3,7 +3,6 @@
 #include "room.h"
 #include "standard.h"
 #include "engine.h"
-#include "settings.h"
 
 #include <QTime>
 
@@ -11,6 +10,7 @@ GameRule::GameRule(QObject *parent)
     :TriggerSkill("game_rule")
 {
     setParent(parent);
+    global = true;
 
     events << GameStart << TurnStart << PhaseChange << CardUsed
             << CardEffected << HpRecover << HpLost << AskForPeachesDone
@@ -178,6 +178,8 @@ bool GameRule::trigger(TriggerEvent event, ServerPlayer *player, QVariant &data)
 
     case TurnStart:{
             player = room->getCurrent();
+            room->setTag("TurnCount", room->getTag("TurnCount").toInt() + 1);
+            room->recordKeyframes();
             if(!player->faceUp())
                 player->turnOver();
             else if(player->isAlive())
@@ -596,7 +598,7 @@ QString GameRule::getWinner(ServerPlayer *victim) const{
         default:
             break;
         }
-    }else if(Config.EnableHegemony){
+    }else if(room->getConfig().EnableHegemony){
         bool has_anjiang = false, has_diff_kingdoms = false;
         QString init_kingdom;
         foreach(ServerPlayer *p, room->getAlivePlayers()){
@@ -620,7 +622,7 @@ QString GameRule::getWinner(ServerPlayer *victim) const{
                 if(p->getKingdom() == aliveKingdom)
                 {
                     QStringList generals = room->getTag(p->objectName()).toStringList();
-                    if(generals.size()&&!Config.Enable2ndGeneral)continue;
+                    if(generals.size()&&!room->getConfig().Enable2ndGeneral)continue;
                     if(generals.size()>1)continue;
 
                     //if someone showed his kingdom before death,
@@ -693,7 +695,7 @@ bool HulaoPassMode::trigger(TriggerEvent event, ServerPlayer *player, QVariant &
                 player->drawCards(player->getSeat() + 1, false);
 
             if(player->getGeneralName() == "zhangchunhua"){
-                if(qrand() % 3 == 0)
+                if(room->getRandomGenerator()->bounded(3) == 0)
                     room->killPlayer(player);
             }
 
@@ -827,7 +829,7 @@ void BasaraMode::playerShowed(ServerPlayer *player) const{
     if(names.isEmpty())
         return;
 
-    if(Config.EnableHegemony){
+    if(room->getConfig().EnableHegemony){
         QMap<QString, int> kingdom_roles;
         foreach(ServerPlayer *p, room->getOtherPlayers(player)){
             kingdom_roles[p->getKingdom()]++;
@@ -844,7 +846,7 @@ void BasaraMode::playerShowed(ServerPlayer *player) const{
         QString general_name = room->askForGeneral(player,names);
 
         generalShowed(player,general_name);
-        if(Config.EnableHegemony)room->getThread()->trigger(GameOverJudge, player);
+        if(room->getConfig().EnableHegemony)room->getThread()->trigger(GameOverJudge, player);
         playerShowed(player);
     }
 }
@@ -873,7 +875,7 @@ void BasaraMode::generalShowed(ServerPlayer *player, QString general_name) const
     }
 
     room->setPlayerProperty(player, "kingdom", player->getGeneral()->getKingdom());
-    if(Config.EnableHegemony)room->setPlayerProperty(player, "role", getMappedRole(player->getGeneral()->getKingdom()));
+    if(room->getConfig().EnableHegemony)room->setPlayerProperty(player, "role", getMappedRole(player->getGeneral()->getKingdom()));
 
     names.removeOne(general_name);
     room->setTag(player->objectName(),QVariant::fromValue(names));
@@ -896,7 +898,7 @@ bool BasaraMode::trigger(TriggerEvent event, ServerPlayer *player, QVariant &dat
     switch(event){
     case GameStart:{
         if(player->isLord()){
-            if(Config.EnableHegemony)
+            if(room->getConfig().EnableHegemony)
                 room->setTag("SkipNormalDeathProcess", true);
 
             foreach(ServerPlayer* sp, room->getAlivePlayers())
@@ -910,7 +912,7 @@ bool BasaraMode::trigger(TriggerEvent event, ServerPlayer *player, QVariant &dat
                 log.type = "#BasaraGeneralChosen";
                 log.arg = room->getTag(sp->objectName()).toStringList().at(0);
 
-                if(Config.Enable2ndGeneral)
+                if(room->getConfig().Enable2ndGeneral)
                 {
 
                     transfigure_str = QString("%1:%2").arg(sp->getGeneral2Name()).arg("anjiang");
@@ -963,11 +965,11 @@ bool BasaraMode::trigger(TriggerEvent event, ServerPlayer *player, QVariant &dat
         break;
     }
     case GameOverJudge:{
-        if(Config.EnableHegemony){
+        if(room->getConfig().EnableHegemony){
             if(player->getGeneralName() == "anjiang"){
                 QStringList generals = room->getTag(player->objectName()).toStringList();
                 room->setPlayerProperty(player, "general", generals.at(0));
-                if(Config.Enable2ndGeneral)room->setPlayerProperty(player, "general2", generals.at(1));
+                if(room->getConfig().Enable2ndGeneral)room->setPlayerProperty(player, "general2", generals.at(1));
                 room->setPlayerProperty(player, "kingdom", player->getGeneral()->getKingdom());
                 room->setPlayerProperty(player, "role", getMappedRole(player->getKingdom()));
             }
@@ -976,7 +978,7 @@ bool BasaraMode::trigger(TriggerEvent event, ServerPlayer *player, QVariant &dat
     }
 
     case Death:{
-        if(Config.EnableHegemony){
+        if(room->getConfig().EnableHegemony){
 
             DamageStar damage = data.value<DamageStar>();
             ServerPlayer *killer = damage ? damage->from : NULL;
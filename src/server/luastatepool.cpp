@@ -0,0 +1,109 @@
+#include "luastatepool.h"
+#include "engine.h"
+#include "settings.h"
+#include "lua.hpp"
+
+LuaStatePool::LuaStatePool(QObject *parent)
+    :QThread(parent), stopped(false)
+{
+    capacity = qMax(Config.value("LuaStatePoolSize", 2).toInt(), 0);
+}
+
+LuaStatePool::~LuaStatePool(){
+    stop();
+    wait();
+
+    foreach(lua_State *L, warm_states)
+        lua_close(L);
+
+    foreach(lua_State *L, used_states)
+        lua_close(L);
+}
+
+LuaStatePool *LuaStatePool::GetInstance(){
+    static LuaStatePool *pool;
+    if(pool == NULL){
+        pool = new LuaStatePool(Sanguosha);
+        pool->start(QThread::LowPriority);
+    }
+
+    return pool;
+}
+
+lua_State *LuaStatePool::createState(QString &error_msg){
+    // sanguosha.lua touches the engine, never run it twice at the same time
+    QMutexLocker locker(&creation_mutex);
+
+    return Sanguosha->createLuaState(true, error_msg);
+}
+
+lua_State *LuaStatePool::acquire(QString &error_msg){
+    mutex.lock();
+    if(!warm_states.isEmpty()){
+        lua_State *L = warm_states.takeFirst();
+        condition.wakeOne();
+        mutex.unlock();
+
+        return L;
+    }
+
+    mutex.unlock();
+
+    // the pool is still warming up, create one on the spot
+    return createState(error_msg);
+}
+
+void LuaStatePool::release(lua_State *L){
+    if(L == NULL)
+        return;
+
+    // the AI scripts keep per-game data in globals, so a used state
+    // is closed in the background and replaced by a fresh one
+    QMutexLocker locker(&mutex);
+    used_states << L;
+    condition.wakeOne();
+}
+
+void LuaStatePool::stop(){
+    QMutexLocker locker(&mutex);
+    stopped = true;
+    condition.wakeOne();
+}
+
+int LuaStatePool::getWarmCount() const{
+    QMutexLocker locker(&mutex);
+    return warm_states.length();
+}
+
+void LuaStatePool::run(){
+    forever{
+        mutex.lock();
+        while(!stopped && used_states.isEmpty()
+              && (warm_states.length() >= capacity || !error_msg.isEmpty()))
+            condition.wait(&mutex);
+
+        if(stopped){
+            mutex.unlock();
+            return;
+        }
+
+        QList<lua_State *> to_close = used_states;
+        used_states.clear();
+        bool need_more = warm_states.length() < capacity && error_msg.isEmpty();
+        mutex.unlock();
+
+        foreach(lua_State *L, to_close)
+            lua_close(L);
+
+        if(need_more){
+            QString error;
+            lua_State *L = createState(error);
+
+            QMutexLocker locker(&mutex);
+            if(L)
+                warm_states << L;
+            else
+                error_msg = error;
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef LUASTATEPOOL_H
+#define LUASTATEPOOL_H
+
+struct lua_State;
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QStringList>
+
+// keeps some Lua states with AI scripts loaded, so that creating a room
+// does not need to parse the scripts again
+class LuaStatePool : public QThread{
+    Q_OBJECT
+
+public:
+    static LuaStatePool *GetInstance();
+    ~LuaStatePool();
+
+    lua_State *acquire(QString &error_msg);
+    void release(lua_State *L);
+    void stop();
+    int getWarmCount() const;
+
+protected:
+    virtual void run();
+
+private:
+    explicit LuaStatePool(QObject *parent);
+    lua_State *createState(QString &error_msg);
+
+    int capacity;
+    bool stopped;
+    QString error_msg;
+    QList<lua_State *> warm_states;
+    QList<lua_State *> used_states;
+
+    mutable QMutex mutex;
+    QMutex creation_mutex;
+    QWaitCondition condition;
+};
+
+#endif // LUASTATEPOOL_H
@@ -12,6 +12,12 @@
 #include "roomthread1v1.h"
 #include "server.h"
 #include "generalselector.h"
+#include "luastatepool.h"
+#include "roomstate.h"
+#include "deadlinewheel.h"
+#include "lua-wrapper.h"
+#include "luaprofiler.h"
+#include "lua.hpp"
 
 #include <QStringList>
 #include <QMessageBox>
@@ -22,19 +28,35 @@
 #include <QDateTime>
 #include <QFile>
 #include <QTextStream>
+#include <cmath>
 
 Room::Room(QObject *parent, const QString &mode)
-    :QThread(parent), mode(mode), current(NULL), reply_player(NULL), pile1(Sanguosha->getRandomCards()),
+    :QThread(parent), mode(mode), config(mode), current(NULL), reply_player(NULL),
+      pile1(Sanguosha->getRandomCards(&rng, &config)),
       draw_pile(&pile1), discard_pile(&pile2),
       game_started(false), game_finished(false),
-      L(NULL), thread(NULL), thread_3v3(NULL), sem(new QSemaphore), provided(NULL), _virtual(false)
+      L(NULL), profiler(NULL), ai_dispatch(false), thread(NULL), thread_3v3(NULL), sem(new TaskSemaphore),
+      poll_waited(0), poll_sequential(0), deadline(0), deadline_expired(false),
+      place_table(Sanguosha->getCardCount()), owner_table(Sanguosha->getCardCount()),
+      provided(NULL), _virtual(false)
 {
+    poll.serial = 0;
+    poll.answered = false;
+
     player_count = Sanguosha->getPlayerCount(mode);
     scenario = Sanguosha->getScenario(mode);
 
     initCallbacks();
 }
 
+Room::~Room(){
+    // a game abandoned while waiting may still have its deadline scheduled
+    if(deadline)
+        DeadlineWheel::GetInstance()->cancel(deadline);
+
+    delete profiler;
+}
+
 void Room::initCallbacks(){
     // init callback table
     callbacks["useCardCommand"] = &Room::commonCommand;
@@ -71,12 +93,78 @@ void Room::initCallbacks(){
     callbacks["surrenderCommand"] = &Room::surrenderCommand;
 }
 
+// math.random of Lua 5.1, but it takes the numbers from the generator of the room
+static int RoomRandom(lua_State *L){
+    RandomGenerator *rng = static_cast<RandomGenerator *>(lua_touserdata(L, lua_upvalueindex(1)));
+    lua_Number r = rng->real();
+    switch(lua_gettop(L)){
+    case 0:{
+            lua_pushnumber(L, r);
+            break;
+        }
+
+    case 1:{
+            int u = luaL_checkint(L, 1);
+            luaL_argcheck(L, 1 <= u, 1, "interval is empty");
+            lua_pushnumber(L, floor(r * u) + 1);
+            break;
+        }
+
+    case 2:{
+            int l = luaL_checkint(L, 1);
+            int u = luaL_checkint(L, 2);
+            luaL_argcheck(L, l <= u, 2, "interval is empty");
+            lua_pushnumber(L, floor(r * (u - l + 1)) + l);
+            break;
+        }
+
+    default:
+        return luaL_error(L, "wrong number of arguments");
+    }
+
+    return 1;
+}
+
 QString Room::createLuaState(){
     QString error_msg;
-    L = Sanguosha->createLuaState(true, error_msg);
+    L = LuaStatePool::GetInstance()->acquire(error_msg);
+    if(L == NULL)
+        return error_msg;
+
+    // the AI scripts draw their random numbers from this room too
+    lua_getglobal(L, "math");
+    lua_pushlightuserdata(L, &rng);
+    lua_pushcclosure(L, RoomRandom, 1);
+    lua_setfield(L, -2, "random");
+    lua_pop(L, 1);
+
+    if(Config.value("LuaProfiler", false).toBool())
+        profiler = new LuaProfiler(L, Config.value("LuaProfilePeriod", 1000).toInt());
+
     return error_msg;
 }
 
+void Room::releaseLuaState(){
+    if(!game_finished)
+        return;
+
+    // the hook must be gone before the state goes back to the pool
+    delete profiler;
+    profiler = NULL;
+
+    LuaStatePool::GetInstance()->release(L);
+    L = NULL;
+}
+
+void Room::releaseCards(){
+    int made = card_arena.getAdoptedCount();
+    int peak = card_arena.getPeakCount();
+    int released = card_arena.release();
+
+    output(QString("cards: %1 transient cards made, %2 alive at most, %3 released at the end, %4 alive in all rooms")
+           .arg(made).arg(peak).arg(released).arg(CardArena::GetTotalLiveCount()));
+}
+
 ServerPlayer *Room::getCurrent() const{
     return current;
 }
@@ -172,7 +260,7 @@ void Room::enterDying(ServerPlayer *player, DamageStruct *reason){
     if(player->getGeneral()->isMale())
         sos_filename = "male-sos";
     else{
-        int r = qrand() % 2 + 1;
+        int r = rng.bounded(2) + 1;
         sos_filename = QString("female-sos%1").arg(r);
     }
     broadcastInvoke("playAudio", sos_filename);
@@ -228,7 +316,7 @@ void Room::updateStateItem(){
 
 void Room::killPlayer(ServerPlayer *victim, DamageStruct *reason){
     ServerPlayer *killer = reason ? reason->from : NULL;
-    if(Config.ContestMode && killer){
+    if(config.ContestMode && killer){
         killer->addVictim(victim);
     }
 
@@ -246,7 +334,7 @@ void Room::killPlayer(ServerPlayer *victim, DamageStruct *reason){
 
     LogMessage log;
     log.to << victim;
-    log.arg = Config.EnableHegemony ? victim->getKingdom() : victim->getRole();
+    log.arg = config.EnableHegemony ? victim->getKingdom() : victim->getRole();
     log.from = killer;
 
     updateStateItem();
@@ -274,7 +362,7 @@ void Room::killPlayer(ServerPlayer *victim, DamageStruct *reason){
     thread->trigger(Death, victim, data);
     victim->loseAllSkills();
 
-    if(Config.EnableAI){
+    if(config.EnableAI){
         bool expose_roles = true;
         foreach(ServerPlayer *player, alive_players){
             if(player->getState() != "robot" && player->getState() != "offline"){
@@ -285,7 +373,7 @@ void Room::killPlayer(ServerPlayer *victim, DamageStruct *reason){
 
         if(expose_roles){
             foreach(ServerPlayer *player, alive_players){
-                if(Config.EnableHegemony){
+                if(config.EnableHegemony){
                     QString role = player->getKingdom();
                     if(role == "god")
                         role = Sanguosha->getGeneral(getTag(player->objectName()).toStringList().at(0))->getKingdom();
@@ -354,7 +442,7 @@ void Room::gameOver(const QString &winner){
 
     game_finished = true;
 
-    if(Config.ContestMode){
+    if(config.ContestMode){
         foreach(ServerPlayer *player, players){
             QString screen_name = player->screenName().toUtf8().toBase64();
             broadcastInvoke("setScreenName", QString("%1:%2").arg(player->objectName()).arg(screen_name));
@@ -366,16 +454,55 @@ void Room::gameOver(const QString &winner){
 
     broadcastInvoke("gameOver", QString("%1:%2").arg(winner).arg(all_roles.join("+")));
 
+    if(Config.value("TriggerStatistics", false).toBool())
+        thread->outputTriggerStatistics();
+
+    if(Config.value("BroadcastStatistics", false).toBool()){
+        flushMessages();
+        outputBroadcastStatistics();
+    }
+
+    if(Config.value("NullificationStatistics", false).toBool())
+        outputPollStatistics();
+
+    if(Config.value("DeadlineStatistics", false).toBool())
+        output(DeadlineWheel::GetInstance()->getStatistics());
+
+    // the Lua state may be released before anyone asks, so the counts are kept as tags
+    if(L){
+        LuaCallCount *count = GetLuaCallCount(L);
+        tag["LuaCalls"] = count->calls;
+        tag["LuaUserdata"] = count->userdata;
+        tag["LuaCacheHits"] = count->cache_hits;
+
+        if(Config.value("LuaStatistics", false).toBool()){
+            output(QString("Lua: %1 calls, %2 userdata made, %3 reused")
+                   .arg(count->calls).arg(count->userdata).arg(count->cache_hits));
+        }
+
+        if(profiler){
+            QString path = QString("profiles/lua-%1-%2")
+                           .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"))
+                           .arg(quintptr(this), 0, 16);
+
+            if(profiler->dump(path))
+                output(QString("Lua profile: %1.txt, %1.folded").arg(path));
+            else
+                output(QString("Lua profile: can not write %1").arg(path));
+        }
+    }
+
     // save records
-    if(Config.ContestMode){
+    if(config.ContestMode){
         bool only_lord = Config.value("Contest/OnlySaveLordRecord", true).toBool();
         QString start_time = tag.value("StartTime").toDateTime().toString(ContestDB::TimeFormat);
+        QString format = Config.value("Contest/RecordFormat", "txt").toString();
 
         if(only_lord)
-            getLord()->saveRecord(QString("records/%1.txt").arg(start_time));
+            getLord()->saveRecord(QString("records/%1.%2").arg(start_time).arg(format));
         else{
             foreach(ServerPlayer *player, players){
-                QString filename = QString("records/%1-%2.txt").arg(start_time).arg(player->getGeneralName());
+                QString filename = QString("records/%1-%2.%3").arg(start_time).arg(player->getGeneralName()).arg(format);
                 player->saveRecord(filename);
             }
         }
@@ -406,7 +533,7 @@ void Room::gameOver(const QString &winner){
         if(playerWinner)
         {
 
-            QString id = Config.GameMode;
+            QString id = mode;
             id.replace("_mini_","");
             int stage = Config.value("MiniSceneStage",1).toInt();
             int current = id.toInt();
@@ -422,7 +549,7 @@ void Room::gameOver(const QString &winner){
     }
 
 
-    if(QThread::currentThread() == thread)
+    if(RoomScheduler::IsCurrent(thread))
         thread->end();
     else
         sem->release();
@@ -473,6 +600,7 @@ void Room::detachSkillFromPlayer(ServerPlayer *player, const QString &skill_name
         return;
 
     player->loseSkill(skill_name);
+    thread->updatePlayerSkills(player);
     broadcastInvoke("detachSkill",
                     QString("%1:%2").arg(player->objectName()).arg(skill_name));
 
@@ -505,7 +633,7 @@ bool Room::askForSkillInvoke(ServerPlayer *player, const QString &skill_name, co
     bool invoked;
     AI *ai = player->getAI();
     if(ai){
-        thread->delay(Config.AIDelay);
+        thread->delay(config.AIDelay);
         invoked = ai->askForSkillInvoke(skill_name, data);
     }else{
         QString invoke_str;
@@ -594,6 +722,28 @@ bool Room::isCanceled(const CardEffectStruct &effect){
 bool Room::askForNullification(const TrickCard *trick, ServerPlayer *from, ServerPlayer *to, bool positive){
     QString trick_name = trick->objectName();
     QList<ServerPlayer *> players = getAllPlayers();
+
+    QString ask_str;
+    if(positive)
+        ask_str = QString("%1:%2->%3").arg(trick_name)
+                .arg(from ? from->objectName() : ".")
+                .arg(to->objectName());
+    else
+        ask_str = QString("nullification:.->%1").arg(to->objectName());
+
+    // the humans are asked all at once, their replies are still taken in seat order below
+    QHash<ServerPlayer *, QString> replies;
+    if(config.ParallelNullification){
+        QList<ServerPlayer *> humans;
+        foreach(ServerPlayer *player, players){
+            if(player->hasNullification() && player->getAI() == NULL)
+                humans << player;
+        }
+
+        if(humans.length() > 1)
+            replies = pollNullification(trick_name, ask_str, humans);
+    }
+
     foreach(ServerPlayer *player, players){
         if(!player->hasNullification())
             continue;
@@ -604,19 +754,14 @@ trust:
         if(ai){
             card = ai->askForNullification(trick, from, to, positive);
             if(card)
-                thread->delay(Config.AIDelay);
+                thread->delay(config.AIDelay);
         }else{
-            QString ask_str;
-
-            if(positive)
-                ask_str = QString("%1:%2->%3").arg(trick_name)
-                        .arg(from ? from->objectName() : ".")
-                        .arg(to->objectName());
-            else
-                ask_str = QString("nullification:.->%1").arg(to->objectName());
-
-            player->invoke("askForNullification", ask_str);
-            getResult("responseCardCommand", player, false);
+            if(replies.contains(player))
+                result = replies.take(player);
+            else{
+                player->invoke("askForNullification", ask_str);
+                getResult("responseCardCommand", player, false);
+            }
 
             if(result.isEmpty())
                 goto trust;
@@ -658,6 +803,105 @@ trust:
     return false;
 }
 
+QHash<ServerPlayer *, QString> Room::pollNullification(const QString &trick_name, const QString &ask_str, const QList<ServerPlayer *> &humans){
+    poll_mutex.lock();
+    poll.serial ++;
+    poll.players = humans;
+    poll.replies.clear();
+    poll.trick_name = trick_name;
+    poll.answered = false;
+    poll.clock.start();
+    QString poll_str = QString("%1@%2").arg(ask_str).arg(poll.serial);
+    poll_mutex.unlock();
+
+    foreach(ServerPlayer *player, humans)
+        player->invoke("askForNullification", poll_str);
+
+    reply_player = NULL;
+    reply_func = "responseCardCommand";
+
+    waitForReply(reply_func);
+
+    QMutexLocker locker(&poll_mutex);
+
+    // the ones who have not replied yet are taken as declining, the reply they may still send
+    // carries the serial of this poll and is dropped
+    QHash<ServerPlayer *, QString> replies = poll.replies;
+    foreach(ServerPlayer *player, poll.players){
+        if(!replies.contains(player)){
+            replies.insert(player, ".");
+            player->invoke("cancelNullification");
+        }
+    }
+
+    poll_waited += poll.clock.elapsed();
+    poll.players.clear();
+
+    flushMessages();
+
+    return replies;
+}
+
+bool Room::answerPoll(ServerPlayer *player, const QString &reply, int serial){
+    QMutexLocker locker(&poll_mutex);
+
+    if(serial != -1 && serial != poll.serial)
+        return false;
+
+    if(!poll.players.contains(player) || poll.replies.contains(player))
+        return false;
+
+    poll.replies.insert(player, reply);
+
+    // an empty reply comes from a player who has left or is trusted, the AI answers instead later
+    if(!reply.isEmpty()){
+        // each reply is one operation that asking the players one by one would have waited for
+        qint64 latency = poll.clock.elapsed();
+        poll_sequential += latency;
+
+        static const int bounds[] = {1000, 2000, 5000, 10000, 20000};
+        QVector<int> &histogram = poll_latency[poll.trick_name];
+        if(histogram.isEmpty())
+            histogram.resize(6);
+
+        int bucket = 0;
+        while(bucket < 5 && latency >= bounds[bucket])
+            bucket ++;
+        histogram[bucket] ++;
+    }
+
+    if(poll.answered)
+        return true;
+
+    bool valid = !reply.isEmpty() && reply != ".";
+    if(valid || poll.replies.size() == poll.players.size()){
+        poll.answered = true;
+        sem->release();
+    }
+
+    return true;
+}
+
+void Room::outputPollStatistics(){
+    QMutexLocker locker(&poll_mutex);
+
+    if(poll_latency.isEmpty())
+        return;
+
+    output(QString("nullification: waited %1 s in parallel instead of %2 s one by one")
+           .arg(poll_waited / 1000.0).arg(poll_sequential / 1000.0));
+
+    QHashIterator<QString, QVector<int> > itor(poll_latency);
+    while(itor.hasNext()){
+        itor.next();
+
+        const QVector<int> &histogram = itor.value();
+        output(QString("  %1: <1s %2, <2s %3, <5s %4, <10s %5, <20s %6, more %7").arg(itor.key())
+               .arg(histogram.at(0)).arg(histogram.at(1)).arg(histogram.at(2))
+               .arg(histogram.at(3)).arg(histogram.at(4)).arg(histogram.at(5)));
+    }
+}
+
 int Room::askForCardChosen(ServerPlayer *player, ServerPlayer *who, const QString &flags, const QString &reason){
     if(flags == "h" && !who->hasFlag("dongchaee"))
         return who->getRandomHandCardId();
@@ -666,7 +910,7 @@ int Room::askForCardChosen(ServerPlayer *player, ServerPlayer *who, const QStrin
 
     AI *ai = player->getAI();
     if(ai){
-        thread->delay(Config.AIDelay);
+        thread->delay(config.AIDelay);
         card_id = ai->askForCardChosen(who, flags, reason);
     }else{
         player->invoke("askForCardChosen", QString("%1:%2:%3").arg(who->objectName()).arg(flags).arg(reason));
@@ -678,7 +922,7 @@ int Room::askForCardChosen(ServerPlayer *player, ServerPlayer *who, const QStrin
         if(result == "."){
             // randomly choose a card
             QList<const Card *> cards = who->getCards(flags);
-            int r = qrand() % cards.length();
+            int r = rng.bounded(cards.length());
             return cards.at(r)->getId();
         }
 
@@ -706,7 +950,7 @@ const Card *Room::askForCard(ServerPlayer *player, const QString &pattern, const
     }else if(pattern.startsWith("@") || !player->isNude()){
         AI *ai = player->getAI();
         if(ai){
-            thread->delay(Config.AIDelay);
+            thread->delay(config.AIDelay);
             card = ai->askForCard(pattern, prompt, data);
         }else{
             player->invoke("askForCard", QString("%1:%2").arg(pattern).arg(prompt));
@@ -773,7 +1017,7 @@ bool Room::askForUseCard(ServerPlayer *player, const QString &pattern, const QSt
 
     AI *ai = player->getAI();
     if(ai){
-        thread->delay(Config.AIDelay);
+        thread->delay(config.AIDelay);
         answer = ai->askForUseCard(pattern, prompt);
     }else{
         player->invoke("askForUseCard", QString("%1:%2").arg(pattern).arg(prompt));
@@ -811,7 +1055,7 @@ int Room::askForAG(ServerPlayer *player, const QList<int> &card_ids, bool refusa
 
     AI *ai = player->getAI();
     if(ai){
-        thread->delay(Config.AIDelay);
+        thread->delay(config.AIDelay);
         card_id = ai->askForAG(card_ids, refusable, reason);
     }else{
         player->invoke("askForAG", refusable ? "?" : ".");
@@ -932,6 +1176,8 @@ void Room::setPlayerProperty(ServerPlayer *player, const char *property_name, co
 
     if(strcmp(property_name, "hp") == 0){
         thread->trigger(HpChanged, player);
+    }else if(thread && (strcmp(property_name, "general") == 0 || strcmp(property_name, "general2") == 0)){
+        thread->updatePlayerSkills(player);
     }
 }
 
@@ -967,6 +1213,32 @@ QString Room::getMode() const{
     return mode;
 }
 
+const RoomConfig &Room::getConfig() const{
+    return config;
+}
+
+RandomGenerator *Room::getRandomGenerator(){
+    return &rng;
+}
+
+DistanceMatrix *Room::getDistanceMatrix(){
+    return &distance_matrix;
+}
+
+CardArena *Room::getCardArena(){
+    return &card_arena;
+}
+
+quint64 Room::getRandomSeed() const{
+    return rng.getSeed();
+}
+
+// only before the game starts, the draw pile is dealt again from the new seed
+void Room::setRandomSeed(quint64 seed){
+    rng.seed(seed);
+    pile1.reset(Sanguosha->getRandomCards(&rng, &config));
+}
+
 const Scenario *Room::getScenario() const{
     return scenario;
 }
@@ -990,7 +1262,7 @@ void Room::swapPile(){
     if(times == 6)
         gameOver(".");
     if(mode == "04_1v3"){
-        int limit = Config.BanPackages.contains("maneuvering") ? 3 : 2;
+        int limit = config.isBannedPackage("maneuvering") ? 3 : 2;
         if(times == limit)
             gameOver(".");
     }
@@ -1000,9 +1272,9 @@ void Room::swapPile(){
     broadcastInvoke("clearPile");
     broadcastInvoke("setPileNumber", QString::number(draw_pile->length()));
 
-    qShuffle(*draw_pile);
+    draw_pile->shuffle(&rng);
 
-    foreach(int card_id, *draw_pile){
+    foreach(int card_id, draw_pile->toList()){
         setCardMapping(card_id, NULL, Player::DrawPile);
     }
 }
@@ -1054,9 +1326,15 @@ void Room::installEquip(ServerPlayer *player, const QString &equip_name){
 void Room::resetAI(ServerPlayer *player){
     AI *smart_ai = player->getSmartAI();
     if(smart_ai){
-        ais.removeOne(smart_ai);
+        // the new AI takes the place of the old one, as it does in the Lua dispatcher
+        AI *new_ai = cloneAI(player);
+        int index = ais.indexOf(smart_ai);
+        if(index != -1)
+            ais.replace(index, new_ai);
+
         smart_ai->deleteLater();
-        player->setAI(cloneAI(player));
+        player->setAI(new_ai);
+        updateAIDispatch();
     }
 }
 
@@ -1070,7 +1348,7 @@ void Room::transfigure(ServerPlayer *player, const QString &new_general, bool fu
     QString transfigure_str = QString("%1:%2").arg(player->getGeneralName()).arg(new_general);
     player->invoke("transfigure", transfigure_str);
 
-    if(Config.Enable2ndGeneral && !old_general.isEmpty() && player->getGeneral2Name() == old_general){
+    if(config.Enable2ndGeneral && !old_general.isEmpty() && player->getGeneral2Name() == old_general){
         setPlayerProperty(player, "general2", new_general);
         broadcastProperty(player, "general2");
     }
@@ -1196,7 +1474,7 @@ void Room::prepareForStart(){
     }else if(mode == "06_3v3"){
         return;
     }else if(mode == "02_1v1"){
-        if(qrand() % 2 == 0)
+        if(rng.bounded(2) == 0)
             players.swap(0, 1);
 
         players.at(0)->setRole("lord");
@@ -1208,7 +1486,7 @@ void Room::prepareForStart(){
         }
 
     }else if(mode == "04_1v3"){
-        ServerPlayer *lord = players.at(qrand() % 4);
+        ServerPlayer *lord = players.at(rng.bounded(4));
         int i = 0;
         for(i=0; i<4; i++){
             ServerPlayer *player = players.at(i);
@@ -1218,7 +1496,7 @@ void Room::prepareForStart(){
                 player->setRole("rebel");
             broadcastProperty(player, "role");
         }
-    }else if(Config.value("FreeAssign", false).toBool()){
+    }else if(config.FreeAssign){
         ServerPlayer *owner = getOwner();
         if(owner && owner->getState() == "online"){
             owner->invoke("askForAssign");
@@ -1226,7 +1504,7 @@ void Room::prepareForStart(){
 
             if(result.isEmpty() || result == ".")
                 assignRoles();
-            else if(Config.FreeAssignSelf){
+            else if(config.FreeAssignSelf){
                 QStringList texts = result.split(":");
                 QString name = texts.value(0);
                 QString role = texts.value(1);
@@ -1241,7 +1519,7 @@ void Room::prepareForStart(){
                 int n = all_players.count(), i;
                 QStringList roles = Sanguosha->getRoleList(mode);
                 roles.removeOne(role);
-                qShuffle(roles);
+                qShuffle(roles, &rng);
 
                 for(i=0; i<n; i++){
                     ServerPlayer *player = all_players[i];
@@ -1305,7 +1583,7 @@ void Room::reportDisconnection(){
             players.removeOne(player);
 
             if(player->getState() != "robot"){
-                QString screen_name = Config.ContestMode ? tr("Contestant") : player->screenName();
+                QString screen_name = config.ContestMode ? tr("Contestant") : player->screenName();
                 QString leaveStr = tr("<font color=#000000>Player <b>%1</b> left the game</font>").arg(screen_name);
                 speakCommand(player, leaveStr.toUtf8().toBase64());
             }
@@ -1315,12 +1593,7 @@ void Room::reportDisconnection(){
     }else{
         if(!game_started){
             // third case
-            if(!QRegExp("^\\d\\d_\\dv\\d$").exactMatch(mode)){
-                if(player->getGeneral() == NULL)
-                    chooseCommand(player, QString());
-                else
-                    choose2Command(player, QString());
-            }
+            answerSelection(player);
         }
 
         // fourth case
@@ -1345,7 +1618,8 @@ void Room::reportDisconnection(){
             result.clear();
 
             sem->release();
-        }
+        }else
+            answerPoll(player, QString());
     }
 
     if(player->isOwner()){
@@ -1369,7 +1643,8 @@ void Room::trustCommand(ServerPlayer *player, const QString &){
             result.clear();
 
             sem->release();
-        }
+        }else if(!answerPoll(player, QString()))
+            answerSelection(player);
     }else
         player->setState("online");
 
@@ -1392,6 +1667,15 @@ void Room::processRequest(const QString &request){
     Callback callback = callbacks.value(command, NULL);
     if(callback){
         if(callback == &Room::commonCommand){
+            // the replies to a nullification poll carry its serial and do not go through the single reply slot
+            if(command == "responseCardCommand" && args.length() > 2){
+                if(!answerPoll(player, args.at(1), args.at(2).toInt()))
+                    emit room_message(tr("%1: the reply to an old nullification poll is dropped").arg(player->reportHeader()));
+
+                emit room_message(player->reportHeader() + request);
+                return;
+            }
+
             if(!reply_func.isEmpty() && reply_func != command){
                 // just report error message and do not block the game
                 emit room_message(tr("Reply function should be %1 instead of %2").arg(reply_func).arg(command));
@@ -1436,7 +1720,7 @@ void Room::addRobotCommand(ServerPlayer *player, const QString &){
     players << robot;
 
     const QString robot_name = tr("Computer %1").arg(QChar('A' + n));
-    const QString robot_avatar = Sanguosha->getRandomGeneralName();
+    const QString robot_avatar = Sanguosha->getRandomGeneralName(&rng);
     signup(robot, robot_name, robot_avatar, true);
 
     QString greeting = tr("Hello, I'm a robot").toUtf8().toBase64();
@@ -1480,7 +1764,7 @@ void Room::toggleReadyCommand(ServerPlayer *player, const QString &){
             foreach(ServerPlayer *player, players)
                 setPlayerProperty(player, "ready", false);
 
-            start();
+            RoomScheduler::Start(this);
         }
     }
 }
@@ -1490,11 +1774,12 @@ void Room::signup(ServerPlayer *player, const QString &screen_name, const QStrin
     player->setProperty("avatar", avatar);
     player->setScreenName(screen_name);
 
-    if(Config.ContestMode)
+    if(config.ContestMode)
         player->startRecord();
 
     if(!is_robot){
         player->sendProperty("objectName");
+        player->invoke("randomSeed", QString::number(rng.getSeed()));
 
         ServerPlayer *owner = getOwner();
         if(owner == NULL){
@@ -1508,7 +1793,7 @@ void Room::signup(ServerPlayer *player, const QString &screen_name, const QStrin
 
     if(!is_robot){
         QString greetingStr = tr("<font color=#EEB422>Player <b>%1</b> joined the game</font>")
-                .arg(Config.ContestMode ? tr("Contestant") : screen_name);
+                .arg(config.ContestMode ? tr("Contestant") : screen_name);
         speakCommand(player, greetingStr.toUtf8().toBase64());
 
         // introduce all existing player to the new joined
@@ -1531,15 +1816,15 @@ void Room::assignGeneralsForPlayers(const QList<ServerPlayer *> &to_assign){
             existed << player->getGeneral2Name();
     }
 
-    const int max_choice = (Config.EnableHegemony && Config.Enable2ndGeneral) ? 5
-                                                                              : Config.value("MaxChoice", 5).toInt();
-    const int total = Sanguosha->getGeneralCount();
+    const int max_choice = (config.EnableHegemony && config.Enable2ndGeneral) ? 5
+                                                                            : config.MaxChoice;
+    const int total = Sanguosha->getGeneralCount(false, &config);
     const int max_available = (total-existed.size()) / to_assign.length();
     const int choice_count = qMin(max_choice, max_available);
 
-    QStringList choices = Sanguosha->getRandomGenerals(total-existed.size(), existed);
+    QStringList choices = Sanguosha->getRandomGenerals(total-existed.size(), existed, &rng, &config);
 
-    if(Config.EnableHegemony)
+    if(config.EnableHegemony)
     {
         if(to_assign.first()->getGeneral())
         {
@@ -1591,17 +1876,17 @@ void Room::assignGeneralsForPlayers(const QList<ServerPlayer *> &to_assign){
 void Room::chooseGenerals(){
 
     // for lord.
-    if(!Config.EnableHegemony)
+    if(!config.EnableHegemony)
     {
         QStringList lord_list;
         if(mode == "08same")
-            lord_list = Sanguosha->getRandomGenerals(Config.value("MaxChoice", 5).toInt());
+            lord_list = Sanguosha->getRandomGenerals(config.MaxChoice, QSet<QString>(), &rng, &config);
         else
-            lord_list = Sanguosha->getRandomLords();
+            lord_list = Sanguosha->getRandomLords(&rng, &config);
         ServerPlayer *the_lord = getLord();
         QString general = askForGeneral(the_lord, lord_list);
         the_lord->setGeneralName(general);
-        if(!Config.EnableBasara)broadcastProperty(the_lord, "general", general);
+        if(!config.EnableBasara)broadcastProperty(the_lord, "general", general);
 
         if(mode == "08same"){
             foreach(ServerPlayer *p, players){
@@ -1609,35 +1894,36 @@ void Room::chooseGenerals(){
                     p->setGeneralName(general);
             }
 
-            Config.Enable2ndGeneral = false;
             return;
         }
     }
     QList<ServerPlayer *> to_assign = players;
-    if(!Config.EnableHegemony)to_assign.removeOne(getLord());
+    if(!config.EnableHegemony)to_assign.removeOne(getLord());
     assignGeneralsForPlayers(to_assign);
     foreach(ServerPlayer *player, to_assign){
         askForGeneralAsync(player);
     }
-    sem->acquire(to_assign.length());
 
-    if(Config.Enable2ndGeneral){
+    waitForReply("chooseCommand", to_assign.length());
+
+    if(config.Enable2ndGeneral){
         QList<ServerPlayer *> to_assign = players;
         assignGeneralsForPlayers(to_assign);
         foreach(ServerPlayer *player, to_assign){
             askForGeneralAsync(player);
         }
-        sem->acquire(to_assign.length());
+
+        waitForReply("choose2Command", to_assign.length());
     }
 
 
-    if(Config.EnableBasara)
+    if(config.EnableBasara)
     {
         foreach(ServerPlayer *player, players)
         {
             QStringList names;
             if(player->getGeneral())names.append(player->getGeneralName());
-            if(player->getGeneral2() && Config.Enable2ndGeneral)names.append(player->getGeneral2Name());
+            if(player->getGeneral2() && config.Enable2ndGeneral)names.append(player->getGeneral2Name());
             this->setTag(player->objectName(),QVariant::fromValue(names));
         }
     }
@@ -1645,12 +1931,12 @@ void Room::chooseGenerals(){
 
 void Room::run(){
     // initialize random seed for later use
-    qsrand(QTime(0,0,0).secsTo(QTime::currentTime()));
+    qsrand(uint(getRandomSeed()));
 
     prepareForStart();
 
     bool using_countdown = true;
-    if(_virtual || !property("to_test").toString().isEmpty())
+    if(_virtual || !property("to_test").toString().isEmpty() || property("simulate").toBool())
         using_countdown = false;
 
 #ifndef QT_NO_DEBUG
@@ -1658,9 +1944,10 @@ void Room::run(){
 #endif
 
     if(using_countdown){
-        for(int i=Config.CountDownSeconds; i>=0; i--){
+        for(int i=config.CountDownSeconds; i>=0; i--){
             broadcastInvoke("startInXs", QString::number(i));
-            sleep(1);
+            flushMessages();
+            RoomScheduler::Sleep(1000);
         }
     }else
         broadcastInvoke("startInXs", "0");
@@ -1669,14 +1956,14 @@ void Room::run(){
         startGame();
     else if(mode == "06_3v3"){
         thread_3v3 = new RoomThread3v3(this);
-        thread_3v3->start();
-
         connect(thread_3v3, SIGNAL(finished()), this, SLOT(startGame()));
+
+        RoomScheduler::Start(thread_3v3);
     }else if(mode == "02_1v1"){
         thread_1v1 = new RoomThread1v1(this);
-        thread_1v1->start();
-
         connect(thread_1v1, SIGNAL(finished()), this, SLOT(startGame()));
+
+        RoomScheduler::Start(thread_1v1);
     }else if(mode == "04_1v3"){
         ServerPlayer *lord = players.first();
         setPlayerProperty(lord, "general", "shenlvbu1");
@@ -1698,7 +1985,7 @@ void Room::run(){
             if(player == lord)
                 continue;
 
-            qShuffle(names);
+            qShuffle(names, &rng);
             QStringList choices = names.mid(0, 3);
             QString name = askForGeneral(player, choices);
 
@@ -1717,7 +2004,7 @@ void Room::assignRoles(){
     int n = players.count(), i;
 
     QStringList roles = Sanguosha->getRoleList(mode);
-    qShuffle(roles);
+    qShuffle(roles, &rng);
 
     for(i=0; i<n; i++){
         ServerPlayer *player = players[i];
@@ -1785,7 +2072,7 @@ int Room::getCardFromPile(const QString &card_pattern){
 
     if(card_pattern.startsWith("@")){
         if(card_pattern == "@duanliang"){
-            foreach(int card_id, *draw_pile){
+            foreach(int card_id, draw_pile->toList()){
                 const Card *card = Sanguosha->getCard(card_id);
                 if(card->isBlack() && (card->inherits("BasicCard") || card->inherits("EquipCard")))
                     return card_id;
@@ -1793,7 +2080,7 @@ int Room::getCardFromPile(const QString &card_pattern){
         }
     }else{
         QString card_name = card_pattern;
-        foreach(int card_id, *draw_pile){
+        foreach(int card_id, draw_pile->toList()){
             const Card *card = Sanguosha->getCard(card_id);
             if(card->objectName() == card_name)
                 return card_id;
@@ -1804,9 +2091,12 @@ int Room::getCardFromPile(const QString &card_pattern){
 }
 
 void Room::choose2Command(ServerPlayer *player, const QString &general_name){
+    if(!takeSelection(player, "choose2Command"))
+        return;
+
     const General *general = Sanguosha->getGeneral(general_name);
     if(general == NULL){
-        if(Config.EnableHegemony)
+        if(config.EnableHegemony)
         {
             foreach(QString name,player->getSelected())
             {
@@ -1830,9 +2120,12 @@ void Room::choose2Command(ServerPlayer *player, const QString &general_name){
 }
 
 void Room::chooseCommand(ServerPlayer *player, const QString &general_name){
+    if(!takeSelection(player, "chooseCommand"))
+        return;
+
     const General *general = Sanguosha->getGeneral(general_name);
     if(general == NULL){
-        if(Config.EnableHegemony && Config.Enable2ndGeneral)
+        if(config.EnableHegemony && config.Enable2ndGeneral)
         {
             foreach(QString name, player->getSelected())
             {
@@ -2037,7 +2330,7 @@ bool Room::hasWelfare(const ServerPlayer *player) const{
         return player->isLord() || player->getRole() == "renegade";
     else if(mode == "04_1v3")
         return false;
-    else if(Config.EnableHegemony)
+    else if(config.EnableHegemony)
         return false;
     else
         return player->isLord() && player_count > 4;
@@ -2099,8 +2392,19 @@ void Room::marshal(ServerPlayer *player){
     player->invoke("setPileNumber", QString::number(draw_pile->length()));
 }
 
+// the recorded players get a keyframe every few turns, so that a replay can start from there
+void Room::recordKeyframes(){
+    int turn = tag.value("TurnCount").toInt();
+    int interval = config.KeyframeInterval;
+    if(turn % interval != 0)
+        return;
+
+    foreach(ServerPlayer *player, players)
+        player->recordKeyframe(turn);
+}
+
 void Room::startGame(){
-    if(Config.ContestMode)
+    if(config.ContestMode)
         tag.insert("StartTime", QDateTime::currentDateTime());
 
     QString to_test = property("to_test").toString();
@@ -2115,7 +2419,7 @@ void Room::startGame(){
         }
 
         if(!found){
-            int r = qrand() % players.length();
+            int r = rng.bounded(players.length());
             players.at(r)->setGeneralName(to_test);
         }
     }
@@ -2126,7 +2430,7 @@ void Room::startGame(){
         if(mode == "06_3v3" || mode == "02_1v1")
             start_index = 0;
 
-        if(!Config.EnableBasara)for(i = start_index; i < players.count(); i++){
+        if(!config.EnableBasara)for(i = start_index; i < players.count(); i++){
             broadcastProperty(players.at(i), "general");
         }
 
@@ -2139,7 +2443,7 @@ void Room::startGame(){
         }
     }
 
-    if((Config.Enable2ndGeneral) && mode != "02_1v1" && mode != "06_3v3" && mode != "04_1v3" && !Config.EnableBasara){
+    if((config.Enable2ndGeneral) && mode != "02_1v1" && mode != "06_3v3" && mode != "04_1v3" && !config.EnableBasara){
         foreach(ServerPlayer *player, players)
             broadcastProperty(player, "general2");
     }
@@ -2165,19 +2469,21 @@ void Room::startGame(){
         player->setAI(ai);
     }
 
+    updateAIDispatch();
+
     broadcastInvoke("startGame");
     game_started = true;
 
     Server *server = qobject_cast<Server *>(parent());
     foreach(ServerPlayer *player, players){
-        if(player->getState() == "online")
+        if(server && player->getState() == "online")
             server->signupPlayer(player);
     }
 
     current = players.first();
 
-    // initialize the place_map and owner_map;
-    foreach(int card_id, *draw_pile){
+    // initialize the place_table and owner_table;
+    foreach(int card_id, draw_pile->toList()){
         setCardMapping(card_id, NULL, Player::DrawPile);
     }
 
@@ -2185,17 +2491,19 @@ void Room::startGame(){
 
     thread = new RoomThread(this);
     connect(thread, SIGNAL(started()), this, SIGNAL(game_start()));
+    connect(thread, SIGNAL(finished()), this, SLOT(releaseLuaState()));
+    connect(thread, SIGNAL(finished()), this, SLOT(releaseCards()));
 
     GameRule *game_rule;
     if(mode == "04_1v3")
         game_rule = new HulaoPassMode(this);
-    else if(Config.EnableScene)	//changjing
+    else if(config.EnableScene)	//changjing
         game_rule = new SceneRule(this);	//changjing
     else
         game_rule = new GameRule(this);
 
     thread->constructTriggerTable(game_rule);
-    if(Config.EnableBasara)thread->addTriggerSkill(new BasaraMode(this));
+    if(config.EnableBasara)thread->addTriggerSkill(new BasaraMode(this));
 
     if(scenario){
         const ScenarioRule *rule = scenario->getRule();
@@ -2203,7 +2511,7 @@ void Room::startGame(){
             thread->addTriggerSkill(rule);
     }
 
-    if(!_virtual)thread->start();
+    if(!_virtual)RoomScheduler::Start(thread);
 }
 
 void Room::broadcastProperty(ServerPlayer *player, const char *property_name, const QString &value){
@@ -2230,7 +2538,7 @@ void Room::drawCards(ServerPlayer *player, int n){
 
         cards_str << QString::number(card_id);
 
-        // update place_map & owner_map
+        // update place_table & owner_table
         setCardMapping(card_id, player, Player::Hand);
     }
 
@@ -2476,6 +2784,27 @@ void Room::broadcastInvoke(const char *method, const QString &arg, ServerPlayer
     broadcast(QString("%1 %2").arg(method).arg(arg), except);
 }
 
+void Room::flushMessages(){
+    foreach(ServerPlayer *player, players)
+        player->flushMessages();
+}
+
+void Room::outputBroadcastStatistics(){
+    int flushes = 0, messages = 0;
+    foreach(ServerPlayer *player, players){
+        flushes += player->getFlushCount();
+        messages += player->getFlushedMessageCount();
+    }
+
+    if(flushes == 0)
+        return;
+
+    output(QString("broadcast: %1 messages in %2 flushes, %3 per flush, %4 writes saved")
+           .arg(messages).arg(flushes)
+           .arg(double(messages) / flushes, 0, 'f', 2)
+           .arg(messages - flushes));
+}
+
 void Room::startTest(const QString &to_test){
     fillRobotsCommand(NULL, ".");
     setProperty("to_test", to_test);
@@ -2488,12 +2817,98 @@ void Room::getResult(const QString &reply_func, ServerPlayer *reply_player, bool
     this->reply_func = reply_func;
     this->reply_player = reply_player;
 
-    sem->acquire();
+    waitForReply(reply_func);
+}
+
+void Room::waitForReply(const QString &reply_func, int count){
+    // the clients count down by themselves, the deadline is for the ones that never reply,
+    // which holds for the choices of the generals, the roles and the order before the game as well
+    int msecs = 0;
+    if(config.OperationTimeout > 0){
+        int timeout = config.OperationTimeout;
+        if(reply_func == "replyGuanxingCommand")
+            timeout = qMax(timeout, 20);
+
+        msecs = timeout * 1000 + config.DeadlineGrace;
+    }
+
+    DeadlineWheel *wheel = DeadlineWheel::GetInstance();
+    deadline_expired = false;
+    if(msecs > 0)
+        deadline = wheel->schedule(this, "onDeadline", msecs);
 
-    if(game_finished)
+    QElapsedTimer clock;
+    clock.start();
+
+    flushMessages();
+    sem->acquire(count);
+
+    if(deadline){
+        wheel->cancel(deadline);
+        deadline = 0;
+    }
+
+    wheel->record(reply_func, clock.elapsed(), deadline_expired);
+
+    // the game thread is not made yet while the generals are chosen
+    if(game_finished && thread)
         thread->end();
 }
 
+void Room::expectSelection(ServerPlayer *player, const QString &reply_func){
+    QMutexLocker locker(&poll_mutex);
+    selections.insert(player, reply_func);
+}
+
+bool Room::takeSelection(ServerPlayer *player, const QString &reply_func){
+    // a reply that was not asked for, or that came after the server answered, would release the semaphore once more
+    QMutexLocker locker(&poll_mutex);
+    if(selections.value(player) != reply_func)
+        return false;
+
+    selections.remove(player);
+    return true;
+}
+
+void Room::answerSelection(ServerPlayer *player){
+    poll_mutex.lock();
+    QString reply_func = selections.value(player);
+    poll_mutex.unlock();
+
+    Callback callback = callbacks.value(reply_func, NULL);
+    if(callback)
+        (this->*callback)(player, QString());
+}
+
+void Room::onDeadline(int id){
+    if(id != deadline || game_finished)
+        return;
+
+    QList<ServerPlayer *> waiting;
+    if(reply_player)
+        waiting << reply_player;
+    else{
+        QMutexLocker locker(&poll_mutex);
+        foreach(ServerPlayer *player, poll.players){
+            if(!poll.replies.contains(player))
+                waiting << player;
+        }
+
+        waiting << selections.keys();
+    }
+
+    // the trust AI answers for the players who are still online but have not replied
+    foreach(ServerPlayer *player, waiting){
+        if(player->getState() != "online")
+            continue;
+
+        emit room_message(tr("%1 has not replied in time and is trusted now").arg(player->reportHeader()));
+
+        deadline_expired = true;
+        trustCommand(player, ".");
+    }
+}
+
 void Room::acquireSkill(ServerPlayer *player, const Skill *skill, bool open){
     QString skill_name = skill->objectName();
     if(player->hasSkill(skill_name))
@@ -2504,6 +2919,7 @@ void Room::acquireSkill(ServerPlayer *player, const Skill *skill, bool open){
     if(skill->inherits("TriggerSkill")){
         const TriggerSkill *trigger_skill = qobject_cast<const TriggerSkill *>(skill);
         thread->addTriggerSkill(trigger_skill);
+        thread->updatePlayerSkills(player);
     }
 
     if(skill->isVisible()){
@@ -2547,7 +2963,7 @@ void Room::setEmotion(ServerPlayer *target, const QString &emotion){
 void Room::activate(ServerPlayer *player, CardUseStruct &card_use){
     AI *ai = player->getAI();
     if(ai){
-        thread->delay(Config.AIDelay);
+        thread->delay(config.AIDelay);
         card_use.from = player;
         ai->activate(card_use);
     }else{
@@ -2592,7 +3008,7 @@ Card::Suit Room::askForSuit(ServerPlayer *player){
 
     Card::Suit suit;
     if(result == ".")
-        return Card::AllSuits[qrand() % 4];
+        return Card::AllSuits[rng.bounded(4)];
     if(result == "spade")
         suit = Card::Spade;
     else if(result == "club")
@@ -2714,16 +3130,24 @@ const Card *Room::askForExchange(ServerPlayer *player, const QString &reason, in
 }
 
 void Room::setCardMapping(int card_id, ServerPlayer *owner, Player::Place place){
-    owner_map.insert(card_id, owner);
-    place_map.insert(card_id, place);
+    if(card_id < 0)
+        return;
+
+    if(card_id >= place_table.size()){
+        place_table.resize(card_id + 1);
+        owner_table.resize(card_id + 1);
+    }
+
+    owner_table[card_id] = owner;
+    place_table[card_id] = place;
 }
 
 ServerPlayer *Room::getCardOwner(int card_id) const{
-    return owner_map.value(card_id);
+    return owner_table.value(card_id);
 }
 
 Player::Place Room::getCardPlace(int card_id) const{
-    return place_map.value(card_id);
+    return place_table.value(card_id);
 }
 
 ServerPlayer *Room::getLord() const{
@@ -2862,7 +3286,7 @@ const Card *Room::askForPindian(ServerPlayer *player,
 
     AI *ai = player->getAI();
     if(ai){
-        thread->delay(Config.AIDelay);
+        thread->delay(config.AIDelay);
         return ai->askForPindian(from, reason);
     }
 
@@ -2925,15 +3349,14 @@ ServerPlayer *Room::askForPlayerChosen(ServerPlayer *player, const QList<ServerP
 }
 
 void Room::askForGeneralAsync(ServerPlayer *player){
-    if(player->getState() != "online"){
-        if(player->getGeneral())
-            choose2Command(player, QString());
-        else
-            chooseCommand(player, QString());
-    }else
+    expectSelection(player, player->getGeneral() ? "choose2Command" : "chooseCommand");
+
+    if(player->getState() != "online")
+        answerSelection(player);
+    else
     {
         QStringList selected = player->getSelected();
-        if(!Config.EnableBasara)selected.append(QString("%1(lord)").arg(getLord()->getGeneralName()));
+        if(!config.EnableBasara)selected.append(QString("%1(lord)").arg(getLord()->getGeneralName()));
         else selected.append("anjiang(lord)");
         const char *command = player->getGeneral() ? "doChooseGeneral2" : "doChooseGeneral";
         player->invoke(command, selected.join("+"));
@@ -2942,7 +3365,7 @@ void Room::askForGeneralAsync(ServerPlayer *player){
 
 QString Room::askForGeneral(ServerPlayer *player, const QStringList &generals, QString default_choice){
     if(default_choice.isEmpty())
-        default_choice = generals.at(qrand() % generals.length());
+        default_choice = generals.at(rng.bounded(generals.length()));
 
     if(player->getState() == "online"){
         player->invoke("askForGeneral", generals.join("+"));
@@ -2959,7 +3382,7 @@ QString Room::askForGeneral(ServerPlayer *player, const QStringList &generals, Q
 
 void Room::kickCommand(ServerPlayer *player, const QString &arg){
     // kicking is not allowed at contest mode
-    if(Config.ContestMode)
+    if(config.ContestMode)
         return;
 
     // only the lord can kick others
@@ -3210,13 +3633,23 @@ QString Room::generatePlayerName(){
 }
 
 void Room::arrangeCommand(ServerPlayer *player, const QString &arg){
+    if(!takeSelection(player, "arrangeCommand"))
+        return;
+
+    QStringList arranged;
+    if(!arg.isEmpty())
+        arranged = arg.split("+");
+
     if(mode == "06_3v3")
-        thread_3v3->arrange(player, arg.split("+"));
+        thread_3v3->arrange(player, arranged);
     else if(mode == "02_1v1")
-        thread_1v1->arrange(player, arg.split("+"));
+        thread_1v1->arrange(player, arranged);
 }
 
 void Room::takeGeneralCommand(ServerPlayer *player, const QString &arg){
+    if(!takeSelection(player, "takeGeneralCommand"))
+        return;
+
     if(mode == "06_3v3")
         thread_3v3->takeGeneral(player, arg);
     else if(mode == "02_1v1")
@@ -3225,43 +3658,58 @@ void Room::takeGeneralCommand(ServerPlayer *player, const QString &arg){
 
 QString Room::askForOrder(ServerPlayer *player){
     QString reason;
-    if(thread_3v3->isFinished())
-        reason = "turn";
-    else
+    if(RoomScheduler::IsCurrent(thread_3v3))
         reason = "select";
+    else
+        reason = "turn";
 
+    result.clear();
     if(player->getState() == "online"){
         player->invoke("askForOrder", reason);
-        reply_player = player;
-        reply_func = "selectOrderCommand";
-        sem->acquire();
-    }else{
-        result = qrand() % 2 == 0 ? "warm" : "cool";
+        getResult("selectOrderCommand", player, false);
     }
 
+    // the ones offline or trusted when the deadline expires are given one at random
+    if(result != "warm" && result != "cool")
+        result = rng.bounded(2) == 0 ? "warm" : "cool";
+
     return result;
 }
 
-void Room::selectOrderCommand(ServerPlayer *, const QString &arg){
+void Room::selectOrderCommand(ServerPlayer *player, const QString &arg){
+    if(reply_player != player || reply_func != "selectOrderCommand")
+        return;
+
     result = arg;
+    reply_player = NULL;
+    reply_func.clear();
+
     sem->release();
 }
 
 QString Room::askForRole(ServerPlayer *player, const QStringList &roles, const QString &scheme){
     QStringList squeezed = roles.toSet().toList();
     player->invoke("askForRole", QString("%1:%2").arg(scheme).arg(squeezed.join("+")));
-    reply_player = player;
-    reply_func = "selectRoleCommand";
-    sem->acquire();
+    getResult("selectRoleCommand", player, false);
+
+    // a player trusted when the deadline expires abstains
+    if(result.isEmpty())
+        result = "abstain";
 
     return result;
 }
 
 void Room::selectRoleCommand(ServerPlayer *player, const QString &arg){
+    if(reply_player != player || reply_func != "selectRoleCommand")
+        return;
+
     result = arg;
     if(result.isEmpty())
         result = "abstained";
 
+    reply_player = NULL;
+    reply_func.clear();
+
     sem->release();
 }
 
@@ -3289,6 +3737,7 @@ void Room::copyFrom(Room* rRoom)
         transfigure(b, a->getGeneralName(), false);
 
         b->copyFrom(a);
+        thread->updatePlayerSkills(b);
     }
     for(int i=0; i<players.length(); i++)
     {
@@ -3303,19 +3752,19 @@ void Room::copyFrom(Room* rRoom)
     }
     current = player_map.value(rRoom->getCurrent());
 
-    pile1 = QList<int> (rRoom->pile1);
-    pile2 = QList<int> (rRoom->pile2);
-    table_cards = QList<int> (rRoom->table_cards);
-    draw_pile = &pile1;
-    discard_pile = &pile2;
-
-    place_map = QMap<int, Player::Place> (rRoom->place_map);
-    owner_map = QMap<int, ServerPlayer*>();
-
-    QList<int> keys = rRoom->owner_map.keys();
+    pile1 = rRoom->pile1;
+    pile2 = rRoom->pile2;
+    table_cards = rRoom->table_cards;
+    draw_pile = rRoom->draw_pile == &rRoom->pile1 ? &pile1 : &pile2;
+    discard_pile = rRoom->discard_pile == &rRoom->pile1 ? &pile1 : &pile2;
 
-    foreach(int i, keys)
-        owner_map.insert(i, rRoom->owner_map.value(i));
+    // the tables are flat arrays, only the owners need to be mapped to our players
+    place_table = rRoom->place_table;
+    owner_table = rRoom->owner_table;
+    for(int i=0; i<owner_table.size(); i++){
+        if(owner_table.at(i))
+            owner_table[i] = player_map.value(owner_table.at(i));
+    }
 
     provided = rRoom->provided;
 
@@ -3323,6 +3772,10 @@ void Room::copyFrom(Room* rRoom)
 
 }
 
+RoomState Room::snapshot() const{
+    return RoomState(this);
+}
+
 Room* Room::duplicate()
 {
     Server* svr = qobject_cast<Server *> (parent());
@@ -7,12 +7,26 @@ class Scenario;
 class RoomThread3v3;
 class RoomThread1v1;
 class TrickCard;
+class RoomState;
+class LuaProfiler;
 
 struct lua_State;
 struct LogMessage;
 
 #include "serverplayer.h"
 #include "roomthread.h"
+#include "roomscheduler.h"
+#include "cardpile.h"
+#include "randomgenerator.h"
+#include "distancematrix.h"
+#include "cardarena.h"
+#include "roomconfig.h"
+
+#include <QMutex>
+#include <QElapsedTimer>
+
+// card places are copied as plain memory
+Q_DECLARE_TYPEINFO(Player::Place, Q_PRIMITIVE_TYPE);
 
 class Room : public QThread{
     Q_OBJECT
@@ -21,16 +35,25 @@ public:
     friend class RoomThread;
     friend class RoomThread3v3;
     friend class RoomThread1v1;
+    friend class RoomScheduler;
+    friend class RoomState;
 
     typedef void (Room::*Callback)(ServerPlayer *, const QString &);
 
     explicit Room(QObject *parent, const QString &mode);
+    ~Room();
     QString createLuaState();
     ServerPlayer *addSocket(ClientSocket *socket);
     bool isFull() const;
     bool isFinished() const;
     int getLack() const;
     QString getMode() const;
+    const RoomConfig &getConfig() const;
+    RandomGenerator *getRandomGenerator();
+    DistanceMatrix *getDistanceMatrix();
+    CardArena *getCardArena();
+    quint64 getRandomSeed() const;
+    void setRandomSeed(quint64 seed);
     const Scenario *getScenario() const;
     RoomThread *getThread() const;
     void playSkillEffect(const QString &skill_name, int index = -1);
@@ -91,6 +114,7 @@ public:
     ServerPlayer *findPlayerBySkillName(const QString &skill_name, bool include_dead = false) const;
     void installEquip(ServerPlayer *player, const QString &equip_name);
     void resetAI(ServerPlayer *player);
+    void filterEvents(TriggerEvent event, ServerPlayer *target, const QVariant &data);
     void transfigure(ServerPlayer *player, const QString &new_general, bool full_state, bool invoke_start = true, const QString &old_general = QString(""));
     void swapSeat(ServerPlayer *a, ServerPlayer *b);
     lua_State *getLuaState() const;
@@ -104,11 +128,13 @@ public:
 
     void reconnect(ServerPlayer *player, ClientSocket *socket);
     void marshal(ServerPlayer *player);
+    void recordKeyframes();
 
     bool isVirtual();
     void setVirtual();
     void copyFrom(Room* rRoom);
     Room* duplicate();
+    RoomState snapshot() const;
 
     const ProhibitSkill *isProhibited(const Player *from, const Player *to, const Card *card) const;
 
@@ -165,6 +191,8 @@ public:
     void choose2Command(ServerPlayer *player, const QString &general_name);
     void broadcastProperty(ServerPlayer *player, const char *property_name, const QString &value = QString());
     void broadcastInvoke(const char *method, const QString &arg = ".", ServerPlayer *except = NULL);
+    void flushMessages();
+    void outputBroadcastStatistics();
     void startTest(const QString &to_test);
 
 protected:
@@ -172,29 +200,60 @@ protected:
 
 private:
     QString mode;
+    const RoomConfig config;
     QList<ServerPlayer*> players, alive_players;
     int player_count;
     ServerPlayer *current;
     ServerPlayer *reply_player;
-    QList<int> pile1, pile2;
-    QList<int> table_cards;
-    QList<int> *draw_pile, *discard_pile;
+    RandomGenerator rng;
+    DistanceMatrix distance_matrix;
+    CardArena card_arena;
+    CardPile pile1, pile2;
+    CardPile table_cards;
+    CardPile *draw_pile, *discard_pile;
     bool game_started;
     bool game_finished;
     lua_State *L;
+    LuaProfiler *profiler;
     QList<AI *> ais;
+    bool ai_dispatch;
 
     RoomThread *thread;
     RoomThread3v3 *thread_3v3;
     RoomThread1v1 *thread_1v1;
-    QSemaphore *sem;
+    TaskSemaphore *sem;
     QString result;
     QString reply_func;
 
+    // the humans asked for nullification at the same time, their replies are filled in by the server thread,
+    // each poll has its own serial, the clients echo it so that a late reply to an old poll is dropped
+    struct NullificationPoll{
+        int serial;
+        QList<ServerPlayer *> players;
+        QHash<ServerPlayer *, QString> replies;
+        QString trick_name;
+        QElapsedTimer clock;
+        bool answered;
+    };
+
+    NullificationPoll poll;
+    QMutex poll_mutex;
+
+    // the players asked at the same time outside the polls, such as for their generals, by the command
+    // they answer with, each answer releases the semaphore once, it is guarded by poll_mutex as well
+    QHash<ServerPlayer *, QString> selections;
+    QHash<QString, QVector<int> > poll_latency;
+    qint64 poll_waited, poll_sequential;
+
+    // the id of the deadline of the reply being waited for, 0 if there is none
+    int deadline;
+    bool deadline_expired;
+
     QHash<QString, Callback> callbacks;
 
-    QMap<int, Player::Place> place_map;
-    QMap<int, ServerPlayer*> owner_map;
+    // indexed by card id
+    QVector<Player::Place> place_table;
+    QVector<ServerPlayer *> owner_table;
 
     const Card *provided;
 
@@ -208,6 +267,16 @@ private:
     void assignGeneralsForPlayers(const QList<ServerPlayer *> &to_assign);
     void chooseGenerals();
     AI *cloneAI(ServerPlayer *player);
+    void updateAIDispatch();
+    QHash<ServerPlayer *, QString> pollNullification(const QString &trick_name, const QString &ask_str, const QList<ServerPlayer *> &humans);
+    // the server answers for a player to the poll running now with serial -1
+    bool answerPoll(ServerPlayer *player, const QString &reply, int serial = -1);
+    void outputPollStatistics();
+    void waitForReply(const QString &reply_func, int count = 1);
+    void expectSelection(ServerPlayer *player, const QString &reply_func);
+    bool takeSelection(ServerPlayer *player, const QString &reply_func);
+    // the command answers with an empty argument, so the selector chooses for the player
+    void answerSelection(ServerPlayer *player);
     void broadcast(const QString &message, ServerPlayer *except = NULL);
     void initCallbacks();
     void arrangeCommand(ServerPlayer *player, const QString &arg);
@@ -228,6 +297,9 @@ private slots:
     void processRequest(const QString &request);
     void assignRoles();
     void startGame();
+    void releaseLuaState();
+    void releaseCards();
+    void onDeadline(int id);
 
 signals:
     void room_message(const QString &msg);
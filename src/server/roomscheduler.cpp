@@ -0,0 +1,390 @@
+#include "roomscheduler.h"
+#include "engine.h"
+
+#include <QElapsedTimer>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <ucontext.h>
+#include <cstdlib>
+#endif
+
+// the game flow calls into the AI scripts, so give each task a thread-sized stack
+static const int TaskStackSize = 4 * 1024 * 1024;
+
+class RoomTask{
+public:
+    enum State{
+        Ready,
+        Running,
+        Suspending,
+        Parked,
+        Finished
+    };
+
+    RoomScheduler::Entry entry;
+    void *arg;
+    const QObject *owner;
+    State state;
+    bool wake_pending;
+    qint64 deadline;
+
+#ifdef Q_OS_WIN
+    LPVOID fiber;
+#else
+    ucontext_t context;
+    char *stack;
+#endif
+};
+
+class RoomWorker: public QThread{
+public:
+    explicit RoomWorker(RoomScheduler *scheduler)
+        :QThread(scheduler), scheduler(scheduler), current(NULL)
+    {
+    }
+
+    static RoomWorker *Current(){
+        return dynamic_cast<RoomWorker *>(QThread::currentThread());
+    }
+
+    void switchTo(RoomTask *task){
+#ifdef Q_OS_WIN
+        SwitchToFiber(task->fiber);
+#else
+        swapcontext(&context, &task->context);
+#endif
+    }
+
+    void switchBack(RoomTask *task){
+#ifdef Q_OS_WIN
+        Q_UNUSED(task);
+        SwitchToFiber(fiber);
+#else
+        swapcontext(&task->context, &context);
+#endif
+    }
+
+    RoomScheduler *scheduler;
+    RoomTask *current;
+
+#ifdef Q_OS_WIN
+    LPVOID fiber;
+#else
+    ucontext_t context;
+#endif
+
+protected:
+    virtual void run(){
+#ifdef Q_OS_WIN
+        fiber = ConvertThreadToFiber(NULL);
+#endif
+
+        forever{
+            RoomTask *task = scheduler->takeTask();
+            if(task == NULL)
+                break;
+
+            current = task;
+            switchTo(task);
+            current = NULL;
+
+            scheduler->suspended(task);
+        }
+
+#ifdef Q_OS_WIN
+        ConvertFiberToThread();
+#endif
+    }
+};
+
+// a parked task may be resumed by another worker, so always ask the thread we are on
+#ifdef Q_OS_WIN
+static void CALLBACK TaskMain(LPVOID){
+#else
+static void TaskMain(){
+#endif
+    RoomTask *task = RoomWorker::Current()->current;
+    task->entry(task->arg);
+    task->state = RoomTask::Finished;
+
+    RoomWorker::Current()->switchBack(task);
+}
+
+static QElapsedTimer Clock;
+
+bool RoomScheduler::enabled = false;
+
+RoomScheduler::RoomScheduler(QObject *parent)
+    :QObject(parent), stopped(false), task_count(0), parked_count(0)
+{
+    Clock.start();
+
+    int n = qMax(QThread::idealThreadCount(), 1);
+    int i;
+    for(i=0; i<n; i++){
+        RoomWorker *worker = new RoomWorker(this);
+        workers << worker;
+        worker->start();
+    }
+}
+
+RoomScheduler::~RoomScheduler(){
+    mutex.lock();
+    stopped = true;
+    condition.wakeAll();
+    mutex.unlock();
+
+    foreach(RoomWorker *worker, workers)
+        worker->wait();
+}
+
+RoomScheduler *RoomScheduler::GetInstance(){
+    static RoomScheduler *scheduler;
+    if(scheduler == NULL)
+        scheduler = new RoomScheduler(Sanguosha);
+
+    return scheduler;
+}
+
+bool RoomScheduler::IsEnabled(){
+    return enabled;
+}
+
+void RoomScheduler::SetEnabled(bool enabled){
+    RoomScheduler::enabled = enabled;
+}
+
+bool RoomScheduler::IsCurrent(const QThread *thread){
+    if(QThread::currentThread() == thread)
+        return true;
+
+    RoomWorker *worker = RoomWorker::Current();
+    return worker && worker->current && worker->current->owner == thread;
+}
+
+const QObject *RoomScheduler::CurrentOwner(){
+    RoomWorker *worker = RoomWorker::Current();
+    if(worker)
+        return worker->current ? worker->current->owner : NULL;
+    else
+        return QThread::currentThread();
+}
+
+void RoomScheduler::Sleep(unsigned long msecs){
+    if(enabled){
+        RoomScheduler *scheduler = GetInstance();
+        RoomTask *task = scheduler->currentTask();
+        if(task){
+            scheduler->sleepTask(task, msecs);
+            return;
+        }
+    }
+
+    QMutex mutex;
+    QWaitCondition condition;
+    mutex.lock();
+    condition.wait(&mutex, msecs);
+    mutex.unlock();
+}
+
+void RoomScheduler::spawn(Entry entry, void *arg, const QObject *owner){
+    RoomTask *task = new RoomTask;
+    task->entry = entry;
+    task->arg = arg;
+    task->owner = owner;
+    task->state = RoomTask::Ready;
+    task->wake_pending = false;
+    task->deadline = 0;
+
+#ifdef Q_OS_WIN
+    task->fiber = CreateFiberEx(64 * 1024, TaskStackSize, 0, TaskMain, NULL);
+#else
+    task->stack = static_cast<char *>(malloc(TaskStackSize));
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = task->stack;
+    task->context.uc_stack.ss_size = TaskStackSize;
+    task->context.uc_link = NULL;
+    makecontext(&task->context, TaskMain, 0);
+#endif
+
+    QMutexLocker locker(&mutex);
+    task_count++;
+    ready << task;
+    condition.wakeOne();
+}
+
+RoomTask *RoomScheduler::currentTask() const{
+    RoomWorker *worker = RoomWorker::Current();
+    if(worker)
+        return worker->current;
+    else
+        return NULL;
+}
+
+void RoomScheduler::park(){
+    RoomTask *task = currentTask();
+    Q_ASSERT(task != NULL);
+
+    task->state = RoomTask::Suspending;
+    RoomWorker::Current()->switchBack(task);
+}
+
+void RoomScheduler::wake(RoomTask *task){
+    QMutexLocker locker(&mutex);
+
+    if(task->state == RoomTask::Parked){
+        parked_count--;
+        task->state = RoomTask::Ready;
+        ready << task;
+        condition.wakeOne();
+    }else
+        task->wake_pending = true;
+}
+
+void RoomScheduler::sleepTask(RoomTask *task, unsigned long msecs){
+    mutex.lock();
+    task->deadline = Clock.elapsed() + msecs;
+    sleepers << task;
+    condition.wakeAll();
+    mutex.unlock();
+
+    park();
+}
+
+RoomTask *RoomScheduler::takeTask(){
+    QMutexLocker locker(&mutex);
+
+    forever{
+        if(stopped)
+            return NULL;
+
+        qint64 now = Clock.elapsed();
+        qint64 nearest = -1;
+        QMutableListIterator<RoomTask *> itor(sleepers);
+        while(itor.hasNext()){
+            RoomTask *task = itor.next();
+            if(task->deadline > now){
+                if(nearest == -1 || task->deadline < nearest)
+                    nearest = task->deadline;
+
+                continue;
+            }
+
+            itor.remove();
+            if(task->state == RoomTask::Parked){
+                parked_count--;
+                task->state = RoomTask::Ready;
+                ready << task;
+            }else
+                task->wake_pending = true;
+        }
+
+        if(!ready.isEmpty()){
+            RoomTask *task = ready.takeFirst();
+            task->state = RoomTask::Running;
+            return task;
+        }
+
+        if(nearest == -1)
+            condition.wait(&mutex);
+        else
+            condition.wait(&mutex, nearest - now);
+    }
+}
+
+void RoomScheduler::suspended(RoomTask *task){
+    QMutexLocker locker(&mutex);
+
+    switch(task->state){
+    case RoomTask::Finished:{
+            task_count--;
+#ifdef Q_OS_WIN
+            DeleteFiber(task->fiber);
+#else
+            free(task->stack);
+#endif
+            delete task;
+            break;
+        }
+
+    case RoomTask::Suspending:{
+            if(task->wake_pending){
+                task->wake_pending = false;
+                task->state = RoomTask::Ready;
+                ready << task;
+                condition.wakeOne();
+            }else{
+                task->state = RoomTask::Parked;
+                parked_count++;
+            }
+
+            break;
+        }
+
+    default:
+        break;
+    }
+}
+
+int RoomScheduler::getWorkerCount() const{
+    return workers.length();
+}
+
+int RoomScheduler::getTaskCount() const{
+    QMutexLocker locker(&mutex);
+    return task_count;
+}
+
+int RoomScheduler::getParkedCount() const{
+    QMutexLocker locker(&mutex);
+    return parked_count;
+}
+
+TaskSemaphore::TaskSemaphore(int n)
+    :avail(n)
+{
+}
+
+void TaskSemaphore::acquire(int n){
+    RoomScheduler *scheduler = NULL;
+    RoomTask *task = NULL;
+    if(RoomScheduler::IsEnabled()){
+        scheduler = RoomScheduler::GetInstance();
+        task = scheduler->currentTask();
+    }
+
+    QMutexLocker locker(&mutex);
+    while(avail < n){
+        if(task){
+            parked << task;
+            locker.unlock();
+            scheduler->park();
+            locker.relock();
+        }else
+            condition.wait(&mutex);
+    }
+
+    avail -= n;
+}
+
+void TaskSemaphore::release(int n){
+    QMutexLocker locker(&mutex);
+    avail += n;
+
+    if(!parked.isEmpty()){
+        RoomScheduler *scheduler = RoomScheduler::GetInstance();
+        foreach(RoomTask *task, parked)
+            scheduler->wake(task);
+
+        parked.clear();
+    }
+
+    condition.wakeAll();
+}
+
+int TaskSemaphore::available() const{
+    QMutexLocker locker(&mutex);
+    return avail;
+}
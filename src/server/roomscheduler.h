@@ -0,0 +1,95 @@
+#ifndef ROOMSCHEDULER_H
+#define ROOMSCHEDULER_H
+
+class RoomTask;
+class RoomWorker;
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+
+// runs the game flow of rooms as tasks on a fixed number of worker threads,
+// a task that waits for a client reply is parked instead of blocking a thread
+class RoomScheduler : public QObject{
+    Q_OBJECT
+
+public:
+    typedef void (*Entry)(void *arg);
+
+    static RoomScheduler *GetInstance();
+    static bool IsEnabled();
+    static void SetEnabled(bool enabled);
+
+    // true if the code is running inside the given thread, or inside the task started for it
+    static bool IsCurrent(const QThread *thread);
+    // the thread whose game flow runs here, that is the owner of the current task if there is one
+    static const QObject *CurrentOwner();
+    static void Sleep(unsigned long msecs);
+
+    template<typename T>
+    static void Start(T *thread){
+        if(IsEnabled())
+            GetInstance()->spawn(&RunThread<T>, thread, thread);
+        else
+            thread->start();
+    }
+
+    ~RoomScheduler();
+
+    void spawn(Entry entry, void *arg, const QObject *owner);
+    RoomTask *currentTask() const;
+    void park();
+    void wake(RoomTask *task);
+
+    int getWorkerCount() const;
+    int getTaskCount() const;
+    int getParkedCount() const;
+
+private:
+    explicit RoomScheduler(QObject *parent);
+
+    template<typename T>
+    static void RunThread(void *arg){
+        T *thread = static_cast<T *>(arg);
+        emit thread->started();
+        thread->run();
+        emit thread->finished();
+    }
+
+    friend class RoomWorker;
+    RoomTask *takeTask();
+    void suspended(RoomTask *task);
+    void sleepTask(RoomTask *task, unsigned long msecs);
+
+    static bool enabled;
+
+    bool stopped;
+    QList<RoomWorker *> workers;
+    QList<RoomTask *> ready;
+    QList<RoomTask *> sleepers;
+    int task_count;
+    int parked_count;
+
+    mutable QMutex mutex;
+    QWaitCondition condition;
+};
+
+// a semaphore which parks the current task instead of blocking its thread
+class TaskSemaphore{
+public:
+    explicit TaskSemaphore(int n = 0);
+
+    void acquire(int n = 1);
+    void release(int n = 1);
+    int available() const;
+
+private:
+    int avail;
+    QList<RoomTask *> parked;
+    mutable QMutex mutex;
+    QWaitCondition condition;
+};
+
+#endif // ROOMSCHEDULER_H
@@ -0,0 +1,446 @@
+#include "roomstate.h"
+#include "room.h"
+#include "serverplayer.h"
+#include "engine.h"
+#include "cardpile.h"
+
+class PlayerStateData: public QSharedData{
+public:
+    QString object_name;
+    QString general_name, general2_name;
+    QString kingdom, role;
+    int seat;
+    int hp, max_hp;
+    bool alive;
+    Player::Phase phase;
+    bool face_up, chained;
+
+    QList<int> handcards, equips, judging_area;
+    QMap<QString, QList<int> > piles;
+    QMap<QString, int> marks;
+    QSet<QString> flags;
+    QSet<QString> acquired_skills;
+    QHash<QString, int> history;
+    QVariantMap tag;
+};
+
+class RoomStateData: public QSharedData{
+public:
+    QList<PlayerState> players;
+    int current;
+
+    CardPile draw_pile, discard_pile, table_cards;
+    QVector<Player::Place> place_table;
+    QVector<int> owner_table;
+
+    QVariantMap tag;
+};
+
+PlayerState::PlayerState()
+    :d(new PlayerStateData)
+{
+    d->seat = 0;
+    d->hp = d->max_hp = 0;
+    d->alive = false;
+    d->phase = Player::NotActive;
+    d->face_up = true;
+    d->chained = false;
+}
+
+PlayerState::PlayerState(const ServerPlayer *player)
+    :d(new PlayerStateData)
+{
+    d->object_name = player->objectName();
+    d->general_name = player->getGeneralName();
+    d->general2_name = player->getGeneral2Name();
+    d->kingdom = player->getKingdom();
+    d->role = player->getRole();
+    d->seat = player->getSeat();
+    d->hp = player->getHp();
+    d->max_hp = player->getMaxHP();
+    d->alive = player->isAlive();
+    d->phase = player->getPhase();
+    d->face_up = player->faceUp();
+    d->chained = player->isChained();
+
+    d->handcards = player->handCards();
+    foreach(const Card *card, player->getEquips())
+        d->equips << card->getId();
+    foreach(const Card *card, player->getJudgingArea())
+        d->judging_area << card->getId();
+
+    const Player *base = player;
+    d->piles = base->piles;
+    d->marks = base->marks;
+    d->flags = base->flags;
+    d->acquired_skills = base->acquired_skills;
+    d->history = base->history;
+    d->tag = base->tag;
+}
+
+PlayerState::PlayerState(const PlayerState &other)
+    :d(other.d)
+{
+}
+
+PlayerState &PlayerState::operator =(const PlayerState &other){
+    d = other.d;
+    return *this;
+}
+
+PlayerState::~PlayerState(){
+}
+
+QString PlayerState::objectName() const{
+    return d->object_name;
+}
+
+QString PlayerState::getGeneralName() const{
+    return d->general_name;
+}
+
+QString PlayerState::getGeneral2Name() const{
+    return d->general2_name;
+}
+
+QString PlayerState::getKingdom() const{
+    return d->kingdom;
+}
+
+QString PlayerState::getRole() const{
+    return d->role;
+}
+
+int PlayerState::getSeat() const{
+    return d->seat;
+}
+
+int PlayerState::getHp() const{
+    return d->hp;
+}
+
+void PlayerState::setHp(int hp){
+    if(hp <= d->max_hp)
+        d->hp = hp;
+}
+
+int PlayerState::getMaxHP() const{
+    return d->max_hp;
+}
+
+void PlayerState::setMaxHP(int max_hp){
+    d->max_hp = max_hp;
+    if(d->hp > max_hp)
+        d->hp = max_hp;
+}
+
+int PlayerState::getLostHp() const{
+    return d->max_hp - qMax(d->hp, 0);
+}
+
+bool PlayerState::isWounded() const{
+    return d->hp < 0 || d->hp < d->max_hp;
+}
+
+bool PlayerState::isAlive() const{
+    return d->alive;
+}
+
+void PlayerState::setAlive(bool alive){
+    d->alive = alive;
+}
+
+Player::Phase PlayerState::getPhase() const{
+    return d->phase;
+}
+
+void PlayerState::setPhase(Player::Phase phase){
+    d->phase = phase;
+}
+
+bool PlayerState::faceUp() const{
+    return d->face_up;
+}
+
+void PlayerState::setFaceUp(bool face_up){
+    d->face_up = face_up;
+}
+
+bool PlayerState::isChained() const{
+    return d->chained;
+}
+
+void PlayerState::setChained(bool chained){
+    d->chained = chained;
+}
+
+QList<int> PlayerState::handCards() const{
+    return d->handcards;
+}
+
+int PlayerState::getHandcardNum() const{
+    return d->handcards.length();
+}
+
+QList<int> PlayerState::getEquips() const{
+    return d->equips;
+}
+
+QList<int> PlayerState::getJudgingArea() const{
+    return d->judging_area;
+}
+
+QList<int> PlayerState::getPile(const QString &pile_name) const{
+    return d->piles.value(pile_name);
+}
+
+QStringList PlayerState::getPileNames() const{
+    return d->piles.keys();
+}
+
+int PlayerState::getMark(const QString &mark) const{
+    return d->marks.value(mark, 0);
+}
+
+void PlayerState::setMark(const QString &mark, int value){
+    d->marks[mark] = value;
+}
+
+bool PlayerState::hasFlag(const QString &flag) const{
+    return d->flags.contains(flag);
+}
+
+void PlayerState::setFlags(const QString &flag){
+    if(flag.startsWith("-"))
+        d->flags.remove(flag.mid(1));
+    else
+        d->flags.insert(flag);
+}
+
+bool PlayerState::hasSkill(const QString &skill_name) const{
+    if(d->acquired_skills.contains(skill_name))
+        return true;
+
+    const General *general = Sanguosha->getGeneral(d->general_name);
+    if(general && general->hasSkill(skill_name))
+        return true;
+
+    const General *general2 = Sanguosha->getGeneral(d->general2_name);
+    return general2 && general2->hasSkill(skill_name);
+}
+
+int PlayerState::usedTimes(const QString &card_class) const{
+    return d->history.value(card_class, 0);
+}
+
+QVariant PlayerState::getTag(const QString &key) const{
+    return d->tag.value(key);
+}
+
+void PlayerState::setTag(const QString &key, const QVariant &value){
+    d->tag.insert(key, value);
+}
+
+void PlayerState::addCard(int card_id, Player::Place place, const QString &pile_name){
+    switch(place){
+    case Player::Hand: d->handcards << card_id; break;
+    case Player::Equip: d->equips << card_id; break;
+    case Player::Judging: d->judging_area << card_id; break;
+    case Player::Special: d->piles[pile_name] << card_id; break;
+    default:
+        break;
+    }
+}
+
+void PlayerState::removeCard(int card_id){
+    if(d->handcards.removeOne(card_id) || d->equips.removeOne(card_id) || d->judging_area.removeOne(card_id))
+        return;
+
+    QMutableMapIterator<QString, QList<int> > itor(d->piles);
+    while(itor.hasNext()){
+        itor.next();
+        if(itor.value().removeOne(card_id))
+            return;
+    }
+}
+
+// -------------------------------------------
+
+RoomState::RoomState()
+    :d(new RoomStateData)
+{
+    d->current = -1;
+}
+
+RoomState::RoomState(const Room *room)
+    :d(new RoomStateData)
+{
+    foreach(ServerPlayer *player, room->players)
+        d->players << PlayerState(player);
+
+    d->current = room->players.indexOf(room->current);
+
+    d->draw_pile = *room->draw_pile;
+    d->discard_pile = *room->discard_pile;
+    d->table_cards = room->table_cards;
+    d->place_table = room->place_table;
+
+    // owners are kept as indices, so that a copy does not refer to the room
+    d->owner_table.fill(-1, room->owner_table.size());
+    int i;
+    for(i=0; i<room->owner_table.size(); i++){
+        ServerPlayer *owner = room->owner_table.at(i);
+        if(owner)
+            d->owner_table[i] = room->players.indexOf(owner);
+    }
+
+    d->tag = room->tag;
+}
+
+RoomState::RoomState(const RoomState &other)
+    :d(other.d)
+{
+}
+
+RoomState &RoomState::operator =(const RoomState &other){
+    d = other.d;
+    return *this;
+}
+
+RoomState::~RoomState(){
+}
+
+int RoomState::playerCount() const{
+    return d->players.length();
+}
+
+int RoomState::alivePlayerCount() const{
+    int n = 0;
+    foreach(PlayerState player, d->players){
+        if(player.isAlive())
+            n++;
+    }
+
+    return n;
+}
+
+int RoomState::indexOf(const QString &object_name) const{
+    int i;
+    for(i=0; i<d->players.length(); i++){
+        if(d->players.at(i).objectName() == object_name)
+            return i;
+    }
+
+    return -1;
+}
+
+const PlayerState *RoomState::getPlayer(int index) const{
+    if(index < 0 || index >= d->players.length())
+        return NULL;
+
+    return &d->players.at(index);
+}
+
+PlayerState *RoomState::getPlayer(int index){
+    if(index < 0 || index >= d->players.length())
+        return NULL;
+
+    return &d->players[index];
+}
+
+int RoomState::getCurrent() const{
+    return d->current;
+}
+
+void RoomState::setCurrent(int index){
+    d->current = index;
+}
+
+Player::Place RoomState::getCardPlace(int card_id) const{
+    return d->place_table.value(card_id);
+}
+
+int RoomState::getCardOwner(int card_id) const{
+    return d->owner_table.value(card_id, -1);
+}
+
+void RoomState::takeCard(int card_id){
+    int owner = getCardOwner(card_id);
+    if(owner != -1){
+        d->players[owner].removeCard(card_id);
+        return;
+    }
+
+    switch(getCardPlace(card_id)){
+    case Player::DiscardedPile: d->discard_pile.removeOne(card_id); break;
+    case Player::DrawPile: d->draw_pile.removeOne(card_id); break;
+    case Player::Special: d->table_cards.removeOne(card_id); break;
+    default:
+        break;
+    }
+}
+
+void RoomState::moveCard(int card_id, int to, Player::Place place){
+    if(card_id < 0 || card_id >= d->place_table.size())
+        return;
+
+    takeCard(card_id);
+
+    if(to >= 0 && to < d->players.length()){
+        d->players[to].addCard(card_id, place);
+    }else{
+        to = -1;
+        switch(place){
+        case Player::DiscardedPile: d->discard_pile.prepend(card_id); break;
+        case Player::DrawPile: d->draw_pile.prepend(card_id); break;
+        case Player::Special: d->table_cards.append(card_id); break;
+        default:
+            break;
+        }
+    }
+
+    d->place_table[card_id] = place;
+    d->owner_table[card_id] = to;
+}
+
+void RoomState::addToPile(int card_id, int to, const QString &pile_name){
+    if(card_id < 0 || card_id >= d->place_table.size() || to < 0 || to >= d->players.length())
+        return;
+
+    takeCard(card_id);
+    d->players[to].addCard(card_id, Player::Special, pile_name);
+
+    d->place_table[card_id] = Player::Special;
+    d->owner_table[card_id] = to;
+}
+
+QList<int> RoomState::drawCards(int index, int n){
+    QList<int> card_ids;
+    while(card_ids.length() < n && !d->draw_pile.isEmpty()){
+        int card_id = d->draw_pile.takeFirst();
+        moveCard(card_id, index, Player::Hand);
+        card_ids << card_id;
+    }
+
+    return card_ids;
+}
+
+QList<int> RoomState::getDrawPile() const{
+    return d->draw_pile.toList();
+}
+
+QList<int> RoomState::getDiscardPile() const{
+    return d->discard_pile.toList();
+}
+
+int RoomState::getDrawPileNum() const{
+    return d->draw_pile.length();
+}
+
+QVariant RoomState::getTag(const QString &key) const{
+    return d->tag.value(key);
+}
+
+void RoomState::setTag(const QString &key, const QVariant &value){
+    d->tag.insert(key, value);
+}
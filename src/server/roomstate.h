@@ -0,0 +1,109 @@
+#ifndef ROOMSTATE_H
+#define ROOMSTATE_H
+
+class Room;
+class ServerPlayer;
+class PlayerStateData;
+class RoomStateData;
+
+#include "player.h"
+
+#include <QSharedDataPointer>
+#include <QVariant>
+
+// a detached copy of one player, shared with its copies until one of them is modified
+class PlayerState{
+public:
+    PlayerState();
+    explicit PlayerState(const ServerPlayer *player);
+    PlayerState(const PlayerState &other);
+    PlayerState &operator =(const PlayerState &other);
+    ~PlayerState();
+
+    QString objectName() const;
+    QString getGeneralName() const;
+    QString getGeneral2Name() const;
+    QString getKingdom() const;
+    QString getRole() const;
+    int getSeat() const;
+
+    int getHp() const;
+    void setHp(int hp);
+    int getMaxHP() const;
+    void setMaxHP(int max_hp);
+    int getLostHp() const;
+    bool isWounded() const;
+
+    bool isAlive() const;
+    void setAlive(bool alive);
+    Player::Phase getPhase() const;
+    void setPhase(Player::Phase phase);
+    bool faceUp() const;
+    void setFaceUp(bool face_up);
+    bool isChained() const;
+    void setChained(bool chained);
+
+    QList<int> handCards() const;
+    int getHandcardNum() const;
+    QList<int> getEquips() const;
+    QList<int> getJudgingArea() const;
+    QList<int> getPile(const QString &pile_name) const;
+    QStringList getPileNames() const;
+
+    int getMark(const QString &mark) const;
+    void setMark(const QString &mark, int value);
+    bool hasFlag(const QString &flag) const;
+    void setFlags(const QString &flag);
+    bool hasSkill(const QString &skill_name) const;
+    int usedTimes(const QString &card_class) const;
+
+    QVariant getTag(const QString &key) const;
+    void setTag(const QString &key, const QVariant &value);
+
+private:
+    friend class RoomState;
+    QSharedDataPointer<PlayerStateData> d;
+
+    void addCard(int card_id, Player::Place place, const QString &pile_name = QString());
+    void removeCard(int card_id);
+};
+
+// a snapshot of a room for "what if" simulation, it has no threads, sockets or Lua state,
+// copying it only copies a pointer and the data is detached when a copy is modified
+class RoomState{
+public:
+    RoomState();
+    explicit RoomState(const Room *room);
+    RoomState(const RoomState &other);
+    RoomState &operator =(const RoomState &other);
+    ~RoomState();
+
+    int playerCount() const;
+    int alivePlayerCount() const;
+    int indexOf(const QString &object_name) const;
+    const PlayerState *getPlayer(int index) const;
+    PlayerState *getPlayer(int index);
+
+    int getCurrent() const;
+    void setCurrent(int index);
+
+    Player::Place getCardPlace(int card_id) const;
+    int getCardOwner(int card_id) const;
+    void moveCard(int card_id, int to, Player::Place place);
+    void addToPile(int card_id, int to, const QString &pile_name);
+    QList<int> drawCards(int index, int n);
+
+    QList<int> getDrawPile() const;
+    QList<int> getDiscardPile() const;
+    int getDrawPileNum() const;
+
+    QVariant getTag(const QString &key) const;
+    void setTag(const QString &key, const QVariant &value);
+
+private:
+    QSharedDataPointer<RoomStateData> d;
+
+    void takeCard(int card_id);
+};
+
+#endif // ROOMSTATE_H
@@ -3,7 +3,6 @@
 #include "engine.h"
 #include "gamerule.h"
 #include "ai.h"
-#include "settings.h"
 
 #include <QTime>
 
@@ -150,11 +149,23 @@ QString EventTriplet::toString() const{
 RoomThread::RoomThread(Room *room)
     :QThread(room), room(room)
 {
+    int i;
+    for(i=0; i<NumOfEvents; i++){
+        trigger_count[i] = 0;
+        triggerable_count[i] = 0;
+    }
+}
+
+Room *RoomThread::getRoom() const{
+    return room;
 }
 
 void RoomThread::addPlayerSkills(ServerPlayer *player, bool invoke_game_start){
     QVariant void_data;
 
+    // the player may already own skills that are in the table (e.g. after transfiguring)
+    updatePlayerSkills(player);
+
     foreach(const TriggerSkill *skill, player->getTriggerSkills()){
         addTriggerSkill(skill);
 
@@ -245,7 +256,7 @@ void RoomThread::action3v3(ServerPlayer *player){
 }
 
 void RoomThread::run(){
-    qsrand(QTime(0,0,0).secsTo(QTime::currentTime()));
+    qsrand(uint(room->getRandomSeed()));
 
     if(setjmp(env) == GameOver){
         quit();
@@ -326,19 +337,59 @@ void RoomThread::run(){
     }
 }
 
-static bool CompareByPriority(const TriggerSkill *a, const TriggerSkill *b){
-    return a->getPriority() > b->getPriority();
+bool RoomThread::comesBefore(const TriggerSkill *a, const TriggerSkill *b) const{
+    int priority_a = a->getPriority();
+    int priority_b = b->getPriority();
+    if(priority_a != priority_b)
+        return priority_a > priority_b;
+
+    // same priority, keep the order in which they were added
+    return skill_order.value(a) < skill_order.value(b);
+}
+
+QList<const TriggerSkill *> RoomThread::getSkillsFor(TriggerEvent event, const ServerPlayer *target) const{
+    const QList<const TriggerSkill *> &globals = skill_table[event];
+    if(target == NULL)
+        return globals;
+
+    const QList<const TriggerSkill *> owned = owner_table[event].value(target);
+    if(owned.isEmpty())
+        return globals;
+    else if(globals.isEmpty())
+        return owned;
+
+    // merge the two sorted lists
+    QList<const TriggerSkill *> skills;
+    int i = 0, j = 0;
+    while(i < globals.length() && j < owned.length()){
+        if(comesBefore(owned.at(j), globals.at(i)))
+            skills << owned.at(j++);
+        else
+            skills << globals.at(i++);
+    }
+
+    while(i < globals.length())
+        skills << globals.at(i++);
+
+    while(j < owned.length())
+        skills << owned.at(j++);
+
+    return skills;
 }
 
 bool RoomThread::trigger(TriggerEvent event, ServerPlayer *target, QVariant &data){
-    Q_ASSERT(QThread::currentThread() == this);
+    Q_ASSERT(RoomScheduler::IsCurrent(this));
 
     // push it to event stack
     EventTriplet triplet(event, target, &data);
     event_stack.push_back(triplet);
 
+    trigger_count[event]++;
+
     bool broken = false;
-    foreach(const TriggerSkill *skill, skill_table[event]){
+    foreach(const TriggerSkill *skill, getSkillsFor(event, target)){
+        triggerable_count[event]++;
+
         if(skill->triggerable(target)){
             broken = skill->trigger(event, target, data);
             if(broken)
@@ -346,14 +397,16 @@ bool RoomThread::trigger(TriggerEvent event, ServerPlayer *target, QVariant &dat
         }
     }
 
-    if(target){
-        foreach(AI *ai, room->ais)
-            ai->filterEvent(event, target, data);
-    }
+    if(target)
+        room->filterEvents(event, target, data);
 
     // pop event stack
     event_stack.pop_back();
 
+    // one game step is over
+    if(event_stack.isEmpty())
+        room->flushMessages();
+
     return broken;
 }
 
@@ -366,18 +419,84 @@ bool RoomThread::trigger(TriggerEvent event, ServerPlayer *target){
     return trigger(event, target, data);
 }
 
+int RoomThread::getTriggerCount(TriggerEvent event) const{
+    return trigger_count[event];
+}
+
+int RoomThread::getTriggerableCount(TriggerEvent event) const{
+    return triggerable_count[event];
+}
+
+void RoomThread::outputTriggerStatistics() const{
+    int total_triggers = 0, total_calls = 0;
+    int i;
+    for(i=0; i<NumOfEvents; i++){
+        if(trigger_count[i] == 0)
+            continue;
+
+        total_triggers += trigger_count[i];
+        total_calls += triggerable_count[i];
+
+        room->output(QString("event %1: %2 triggers, %3 triggerable calls, %4 per trigger")
+                     .arg(i).arg(trigger_count[i]).arg(triggerable_count[i])
+                     .arg(double(triggerable_count[i]) / trigger_count[i], 0, 'f', 2));
+    }
+
+    room->output(QString("total: %1 triggers, %2 triggerable calls, %3 global skills, %4 owned skills")
+                 .arg(total_triggers).arg(total_calls)
+                 .arg(skill_order.size() - owned_skills.length()).arg(owned_skills.length()));
+}
+
+void RoomThread::addOwnerSkill(const ServerPlayer *player, const TriggerSkill *skill){
+    foreach(TriggerEvent event, skill->getTriggerEvents()){
+        QList<const TriggerSkill *> &table = owner_table[event][player];
+        if(table.contains(skill))
+            continue;
+
+        int i = 0;
+        while(i < table.length() && !comesBefore(skill, table.at(i)))
+            i++;
+
+        table.insert(i, skill);
+    }
+}
+
+void RoomThread::updatePlayerSkills(ServerPlayer *player){
+    int i;
+    for(i=0; i<NumOfEvents; i++)
+        owner_table[i].remove(player);
+
+    foreach(const TriggerSkill *skill, owned_skills){
+        if(player->hasSkill(skill->objectName()))
+            addOwnerSkill(player, skill);
+    }
+}
+
 void RoomThread::addTriggerSkill(const TriggerSkill *skill){
-    if(skillSet.contains(skill))
+    if(skill == NULL || skill_order.contains(skill))
         return;
 
-    skillSet << skill;
+    skill_order.insert(skill, skill_order.size());
+
+    if(skill->isGlobal()){
+        QList<TriggerEvent> events = skill->getTriggerEvents();
+        foreach(TriggerEvent event, events){
+            QList<const TriggerSkill *> &table = skill_table[event];
 
-    QList<TriggerEvent> events = skill->getTriggerEvents();
-    foreach(TriggerEvent event, events){
-        QList<const TriggerSkill *> &table = skill_table[event];
+            int i = 0;
+            while(i < table.length() && !comesBefore(skill, table.at(i)))
+                i++;
 
-        table << skill;
-        qStableSort(table.begin(), table.end(), CompareByPriority);
+            table.insert(i, skill);
+        }
+    }else{
+        // a non-global skill can only be triggered by players who have it
+        owned_skills << skill;
+
+        foreach(ServerPlayer *player, room->players){
+            if(player->hasSkill(skill->objectName()))
+                addOwnerSkill(player, skill);
+        }
     }
 
     if(skill->isVisible()){
@@ -389,10 +508,14 @@ void RoomThread::addTriggerSkill(const TriggerSkill *skill){
 }
 
 void RoomThread::delay(unsigned long secs){
-    if(room->property("to_test").toString().isEmpty()&&Config.value("AIDelay",1000).toInt()>0)
-        msleep(secs);
+    room->flushMessages();
+
+    if(room->property("to_test").toString().isEmpty() && !room->property("simulate").toBool()
+            && !room->property("no_delay").toBool() && room->getConfig().AIDelay > 0)
+        RoomScheduler::Sleep(secs);
 }
 
 void RoomThread::end(){
+    room->flushMessages();
     longjmp(env, GameOver);
 }
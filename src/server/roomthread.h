@@ -4,6 +4,7 @@
 #include <QThread>
 #include <QSemaphore>
 #include <QVariant>
+#include <QHash>
 
 #include <csetjmp>
 
@@ -37,12 +38,16 @@ class RoomThread : public QThread{
     Q_OBJECT
 
 public:
+    friend class RoomScheduler;
+
     explicit RoomThread(Room *room);
+    Room *getRoom() const;
     void constructTriggerTable(const GameRule *rule);
     bool trigger(TriggerEvent event, ServerPlayer *target, QVariant &data);
     bool trigger(TriggerEvent event, ServerPlayer *target);
 
     void addPlayerSkills(ServerPlayer *player, bool invoke_game_start = false);
+    void updatePlayerSkills(ServerPlayer *player);
 
     void addTriggerSkill(const TriggerSkill *skill);
     void delay(unsigned long msecs = 1000);
@@ -52,6 +57,10 @@ public:
 
     const QList<EventTriplet> *getEventStack() const;
 
+    int getTriggerCount(TriggerEvent event) const;
+    int getTriggerableCount(TriggerEvent event) const;
+    void outputTriggerStatistics() const;
+
 protected:
     virtual void run();
 
@@ -60,10 +69,20 @@ private:
     jmp_buf env;
     QString order;
 
+    // global skills are tried on every target, the others only on their owners
     QList<const TriggerSkill *> skill_table[NumOfEvents];
-    QSet<const TriggerSkill *> skillSet;
+    QHash<const ServerPlayer *, QList<const TriggerSkill *> > owner_table[NumOfEvents];
+    QList<const TriggerSkill *> owned_skills;
+    QHash<const TriggerSkill *, int> skill_order;
+
+    int trigger_count[NumOfEvents];
+    int triggerable_count[NumOfEvents];
 
     QList<EventTriplet> event_stack;
+
+    bool comesBefore(const TriggerSkill *a, const TriggerSkill *b) const;
+    void addOwnerSkill(const ServerPlayer *player, const TriggerSkill *skill);
+    QList<const TriggerSkill *> getSkillsFor(TriggerEvent event, const ServerPlayer *target) const;
 };
 
 #endif // ROOMTHREAD_H
@@ -1,7 +1,6 @@
 #include "roomthread1v1.h"
 #include "room.h"
 #include "engine.h"
-#include "settings.h"
 #include "generalselector.h"
 
 #include <QDateTime>
@@ -14,10 +13,10 @@ RoomThread1v1::RoomThread1v1(Room *room)
 
 void RoomThread1v1::run(){
     // initialize the random seed for this thread
-    qsrand(QTime(0,0,0).secsTo(QTime::currentTime()));
+    qsrand(uint(room->getRandomSeed()));
 
-    QSet<QString> banset = Config.value("Banlist/1v1").toStringList().toSet();
-    general_names = Sanguosha->getRandomGenerals(10, banset);
+    const RoomConfig &config = room->getConfig();
+    general_names = Sanguosha->getRandomGenerals(10, config.Ban1v1Set, room->getRandomGenerator(), &config);
 
     QStringList known_list = general_names.mid(0, 6);
     unknown_list = general_names.mid(6, 4);
@@ -46,7 +45,7 @@ void RoomThread1v1::run(){
     startArrange(first);
     startArrange(next);
 
-    room->sem->acquire(2);
+    room->waitForReply("arrangeCommand", 2);
 }
 
 void RoomThread1v1::askForTakeGeneral(ServerPlayer *player){
@@ -59,16 +58,26 @@ void RoomThread1v1::askForTakeGeneral(ServerPlayer *player){
     }
 
     if(name.isNull()){
+        room->expectSelection(player, "takeGeneralCommand");
         player->invoke("askForGeneral1v1");
+        room->waitForReply("takeGeneralCommand");
     }else{
-        msleep(1000);
+        RoomScheduler::Sleep(1000);
         takeGeneral(player, name);
-    }
 
-    room->sem->acquire();
+        room->flushMessages();
+        room->sem->acquire();
+    }
 }
 
-void RoomThread1v1::takeGeneral(ServerPlayer *player, const QString &name){
+void RoomThread1v1::takeGeneral(ServerPlayer *player, const QString &taken){
+    // the server takes for a player who has not taken in time
+    QString name = taken;
+    if(!general_names.contains(name))
+        name = GeneralSelector::GetInstance()->select1v1(general_names);
+    if(!general_names.contains(name))
+        name = general_names.first();
+
     QString group = player->isLord() ? "warm" : "cool";
     room->broadcastInvoke("takeGeneral", QString("%1:%2").arg(group).arg(name), player);
 
@@ -94,11 +103,17 @@ void RoomThread1v1::startArrange(ServerPlayer *player){
         GeneralSelector *selector = GeneralSelector::GetInstance();
         arrange(player, selector->arrange1v1(player));
     }else{
+        room->expectSelection(player, "arrangeCommand");
         player->invoke("startArrange");
     }
 }
 
-void RoomThread1v1::arrange(ServerPlayer *player, const QStringList &arranged){
+void RoomThread1v1::arrange(ServerPlayer *player, const QStringList &generals){
+    // the server arranges for a player who has not arranged in time
+    QStringList arranged = generals;
+    if(arranged.length() != 3)
+        arranged = GeneralSelector::GetInstance()->arrange1v1(player);
+
     Q_ASSERT(arranged.length() == 3);
 
     QStringList left = arranged.mid(1, 2);
@@ -12,6 +12,8 @@ class RoomThread1v1 : public QThread
     Q_OBJECT
 
 public:
+    friend class RoomScheduler;
+
     explicit RoomThread1v1(Room *room);
     void takeGeneral(ServerPlayer *player, const QString &name);
     void arrange(ServerPlayer *player, const QStringList &arranged);
@@ -3,7 +3,6 @@
 #include "engine.h"
 #include "ai.h"
 #include "lua.hpp"
-#include "settings.h"
 #include "generalselector.h"
 
 #include <QDateTime>
@@ -46,10 +45,10 @@ QStringList RoomThread3v3::getGeneralsWithoutExtension() const{
 void RoomThread3v3::run()
 {
     // initialize the random seed for this thread
-    qsrand(QTime(0,0,0).secsTo(QTime::currentTime()));
+    qsrand(uint(room->getRandomSeed()));
 
-    QString scheme = Config.value("3v3/RoleChoose", "Normal").toString();
-    assignRoles(scheme);
+    const RoomConfig &config = room->getConfig();
+    assignRoles(config.RoleChoose3v3);
     room->adjustSeats();
 
     foreach(ServerPlayer *player, room->players){
@@ -61,12 +60,12 @@ void RoomThread3v3::run()
         }
     }
 
-    if(Config.value("3v3/UsingExtension", false).toBool())
-        general_names = Config.value("3v3/ExtensionGenerals").toStringList();
+    if(config.UsingExtension3v3)
+        general_names = config.ExtensionGenerals3v3;
     else
         general_names = getGeneralsWithoutExtension();
 
-    qShuffle(general_names);
+    qShuffle(general_names, room->getRandomGenerator());
     general_names = general_names.mid(0, 16);
 
     room->broadcastInvoke("fillGenerals", general_names.join("+"));
@@ -95,7 +94,7 @@ void RoomThread3v3::run()
     startArrange(first);
     startArrange(next);
 
-    room->sem->acquire(2);
+    room->waitForReply("arrangeCommand", 2);
 }
 
 void RoomThread3v3::askForTakeGeneral(ServerPlayer *player){
@@ -104,16 +103,26 @@ void RoomThread3v3::askForTakeGeneral(ServerPlayer *player){
         name = GeneralSelector::GetInstance()->select3v3(player, general_names);
 
     if(name.isNull()){
+        room->expectSelection(player, "takeGeneralCommand");
         player->invoke("askForGeneral3v3");
+        room->waitForReply("takeGeneralCommand");
     }else{
-        msleep(1000);
+        RoomScheduler::Sleep(1000);
         takeGeneral(player, name);
-    }
 
-    room->sem->acquire();
+        room->flushMessages();
+        room->sem->acquire();
+    }
 }
 
-void RoomThread3v3::takeGeneral(ServerPlayer *player, const QString &name){
+void RoomThread3v3::takeGeneral(ServerPlayer *player, const QString &taken){
+    // the server takes for a player who has not taken in time
+    QString name = taken;
+    if(!general_names.contains(name))
+        name = GeneralSelector::GetInstance()->select3v3(player, general_names);
+    if(!general_names.contains(name))
+        name = general_names.first();
+
     general_names.removeOne(name);
     player->addToSelected(name);
 
@@ -128,11 +137,17 @@ void RoomThread3v3::startArrange(ServerPlayer *player){
         GeneralSelector *selector = GeneralSelector::GetInstance();
         arrange(player, selector->arrange3v3(player));
     }else{
+        room->expectSelection(player, "arrangeCommand");
         player->invoke("startArrange");        
     }
 }
 
-void RoomThread3v3::arrange(ServerPlayer *player, const QStringList &arranged){
+void RoomThread3v3::arrange(ServerPlayer *player, const QStringList &generals){
+    // the server arranges for a player who has not arranged in time
+    QStringList arranged = generals;
+    if(arranged.length() != 3)
+        arranged = GeneralSelector::GetInstance()->arrange3v3(player);
+
     Q_ASSERT(arranged.length() == 3);
 
     if(player->isLord()){
@@ -183,7 +198,7 @@ void RoomThread3v3::assignRoles(const QStringList &roles, const QString &scheme)
     }
 
     if(!abstained.isEmpty()){
-        qShuffle(abstained);
+        qShuffle(abstained, room->getRandomGenerator());
 
         for(i=0; i<6; i++){
             if(new_players.at(i) == NULL){
@@ -207,7 +222,7 @@ void RoomThread3v3::assignRoles(const QString &scheme){
 
     if(scheme == "Random"){
         // the easiest way
-        qShuffle(room->players);
+        qShuffle(room->players, room->getRandomGenerator());
 
         int i;
         for(i=0; i<roles.length(); i++)
@@ -221,7 +236,7 @@ void RoomThread3v3::assignRoles(const QString &scheme){
         assignRoles(all_roles, scheme);
 
         QMap<QString, QString> map;
-        if(qrand() % 2 == 0){
+        if(room->getRandomGenerator()->bounded(2) == 0){
             map["leader1"] = "lord";
             map["guard1"] = "loyalist";
             map["leader2"] = "renegade";
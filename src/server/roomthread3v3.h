@@ -13,6 +13,8 @@ class RoomThread3v3 : public QThread
     Q_OBJECT
 
 public:
+    friend class RoomScheduler;
+
     explicit RoomThread3v3(Room *room);
     void takeGeneral(ServerPlayer *player, const QString &name);
     void arrange(ServerPlayer *player, const QStringList &arranged);
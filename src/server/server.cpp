@@ -8,6 +8,8 @@
 #include "contestdb.h"
 #include "choosegeneraldialog.h"
 #include "customassigndialog.h"
+#include "luastatepool.h"
+#include "roomscheduler.h"
 
 #include <QInputDialog>
 #include <QMessageBox>
@@ -22,6 +24,8 @@
 #include <QApplication>
 #include <QHttp>
 #include <QAction>
+#include <cstdio>
+#include <cstring>
 
 static QLayout *HLay(QWidget *left, QWidget *right){
     QHBoxLayout *layout = new QHBoxLayout;
@@ -935,6 +939,9 @@ Server::Server(QObject *parent)
     //synchronize ServerInfo on the server side to avoid ambiguous usage of Config and ServerInfo
     ServerInfo.parse(Sanguosha->getSetupString());
 
+    // start warming up Lua states for the rooms to come
+    LuaStatePool::GetInstance();
+
     createNewRoom();
 
     connect(server, SIGNAL(new_connection(ClientSocket*)), this, SLOT(processNewConnection(ClientSocket*)));
@@ -973,6 +980,19 @@ Room *Server::createNewRoom(){
     connect(current, SIGNAL(room_message(QString)), this, SIGNAL(server_message(QString)));
     connect(current, SIGNAL(game_over(QString)), this, SLOT(gameOver()));
 
+    if(RoomScheduler::IsEnabled()){
+        // the number of worker threads should stay the same however many rooms there are
+        RoomScheduler *scheduler = RoomScheduler::GetInstance();
+        QString message = tr("%1 rooms, %2 room tasks (%3 waiting) on %4 worker threads")
+                          .arg(rooms.size())
+                          .arg(scheduler->getTaskCount())
+                          .arg(scheduler->getParkedCount())
+                          .arg(scheduler->getWorkerCount());
+
+        emit server_message(message);
+        printf("%s\n", qPrintable(message));
+    }
+
     return current;
 }
 
@@ -988,7 +1008,11 @@ void Server::processNewConnection(ClientSocket *socket){
     }
 
     connect(socket, SIGNAL(disconnected()), this, SLOT(cleanup()));
-    socket->send("checkVersion " + Sanguosha->getVersion());
+    // the binary frames are offered after the MOD name, where the old clients do not look
+    QString version = Sanguosha->getVersion();
+    if(Config.value("BinaryProtocol", true).toBool())
+        version = QString("%1:%2:binary").arg(Sanguosha->getVersionNumber()).arg(Sanguosha->getMODName());
+    socket->send("checkVersion " + version);
     socket->send("setup " + Sanguosha->getSetupString());
     emit server_message(tr("%1 connected").arg(socket->peerName()));
 
@@ -1002,6 +1026,18 @@ static inline QString ConvertFromBase64(const QString &base64){
 
 void Server::processRequest(char *request){
     ClientSocket *socket = qobject_cast<ClientSocket *>(sender());
+
+    // a client may ask for binary frames before it signs up
+    if(strncmp(request, "protocol ", 9) == 0){
+        if(strcmp(request, "protocol binary\n") == 0 && Config.value("BinaryProtocol", true).toBool()){
+            socket->send("protocol binary");
+            socket->setBinary(true);
+        }else
+            socket->send("protocol text");
+
+        return;
+    }
+
     socket->disconnect(this, SLOT(processRequest(char*)));
 
     QRegExp rx("(signupr?) (.+):(.+)(:.+)?\n");
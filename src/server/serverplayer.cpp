@@ -3,18 +3,22 @@
 #include "engine.h"
 #include "standard.h"
 #include "ai.h"
-#include "settings.h"
 #include "recorder.h"
 #include "banpair.h"
 
+#include <QThread>
+
 ServerPlayer::ServerPlayer(Room *room)
     : Player(room), socket(NULL), room(room),
-    ai(NULL), trust_ai(new TrustAI(this)), recorder(NULL), next(NULL)
+    ai(NULL), trust_ai(new TrustAI(this)), recorder(NULL), next(NULL),
+    flush_count(0), flushed_messages(0)
 {
+    setDistanceMatrix(room->getDistanceMatrix());
 }
 
 void ServerPlayer::drawCard(const Card *card){
     handcards << card;
+    invalidateDistances();
 }
 
 Room *ServerPlayer::getRoom() const{
@@ -43,7 +47,7 @@ int ServerPlayer::getRandomHandCardId() const{
 }
 
 const Card *ServerPlayer::getRandomHandCard() const{
-    int index = qrand() % handcards.length();
+    int index = room->getRandomGenerator()->bounded(handcards.length());
     return handcards.at(index);
 }
 
@@ -92,7 +96,7 @@ void ServerPlayer::throwAllMarks(){
         }
     }
 
-    marks.clear();
+    clearMarks();
 }
 
 void ServerPlayer::clearPrivatePiles(){
@@ -107,6 +111,7 @@ void ServerPlayer::clearPrivatePiles(){
         }
     }
     piles.clear();
+    invalidateDistances();
 }
 
 void ServerPlayer::bury(){
@@ -144,7 +149,7 @@ QList<int> ServerPlayer::forceToDiscard(int discard_num, bool include_equip){
         flags.append("e");
 
     QList<const Card *> all_cards = getCards(flags);
-    qShuffle(all_cards);
+    qShuffle(all_cards, room->getRandomGenerator());
 
     int i;
     for(i=0; i<discard_num; i++)
@@ -166,7 +171,7 @@ void ServerPlayer::setSocket(ClientSocket *socket){
         connect(socket, SIGNAL(disconnected()), this, SIGNAL(disconnected()));
         connect(socket, SIGNAL(message_got(char*)), this, SLOT(getMessage(char*)));
 
-        connect(this, SIGNAL(message_cast(QString)), this, SLOT(castMessage(QString)));
+        connect(this, SIGNAL(messages_cast(QStringList)), this, SLOT(castMessages(QStringList)));
     }else{
         if(this->socket){
             this->disconnect(this->socket);
@@ -175,7 +180,7 @@ void ServerPlayer::setSocket(ClientSocket *socket){
             this->socket->deleteLater();
         }
 
-        disconnect(this, SLOT(castMessage(QString)));
+        disconnect(this, SLOT(castMessages(QStringList)));
     }
 
     this->socket = socket;
@@ -190,14 +195,53 @@ void ServerPlayer::getMessage(char *message){
 }
 
 void ServerPlayer::unicast(const QString &message) const{
-    emit message_cast(message);
+    // a keyframe is recorded by marshalling the room to a player who is not listening
+    if(recorder && recorder->isCapturing()){
+        recorder->recordLine(message);
+        return;
+    }
+
+    outbox_mutex.lock();
+    outbox << message;
+    outbox_mutex.unlock();
+
+    // the game flow flushes before it waits and after each event,
+    // messages from the main thread are sent at once
+    if(QThread::currentThread() == thread())
+        flushMessages();
 
     if(recorder)
         recorder->recordLine(message);
 }
 
+void ServerPlayer::flushMessages() const{
+    QMutexLocker locker(&outbox_mutex);
+    if(outbox.isEmpty())
+        return;
+
+    flush_count++;
+    flushed_messages += outbox.length();
+
+    // emit it while locked, so that batches from different threads keep their order
+    emit messages_cast(outbox);
+    outbox.clear();
+}
+
+int ServerPlayer::getFlushCount() const{
+    QMutexLocker locker(&outbox_mutex);
+    return flush_count;
+}
+
+int ServerPlayer::getFlushedMessageCount() const{
+    QMutexLocker locker(&outbox_mutex);
+    return flushed_messages;
+}
+
 void ServerPlayer::startRecord(){
     recorder = new Recorder(this);
+
+    // the setup was sent before the player signed up, a replay can not enter the room without it
+    recorder->recordLine("setup " + Sanguosha->getSetupString());
 }
 
 void ServerPlayer::saveRecord(const QString &filename){
@@ -205,6 +249,15 @@ void ServerPlayer::saveRecord(const QString &filename){
         recorder->save(filename);
 }
 
+void ServerPlayer::recordKeyframe(int turn){
+    if(recorder == NULL)
+        return;
+
+    recorder->startKeyframe(turn);
+    room->marshal(this);
+    recorder->finishKeyframe();
+}
+
 void ServerPlayer::addToSelected(const QString &general){
     selected.append(general);
 }
@@ -214,9 +267,10 @@ QStringList ServerPlayer::getSelected() const{
 }
 
 QString ServerPlayer::findReasonable(const QStringList &generals, bool no_unreasonable){
+    const RoomConfig &config = room->getConfig();
 
     foreach(QString name, generals){
-        if(Config.Enable2ndGeneral){
+        if(config.Enable2ndGeneral){
             if(getGeneral()){
                 if(BanPair::isBanned(getGeneralName(), name))
                     continue;
@@ -225,7 +279,7 @@ QString ServerPlayer::findReasonable(const QStringList &generals, bool no_unreas
                     continue;
             }
 
-            if(Config.EnableHegemony)
+            if(config.EnableHegemony)
             {
                 if(getGeneral())
                     if(getGeneral()->getKingdom()
@@ -233,25 +287,8 @@ QString ServerPlayer::findReasonable(const QStringList &generals, bool no_unreas
                         continue;
             }
         }
-        if(Config.EnableBasara)
-        {
-            QStringList ban_list = Config.value("Banlist/Basara").toStringList();
-
-            if(ban_list.contains(name))continue;
-        }
-        if(Config.GameMode == "zombie_mode")
-        {
-            QStringList ban_list = Config.value("Banlist/Zombie").toStringList();
-
-            if(ban_list.contains(name))continue;
-        }
-        if((Config.GameMode.endsWith("p") ||
-            Config.GameMode.endsWith("pd")))
-        {
-            QStringList ban_list = Config.value("Banlist/Roles").toStringList();
-
-            if(ban_list.contains(name))continue;
-        }
+        if(config.isBannedChoice(name))
+            continue;
 
         return name;
     }
@@ -267,12 +304,13 @@ void ServerPlayer::clearSelected(){
     selected.clear();
 }
 
-void ServerPlayer::castMessage(const QString &message){
+void ServerPlayer::castMessages(const QStringList &messages){
     if(socket){
-        socket->send(message);
+        socket->send(messages);
 
 #ifndef QT_NO_DEBUG
-        qDebug("%s: %s", qPrintable(objectName()), qPrintable(message));
+        foreach(QString message, messages)
+            qDebug("%s: %s", qPrintable(objectName()), qPrintable(message));
 #endif
     }
 }
@@ -337,6 +375,8 @@ void ServerPlayer::removeCard(const Card *card, Place place){
         // FIXME
         ;
     }
+
+    invalidateDistances();
 }
 
 void ServerPlayer::addCard(const Card *card, Place place){
@@ -362,6 +402,8 @@ void ServerPlayer::addCard(const Card *card, Place place){
         // FIXME
         ;
     }
+
+    invalidateDistances();
 }
 
 bool ServerPlayer::isLastHandCard(const Card *card) const{
@@ -601,7 +643,7 @@ AI *ServerPlayer::getAI() const{
     if(getState() == "online"){
         return NULL;
     }
-    else if(getState() == "trust" && !Config.FreeChoose)
+    else if(getState() == "trust" && !room->getConfig().FreeChoose)
         return trust_ai;
     else
         return ai;
@@ -644,8 +686,8 @@ int ServerPlayer::getGeneralMaxHP() const{
         int first = getGeneral()->getMaxHp();
         int second = getGeneral2()->getMaxHp();
 
-        int plan = Config.MaxHpScheme;
-        if(Config.GameMode.contains("_mini_"))plan = 1;
+        int plan = room->getConfig().MaxHpScheme;
+        if(room->getMode().contains("_mini_"))plan = 1;
 
         switch(plan){
         case 2: max_hp = (first + second)/2; break;
@@ -676,7 +718,7 @@ QString ServerPlayer::getIp() const{
 }
 
 void ServerPlayer::introduceTo(ServerPlayer *player){
-    QString screen_name = Config.ContestMode ? tr("Contestant") : screenName();
+    QString screen_name = room->getConfig().ContestMode ? tr("Contestant") : screenName();
     QString avatar = property("avatar").toString();
 
     QString introduce_str = QString("%1:%2:%3")
@@ -689,8 +731,12 @@ void ServerPlayer::introduceTo(ServerPlayer *player){
     else
         room->broadcastInvoke("addPlayer", introduce_str, this);
 
-    if(isReady())
-        room->broadcastProperty(this, "ready");
+    if(isReady()){
+        if(player)
+            player->sendProperty("ready", this);
+        else
+            room->broadcastProperty(this, "ready");
+    }
 }
 
 void ServerPlayer::marshal(ServerPlayer *player) const{
@@ -778,6 +824,7 @@ void ServerPlayer::marshal(ServerPlayer *player) const{
 
 void ServerPlayer::addToPile(const QString &pile_name, int card_id, bool open){
     piles[pile_name] << card_id;
+    invalidateDistances();
 
     room->moveCardTo(Sanguosha->getCard(card_id), this, Player::Special, open);
 }
@@ -25,6 +25,9 @@ public:
     QString reportHeader() const;
     void sendProperty(const char *property_name, const Player *player = NULL) const;
     void unicast(const QString &message) const;
+    void flushMessages() const;
+    int getFlushCount() const;
+    int getFlushedMessageCount() const;
     void drawCard(const Card *card);
     Room *getRoom() const;
     void playCardEffect(const Card *card);
@@ -72,6 +75,7 @@ public:
 
     void startRecord();
     void saveRecord(const QString &filename);
+    void recordKeyframe(int turn);
 
     void setNext(ServerPlayer *next);
     ServerPlayer *getNext() const;
@@ -107,14 +111,19 @@ private:
     ServerPlayer *next;
     QStringList selected; // 3v3 mode use only
 
+    // messages of the game flow wait here until the next flush
+    mutable QStringList outbox;
+    mutable QMutex outbox_mutex;
+    mutable int flush_count, flushed_messages;
+
 private slots:
     void getMessage(char *message);
-    void castMessage(const QString &message);
+    void castMessages(const QStringList &messages);
 
 signals:
     void disconnected();
     void request_got(const QString &request);
-    void message_cast(const QString &message) const;
+    void messages_cast(const QStringList &messages) const;
 };
 
 #endif // SERVERPLAYER_H
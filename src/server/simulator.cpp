@@ -0,0 +1,227 @@
+#include "simulator.h"
+#include "room.h"
+#include "roomthread.h"
+#include "serverplayer.h"
+#include "engine.h"
+#include "settings.h"
+#include "roomscheduler.h"
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QMap>
+#include <QDir>
+#include <cstdio>
+
+Simulator::Simulator(QObject *parent, const QString &mode, int total, int threads, uint seed)
+    :QObject(parent), mode(mode), total(total), threads(qMax(threads, 1)), seed(seed),
+      started(0), finished(0), failed(0), turns(0), game_msecs(0),
+      distance_hits(0), distance_misses(0),
+      lua_calls(0), lua_userdata(0), lua_cache_hits(0),
+      max_rooms(0), step_rooms(0), step_threads(0), peak_threads(0)
+{
+    sampler.setInterval(20);
+    connect(&sampler, SIGNAL(timeout()), this, SLOT(sampleThreads()));
+}
+
+// the number of threads of this process, or 0 where /proc is not available
+static int CountThreads(){
+    QDir tasks("/proc/self/task");
+    if(!tasks.exists())
+        return 0;
+
+    return tasks.entryList(QDir::Dirs | QDir::NoDotAndDotDot).length();
+}
+
+void Simulator::start(){
+    printf("Simulating %d games of %s on %d threads, seed %u\n",
+           total, qPrintable(mode), threads, seed);
+
+    timer.start();
+
+    int i;
+    for(i=0; i<threads; i++){
+        if(!startRoom())
+            break;
+    }
+
+    if(finished == started)
+        report();
+}
+
+void Simulator::startRamp(int limit){
+    max_rooms = qMax(limit, 1);
+
+    // every step plays as many games as it has rooms
+    total = 0;
+    int rooms;
+    for(rooms=1; rooms<max_rooms; rooms*=2)
+        total += rooms;
+    total += max_rooms;
+
+    printf("Ramping up to %d concurrent games of %s, room tasks %s, seed %u\n",
+           max_rooms, qPrintable(mode), RoomScheduler::IsEnabled() ? "on" : "off", seed);
+    printf("%8s %10s %10s %10s\n", "rooms", "threads", "peak", "workers");
+
+    timer.start();
+    sampler.start();
+    startStep(1);
+}
+
+void Simulator::startStep(int rooms){
+    step_rooms = rooms;
+
+    int i;
+    for(i=0; i<rooms; i++){
+        if(!startRoom())
+            break;
+    }
+
+    // the threads once the games of the step have started, and the most seen while they run
+    step_threads = peak_threads = CountThreads();
+    if(finished == started)
+        finishStep();
+}
+
+void Simulator::sampleThreads(){
+    peak_threads = qMax(peak_threads, CountThreads());
+}
+
+void Simulator::finishStep(){
+    int workers = RoomScheduler::IsEnabled() ? RoomScheduler::GetInstance()->getWorkerCount() : 0;
+    printf("%8d %10d %10d %10d\n", step_rooms, step_threads, peak_threads, workers);
+
+    if(started < total && failed == 0)
+        startStep(qMin(step_rooms * 2, max_rooms));
+    else{
+        sampler.stop();
+        report();
+    }
+}
+
+bool Simulator::startRoom(){
+    if(started >= total)
+        return false;
+
+    // each game has its own seed, so it does not matter which one finishes first
+    uint room_seed = seed + started;
+    started ++;
+
+    Room *room = new Room(this, mode);
+    QString error_msg = room->createLuaState();
+    if(!error_msg.isEmpty()){
+        printf("Lua scripts error: %s\n", qPrintable(error_msg));
+        delete room;
+        failed ++;
+        finished ++;
+        return false;
+    }
+
+    room->setRandomSeed(room_seed);
+    room->setProperty("simulate", true);
+    room->setTag("SimulationStart", timer.elapsed());
+
+    connect(room, SIGNAL(game_over(QString)), this, SLOT(onGameOver(QString)));
+
+    room->fillRobotsCommand(NULL, ".");
+    return true;
+}
+
+void Simulator::onGameOver(const QString &winner){
+    Room *room = qobject_cast<Room *>(sender());
+    QStringList winners = winner.split("+");
+
+    foreach(ServerPlayer *player, room->getPlayers()){
+        QString role = player->getRole();
+        QString general = player->getGeneralName();
+        bool won = winners.contains(role) || winners.contains(player->objectName());
+
+        role_count[role] ++;
+        general_count[general] ++;
+        if(won){
+            role_wins[role] ++;
+            general_wins[general] ++;
+        }
+    }
+
+    turns += room->getTag("TurnCount").toInt();
+    game_msecs += timer.elapsed() - room->getTag("SimulationStart").toLongLong();
+    distance_hits += room->getDistanceMatrix()->getHitCount();
+    distance_misses += room->getDistanceMatrix()->getMissCount();
+    lua_calls += room->getTag("LuaCalls").toInt();
+    lua_userdata += room->getTag("LuaUserdata").toInt();
+    lua_cache_hits += room->getTag("LuaCacheHits").toInt();
+    finished ++;
+
+    // the room is deleted after its game thread has released the Lua state
+    RoomThread *thread = room->getThread();
+    connect(thread, SIGNAL(finished()), room, SLOT(deleteLater()));
+    if(thread->isFinished())
+        room->deleteLater();
+
+    // a step ends when all of its games are over
+    if(max_rooms > 0){
+        if(finished == started)
+            finishStep();
+        return;
+    }
+
+    if(finished % 100 == 0)
+        printf("%d/%d games finished\n", finished, total);
+
+    startRoom();
+
+    if(finished == started)
+        report();
+}
+
+void Simulator::report(){
+    qint64 elapsed = qMax(timer.elapsed(), qint64(1));
+    int games = finished - failed;
+
+    printf("\n%d games finished, %d failed, in %.2f seconds, %.2f games per second\n",
+           games, failed, elapsed / 1000.0, games * 1000.0 / elapsed);
+
+    if(games > 0){
+        printf("average game length: %.2f turns, %.2f seconds\n",
+               double(turns) / games, game_msecs / 1000.0 / games);
+    }
+
+    // run again with --no-distance-cache to compare
+    int corrects = Sanguosha->getCorrectCount();
+    printf("distance: %d getCorrect calls, %.1f per turn, cache %s, %lld hits, %lld misses\n",
+           corrects, corrects / qMax(double(turns), 1.0),
+           DistanceMatrix::IsEnabled() ? "on" : "off", distance_hits, distance_misses);
+
+    if(games > 0){
+        printf("Lua: %.1f calls per game, %.1f per turn, %.1f userdata made and %.1f reused per game\n",
+               double(lua_calls) / games, lua_calls / qMax(double(turns), 1.0),
+               double(lua_userdata) / games, double(lua_cache_hits) / games);
+    }
+
+    printf("\nrole win rates:\n");
+    foreach(QString role, QStringList() << "lord" << "loyalist" << "rebel" << "renegade"){
+        int count = role_count.value(role);
+        if(count == 0)
+            continue;
+
+        printf("%-10s %6d/%-6d %6.2f%%\n", qPrintable(role),
+               role_wins.value(role), count, role_wins.value(role) * 100.0 / count);
+    }
+
+    // the generals who win most often come first
+    QMultiMap<double, QString> rates;
+    foreach(QString general, general_count.keys())
+        rates.insert(general_wins.value(general) / double(general_count.value(general)), general);
+
+    printf("\ngeneral win rates:\n");
+    QMapIterator<double, QString> itor(rates);
+    itor.toBack();
+    while(itor.hasPrevious()){
+        itor.previous();
+        QString general = itor.value();
+        printf("%-16s %6d/%-6d %6.2f%%\n", qPrintable(general),
+               general_wins.value(general), general_count.value(general), itor.key() * 100.0);
+    }
+
+    QMetaObject::invokeMethod(qApp, "quit", Qt::QueuedConnection);
+}
@@ -0,0 +1,50 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+class Room;
+
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QTimer>
+
+// plays many robot-only games without a server or sockets, a few of them at a time,
+// and reports how often each role and each general wins
+class Simulator : public QObject{
+    Q_OBJECT
+
+public:
+    Simulator(QObject *parent, const QString &mode, int total, int threads, uint seed);
+    void start();
+
+    // plays 1, 2, 4 ... up to limit games at once and prints the number of OS threads at each step
+    void startRamp(int limit);
+
+private:
+    QString mode;
+    int total, threads;
+    uint seed;
+
+    int started, finished, failed;
+    qint64 turns, game_msecs;
+    qint64 distance_hits, distance_misses;
+    qint64 lua_calls, lua_userdata, lua_cache_hits;
+    QElapsedTimer timer;
+
+    int max_rooms, step_rooms, step_threads, peak_threads;
+    QTimer sampler;
+
+    QHash<QString, int> role_count, role_wins;
+    QHash<QString, int> general_count, general_wins;
+
+    bool startRoom();
+    void startStep(int rooms);
+    void finishStep();
+    void report();
+
+private slots:
+    void onGameOver(const QString &winner);
+    void sampleThreads();
+};
+
+#endif // SIMULATOR_H
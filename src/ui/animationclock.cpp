@@ -0,0 +1,124 @@
+#include "animationclock.h"
+#include "settings.h"
+
+#include <QBrush>
+
+Ticker::~Ticker(){
+    AnimationClock::GetInstance()->stop(this);
+}
+
+AnimationClock *AnimationClock::GetInstance(){
+    static AnimationClock *clock;
+    if(clock == NULL)
+        clock = new AnimationClock;
+
+    return clock;
+}
+
+AnimationClock::AnimationClock()
+    :window_start(0), frames(0), ticks(0), worst_late(0), busy(0),
+      last_frames(0), last_ticks(0), last_worst_late(0), last_busy(0)
+{
+    // Qt has no way to wait for the vertical blank, so 16 milliseconds stands for 60 Hz
+    frame_interval = qMax(Config.value("FrameInterval", 16).toInt(), 1);
+
+    frame_timer = new QTimer(this);
+    frame_timer->setSingleShot(true);
+    connect(frame_timer, SIGNAL(timeout()), this, SLOT(onFrame()));
+
+    clock.start();
+}
+
+void AnimationClock::start(Ticker *ticker, int interval){
+    if(tickers.contains(ticker))
+        return;
+
+    Entry entry;
+    entry.interval = qMax(interval, frame_interval);
+    entry.due = clock.elapsed() + entry.interval;
+    tickers.insert(ticker, entry);
+
+    schedule();
+}
+
+void AnimationClock::stop(Ticker *ticker){
+    if(tickers.remove(ticker))
+        schedule();
+}
+
+bool AnimationClock::isTicking(Ticker *ticker) const{
+    return tickers.contains(ticker);
+}
+
+QString AnimationClock::getStatistics() const{
+    return QString("%1 frames, %2 ticks, %3 ms busy, %4 ms late at most, %5 tickers")
+            .arg(last_frames).arg(last_ticks).arg(last_busy).arg(last_worst_late).arg(tickers.size());
+}
+
+void AnimationClock::onFrame(){
+    qint64 now = clock.elapsed();
+    if(now - window_start >= 1000){
+        last_frames = frames;
+        last_ticks = ticks;
+        last_worst_late = worst_late;
+        last_busy = busy;
+
+        frames = ticks = worst_late = busy = 0;
+        window_start = now;
+    }
+
+    frames ++;
+
+    foreach(Ticker *ticker, tickers.keys()){
+        // an earlier ticker may have stopped or deleted this one
+        if(!tickers.contains(ticker))
+            continue;
+
+        Entry &entry = tickers[ticker];
+        if(entry.due > now)
+            continue;
+
+        worst_late = qMax(worst_late, int(now - entry.due));
+
+        // the frames that were missed are skipped rather than made up for
+        entry.due += entry.interval;
+        if(entry.due <= now)
+            entry.due = now + entry.interval;
+
+        ticks ++;
+        if(!ticker->tick())
+            tickers.remove(ticker);
+    }
+
+    busy += clock.elapsed() - now;
+
+    schedule();
+}
+
+void AnimationClock::schedule(){
+    if(tickers.isEmpty()){
+        frame_timer->stop();
+        return;
+    }
+
+    qint64 next = -1;
+    foreach(const Entry &entry, tickers){
+        if(next == -1 || entry.due < next)
+            next = entry.due;
+    }
+
+    qint64 frame = (next + frame_interval - 1) / frame_interval * frame_interval;
+    frame_timer->start(qMax(int(frame - clock.elapsed()), 0));
+}
+
+FrameTimeOverlay::FrameTimeOverlay(){
+    setBrush(Qt::yellow);
+    setZValue(10000);
+
+    AnimationClock::GetInstance()->start(this, 1000);
+}
+
+bool FrameTimeOverlay::tick(){
+    setText(AnimationClock::GetInstance()->getStatistics());
+    return true;
+}
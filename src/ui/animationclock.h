@@ -0,0 +1,65 @@
+#ifndef ANIMATIONCLOCK_H
+#define ANIMATIONCLOCK_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QGraphicsSimpleTextItem>
+
+// something that changes by itself every few milliseconds, it is ticked by the clock
+// instead of a timer of its own
+class Ticker{
+public:
+    virtual ~Ticker();
+
+    // returns false when there is nothing more to animate, then the clock stops ticking it
+    virtual bool tick() = 0;
+};
+
+// one clock for all the tickers of the GUI thread, the frames are laid on a grid of
+// FrameInterval milliseconds, so the tickers due in the same frame wake the thread once
+class AnimationClock : public QObject{
+    Q_OBJECT
+
+public:
+    static AnimationClock *GetInstance();
+
+    // a ticker that is already ticking keeps its phase
+    void start(Ticker *ticker, int interval);
+    void stop(Ticker *ticker);
+    bool isTicking(Ticker *ticker) const;
+
+    // over the last full second
+    QString getStatistics() const;
+
+private slots:
+    void onFrame();
+
+private:
+    AnimationClock();
+    void schedule();
+
+    struct Entry{
+        int interval;
+        qint64 due;
+    };
+
+    QHash<Ticker *, Entry> tickers;
+    QTimer *frame_timer;
+    QElapsedTimer clock;
+    int frame_interval;
+
+    qint64 window_start;
+    int frames, ticks, worst_late, busy;
+    int last_frames, last_ticks, last_worst_late, last_busy;
+};
+
+// shows the statistics of the clock in a corner of the room, see ShowFrameTime
+class FrameTimeOverlay : public QGraphicsSimpleTextItem, public Ticker{
+public:
+    FrameTimeOverlay();
+    virtual bool tick();
+};
+
+#endif // ANIMATIONCLOCK_H
@@ -0,0 +1,243 @@
+#include "assetloader.h"
+#include "engine.h"
+#include "settings.h"
+
+#include <QPainter>
+#include <QDir>
+#include <QSet>
+#include <QFile>
+#include <QMutexLocker>
+#include <qmath.h>
+
+AssetDecoder::AssetDecoder(QObject *parent)
+    :QThread(parent), running(false)
+{
+}
+
+void AssetDecoder::enqueue(const QStringList &assets){
+    QMutexLocker locker(&mutex);
+
+    jobs << assets;
+    if(!running){
+        // the thread may be about to return after it has found no job
+        wait();
+        running = true;
+        start(QThread::LowPriority);
+    }
+}
+
+bool AssetDecoder::takeResult(QString &asset, QImage &image, QList<QRect> &frames){
+    QMutexLocker locker(&mutex);
+
+    if(results.isEmpty())
+        return false;
+
+    Result result = results.takeFirst();
+    asset = result.asset;
+    image = result.image;
+    frames = result.frames;
+    return true;
+}
+
+void AssetDecoder::run(){
+    forever{
+        mutex.lock();
+        if(jobs.isEmpty()){
+            running = false;
+            mutex.unlock();
+            break;
+        }
+
+        Result result;
+        result.asset = jobs.takeFirst();
+        mutex.unlock();
+
+        result.image = Decode(result.asset, result.frames);
+
+        mutex.lock();
+        results << result;
+        mutex.unlock();
+
+        emit decoded();
+    }
+}
+
+QImage AssetDecoder::Decode(const QString &asset, QList<QRect> &frames){
+    if(!asset.endsWith("/")){
+        QImage image(asset);
+        if(!image.isNull())
+            frames << image.rect();
+
+        return image;
+    }
+
+    QList<QImage> images;
+    QSize cell;
+    forever{
+        QImage image(QString("%1%2.png").arg(asset).arg(images.length()));
+        if(image.isNull())
+            break;
+
+        cell = cell.expandedTo(image.size());
+        images << image;
+    }
+
+    if(images.isEmpty())
+        return QImage();
+
+    // the frames are laid out in a grid as square as possible
+    int columns = qCeil(qSqrt(images.length()));
+    int rows = (images.length() + columns - 1) / columns;
+
+    QImage atlas(cell.width() * columns, cell.height() * rows, QImage::Format_ARGB32_Premultiplied);
+    atlas.fill(0);
+
+    QPainter painter(&atlas);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+
+    int i;
+    for(i=0; i<images.length(); i++){
+        QPoint pos((i % columns) * cell.width(), (i / columns) * cell.height());
+        painter.drawImage(pos, images.at(i));
+        frames << QRect(pos, images.at(i).size());
+    }
+
+    return atlas;
+}
+
+AssetLoader *AssetLoader::GetInstance(){
+    static AssetLoader *loader;
+    if(loader == NULL)
+        loader = new AssetLoader;
+
+    return loader;
+}
+
+QPixmap AssetLoader::GetPixmap(const QString &filename){
+    return GetInstance()->getAtlas(filename).pixmap;
+}
+
+QStringList AssetLoader::RoomAssets(){
+    QStringList emotions;
+    emotions << "peach"
+            << "analeptic"
+            << "chain"
+            << "damage"
+            << "fire_slash"
+            << "thunder_slash"
+            << "killer"
+            << "jink"
+            << "no-success"
+            << "slash_black"
+            << "slash_red"
+            << "success";
+
+    QStringList assets;
+    foreach(QString emotion, emotions)
+        assets << QString("image/system/emotion/%1/").arg(emotion);
+
+    QDir dir("image/system/emotion");
+    foreach(QString filename, dir.entryList(QStringList() << "*.png", QDir::Files))
+        assets << dir.filePath(filename);
+
+    QSet<QString> card_assets;
+    int i;
+    for(i=0; i<Sanguosha->getCardCount(); i++){
+        const Card *card = Sanguosha->getCard(i);
+        card_assets << card->getPixmapPath()
+                    << QString("image/system/suit/%1.png").arg(card->getSuitString())
+                    << QString("image/system/cardsuit/%1.png").arg(card->getSuitString())
+                    << QString("image/system/%1/%2.png").arg(card->isBlack() ? "black" : "red").arg(card->getNumberString());
+
+        if(QFile::exists(card->getIconPath()))
+            card_assets << card->getIconPath();
+    }
+    assets << card_assets.toList();
+
+    // the card size portraits of the generals are only shown while choosing, they are left out
+    foreach(QString name, Sanguosha->getLimitedGeneralNames()){
+        const General *general = Sanguosha->getGeneral(name);
+        assets << general->getPixmapPath("small") << general->getPixmapPath("tiny");
+    }
+
+    return assets;
+}
+
+AssetLoader::AssetLoader()
+    :total(0), done(0), hits(0), misses(0)
+{
+    // the costs are in kilobytes
+    atlases.setMaxCost(Config.value("AssetBudget", 96).toInt() * 1024);
+
+    decoder = new AssetDecoder(this);
+    connect(decoder, SIGNAL(decoded()), this, SLOT(collect()));
+}
+
+void AssetLoader::preload(const QStringList &assets){
+    QStringList pending;
+    foreach(QString asset, assets){
+        if(!atlases.contains(asset))
+            pending << asset;
+    }
+
+    if(pending.isEmpty()){
+        // queued, so that the receivers connected after this call get it as well
+        QMetaObject::invokeMethod(this, "progress", Qt::QueuedConnection, Q_ARG(int, 100));
+        return;
+    }
+
+    total += pending.length();
+    decoder->enqueue(pending);
+}
+
+Atlas AssetLoader::getAtlas(const QString &asset){
+    Atlas *cached = atlases.object(asset);
+    if(cached){
+        hits ++;
+        return *cached;
+    }
+
+    misses ++;
+
+    Atlas atlas;
+    atlas.pixmap = QPixmap::fromImage(AssetDecoder::Decode(asset, atlas.frames));
+    insert(asset, atlas);
+
+    return atlas;
+}
+
+QString AssetLoader::getStatistics() const{
+    return QString("assets: %1 hits, %2 misses, %3 cached in %4/%5 KB")
+            .arg(hits).arg(misses).arg(atlases.count())
+            .arg(atlases.totalCost()).arg(atlases.maxCost());
+}
+
+void AssetLoader::collect(){
+    QString asset;
+    QImage image;
+    QList<QRect> frames;
+    while(decoder->takeResult(asset, image, frames)){
+        Atlas atlas;
+        atlas.pixmap = QPixmap::fromImage(image);
+        atlas.frames = frames;
+        insert(asset, atlas);
+
+        done ++;
+    }
+
+    if(total == 0)
+        return;
+
+    emit progress(done * 100 / total);
+
+    if(done == total){
+        total = done = 0;
+        qDebug("%s", qPrintable(getStatistics()));
+    }
+}
+
+void AssetLoader::insert(const QString &asset, const Atlas &atlas){
+    // a missing image is kept as well, so it is not looked for again
+    int cost = qMax(atlas.pixmap.width() * atlas.pixmap.height() * 4 / 1024, 1);
+    atlases.insert(asset, new Atlas(atlas), cost);
+}
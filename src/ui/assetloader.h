@@ -0,0 +1,83 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QCache>
+#include <QImage>
+#include <QPixmap>
+#include <QRect>
+#include <QStringList>
+
+// an image, or the frames of an animation packed into one pixmap
+struct Atlas{
+    QPixmap pixmap;
+    QList<QRect> frames;
+};
+
+// decodes the images off the GUI thread, since only the GUI thread may make a QPixmap
+class AssetDecoder : public QThread{
+    Q_OBJECT
+
+public:
+    AssetDecoder(QObject *parent);
+
+    void enqueue(const QStringList &assets);
+    bool takeResult(QString &asset, QImage &image, QList<QRect> &frames);
+
+    // an asset that ends with a slash is a directory of frames named 0.png, 1.png, ...
+    static QImage Decode(const QString &asset, QList<QRect> &frames);
+
+signals:
+    void decoded();
+
+protected:
+    virtual void run();
+
+private:
+    struct Result{
+        QString asset;
+        QImage image;
+        QList<QRect> frames;
+    };
+
+    QStringList jobs;
+    QList<Result> results;
+    bool running;
+    QMutex mutex;
+};
+
+// keeps the decoded images of the client within the budget of AssetBudget megabytes,
+// the ones used least recently are dropped first
+class AssetLoader : public QObject{
+    Q_OBJECT
+
+public:
+    static AssetLoader *GetInstance();
+    static QPixmap GetPixmap(const QString &filename);
+
+    // the emotions, the cards and the avatars that a room shows
+    static QStringList RoomAssets();
+
+    // progress() reaches 100 when all the assets are ready
+    void preload(const QStringList &assets);
+    Atlas getAtlas(const QString &asset);
+    QString getStatistics() const;
+
+signals:
+    void progress(int percent);
+
+private slots:
+    void collect();
+
+private:
+    AssetLoader();
+    void insert(const QString &asset, const Atlas &atlas);
+
+    QCache<QString, Atlas> atlases;
+    AssetDecoder *decoder;
+    int total, done;
+    int hits, misses;
+};
+
+#endif // ASSETLOADER_H
@@ -87,8 +87,6 @@ void Button::init()
     this->setGraphicsEffect(effect);
 
     glow = 0;
-
-    timer_id = 0;
 }
 
 void Button::setMute(bool mute){
@@ -119,7 +117,7 @@ void Button::hoverEnterEvent(QGraphicsSceneHoverEvent *){
 
 #endif
 
-    if(!timer_id)timer_id = QObject::startTimer(40);
+    AnimationClock::GetInstance()->start(this, 40);
 }
 
 void Button::mousePressEvent(QGraphicsSceneMouseEvent *event){
@@ -150,7 +148,7 @@ void Button::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QW
     //painter->drawPixmap(rect.toRect(),*title);
 }
 
-void Button::timerEvent(QTimerEvent *)
+bool Button::tick()
 {
     update();
     if(hasFocus())
@@ -159,10 +157,8 @@ void Button::timerEvent(QTimerEvent *)
     }else
     {
         if(glow>0)glow--;
-        else if(timer_id)
-        {
-            QObject::killTimer(timer_id);
-            timer_id = 0;
-        }
+        else return false;
     }
+
+    return true;
 }
@@ -2,12 +2,13 @@
 #define BUTTON_H
 
 #include "settings.h"
+#include "animationclock.h"
 
 #include <QGraphicsObject>
 #include <QFont>
 #include <QFontMetrics>
 
-class Button : public QGraphicsObject
+class Button : public QGraphicsObject, public Ticker
 {
     Q_OBJECT
 public:
@@ -17,6 +18,7 @@ public:
     void setFont(const QFont &font);
 
     virtual QRectF boundingRect() const;    
+    virtual bool tick();
 
 protected:
     virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
@@ -24,8 +26,6 @@ protected:
     virtual void mousePressEvent(QGraphicsSceneMouseEvent *event);
     virtual void mouseReleaseEvent(QGraphicsSceneMouseEvent *event);
 
-    virtual void timerEvent(QTimerEvent *);
-
 private:
     QString label;
     QSizeF size;
@@ -35,7 +35,6 @@ private:
     QPixmap *title;
     QGraphicsPixmapItem *title_item;
     int glow;
-    int timer_id;
 
     void init();
 
@@ -3,6 +3,7 @@
 #include "skill.h"
 #include "clientplayer.h"
 #include "settings.h"
+#include "assetloader.h"
 
 #include <cmath>
 #include <QPainter>
@@ -14,15 +15,16 @@
 #include <QGraphicsDropShadowEffect>
 
 CardItem::CardItem(const Card *card)
-    :Pixmap(card->getPixmapPath(), false), card(card), filtered_card(card), auto_back(true)
+    :Pixmap(card->getPixmapPath(), false), card(card), filtered_card(card), auto_back(true),
+      move_animation(NULL), fade_move(NULL), fade_opacity(NULL), fade_group(NULL)
 
 {
     Q_ASSERT(card != NULL);
 
-    suit_pixmap.load(QString("image/system/suit/%1.png").arg(card->getSuitString()));
-    cardsuit_pixmap.load(QString("image/system/cardsuit/%1.png").arg(card->getSuitString()));
-    number_pixmap.load(QString("image/system/%1/%2.png").arg(card->isBlack()?"black":"red").arg(card->getNumberString()));
-    icon_pixmap.load(card->getIconPath());
+    suit_pixmap = AssetLoader::GetPixmap(QString("image/system/suit/%1.png").arg(card->getSuitString()));
+    cardsuit_pixmap = AssetLoader::GetPixmap(QString("image/system/cardsuit/%1.png").arg(card->getSuitString()));
+    number_pixmap = AssetLoader::GetPixmap(QString("image/system/%1/%2.png").arg(card->isBlack()?"black":"red").arg(card->getNumberString()));
+    icon_pixmap = AssetLoader::GetPixmap(card->getIconPath());
     setTransformOriginPoint(pixmap.width()/2, pixmap.height()/2);
 
     setToolTip(card->getDescription());
@@ -38,7 +40,8 @@ CardItem::CardItem(const Card *card)
 }
 
 CardItem::CardItem(const QString &general_name)
-    :card(NULL), filtered_card(NULL), auto_back(true)
+    :card(NULL), filtered_card(NULL), auto_back(true),
+      move_animation(NULL), fade_move(NULL), fade_opacity(NULL), fade_group(NULL)
 {
     changeGeneral(general_name);
 }
@@ -87,21 +90,37 @@ QAbstractAnimation* CardItem::goBack(bool kieru,bool fadein,bool fadeout){
         return NULL;
     }
 
-    QPropertyAnimation *goback = new QPropertyAnimation(this, "pos");
-    goback->setEndValue(home_pos);
-    goback->setEasingCurve(QEasingCurve::OutQuad);
-    goback->setDuration(500);
+    // the animations are made once for each card and reused by all its moves
+    if(move_animation == NULL){
+        move_animation = new QPropertyAnimation(this, "pos", this);
+        move_animation->setEasingCurve(QEasingCurve::OutQuad);
+        move_animation->setDuration(500);
+
+        fade_group = new QParallelAnimationGroup(this);
+        fade_move = new QPropertyAnimation(this, "pos");
+        fade_move->setEasingCurve(QEasingCurve::OutQuad);
+        fade_opacity = new QPropertyAnimation(this, "opacity");
+        fade_group->addAnimation(fade_move);
+        fade_group->addAnimation(fade_opacity);
+    }
+
+    // a move that has not finished yet is taken over by this one, stop does not emit finished,
+    // so what was waiting for the old move is dropped here
+    move_animation->stop();
+    fade_group->stop();
+    move_animation->disconnect(this, SLOT(reduceZ()));
+    fade_group->disconnect(this, SLOT(reduceZ()));
 
     if(kieru){
-        QParallelAnimationGroup *group = new QParallelAnimationGroup;
+        fade_move->setEndValue(home_pos);
 
-        QPropertyAnimation *disappear = new QPropertyAnimation(this, "opacity");
-        if(fadein)disappear->setStartValue(0.0);
-        disappear->setEndValue(1.0);
-        if(fadeout)disappear->setEndValue(0.0);
+        fade_opacity->setKeyValues(QVariantAnimation::KeyValues());
+        if(fadein)fade_opacity->setStartValue(0.0);
+        fade_opacity->setEndValue(1.0);
+        if(fadeout)fade_opacity->setEndValue(0.0);
 
-        disappear->setKeyValueAt(0.2, 1.0);
-        disappear->setKeyValueAt(0.8, 1.0);
+        fade_opacity->setKeyValueAt(0.2, 1.0);
+        fade_opacity->setKeyValueAt(0.8, 1.0);
 
 
         int dx = home_pos.x()-pos().x();
@@ -111,22 +130,20 @@ QAbstractAnimation* CardItem::goBack(bool kieru,bool fadein,bool fadeout){
 
         length = qBound(500/3,length,400);
 
-        goback->setDuration(length*3);
-        disappear->setDuration(length*3);
-
-        group->addAnimation(goback);
-        group->addAnimation(disappear);
+        fade_move->setDuration(length*3);
+        fade_opacity->setDuration(length*3);
 
         // prevent the cover face bug
         setEnabled(false);
 
-        group->start(QParallelAnimationGroup::DeleteWhenStopped);
-        return group;
+        fade_group->start();
+        return fade_group;
     }else
     {
+        move_animation->setEndValue(home_pos);
         setOpacity(this->isEnabled() ? 1.0 : 0.7);
-        goback->start(QPropertyAnimation::DeleteWhenStopped);
-        return goback;
+        move_animation->start();
+        return move_animation;
     }
 }
 
@@ -158,7 +175,7 @@ void CardItem::showAvatar(const General *general){
             avatar->setPos(44, 87);
         }
 
-        avatar->setPixmap(QPixmap(general->getPixmapPath("tiny")));
+        avatar->setPixmap(AssetLoader::GetPixmap(general->getPixmapPath("tiny")));
         avatar->show();
     }else{
         if(avatar)
@@ -217,6 +234,10 @@ CardItem *CardItem::FindItem(const QList<CardItem *> &items, int card_id){
 
 void CardItem::reduceZ()
 {
+    // the animations are reused, so a connection to them lasts for one move only
+    if(sender())
+        sender()->disconnect(this, SLOT(reduceZ()));
+
     if(this->zValue()>0)this->setZValue(this->zValue()-0.8);
 }
 
@@ -9,6 +9,8 @@
 
 class FilterSkill;
 class General;
+class QPropertyAnimation;
+class QParallelAnimationGroup;
 
 class CardItem : public Pixmap
 {
@@ -64,6 +66,8 @@ private:
     QPointF home_pos;
     QGraphicsPixmapItem *frame, *avatar;
     bool auto_back;
+    QPropertyAnimation *move_animation, *fade_move, *fade_opacity;
+    QParallelAnimationGroup *fade_group;
 signals:
     void toggle_discards();
     void clicked();
@@ -21,6 +21,7 @@
 #include <QGraphicsDropShadowEffect>
 
 #include "pixmapanimation.h"
+#include "assetloader.h"
 
 Photo::Photo()
     :Pixmap("image/system/photo-back.png"),
@@ -46,7 +47,6 @@ Photo::Photo()
     progress_bar->setMaximumHeight(15);
     progress_bar->setMaximumWidth(pixmap.width());
     progress_bar->setTextVisible(false);
-    timer_id = 0;
 
     frame_item = new QGraphicsPixmapItem(this);
     frame_item->setPos(-6, -6);
@@ -138,18 +138,15 @@ void Photo::showProcessBar(){
     progress_bar->setValue(0);
     progress_bar->show();
 
-    if(ServerInfo.OperationTimeout != 0);
-        timer_id = startTimer(500);
+    if(ServerInfo.OperationTimeout != 0)
+        AnimationClock::GetInstance()->start(this, 500);
 }
 
 void Photo::hideProcessBar(){
     progress_bar->setValue(0);
     progress_bar->hide();
 
-    if(timer_id != 0){
-        killTimer(timer_id);
-        timer_id = 0;
-    }
+    AnimationClock::GetInstance()->stop(this);
 }
 
 void Photo::setEmotion(const QString &emotion, bool permanent){
@@ -161,7 +158,7 @@ void Photo::setEmotion(const QString &emotion, bool permanent){
     }
 
     QString path = QString("image/system/emotion/%1.png").arg(emotion);
-    emotion_item->setPixmap(QPixmap(path));
+    emotion_item->setPixmap(AssetLoader::GetPixmap(path));
     emotion_item->show();
 
     if(emotion == "question" || emotion == "no-question")
@@ -218,16 +215,13 @@ void Photo::hideEmotion(){
         emotion_item->hide();
 }
 
-void Photo::timerEvent(QTimerEvent *event){
+bool Photo::tick(){
     int step = 100 / double(ServerInfo.OperationTimeout * 5);
     int new_value = progress_bar->value() + step;
     new_value = qMin(progress_bar->maximum(), new_value);
     progress_bar->setValue(new_value);
 
-    if(new_value == progress_bar->maximum()){
-        killTimer(event->timerId());
-        timer_id = 0;
-    }
+    return new_value != progress_bar->maximum();
 }
 
 void Photo::setPlayer(const ClientPlayer *player)
@@ -276,7 +270,8 @@ void Photo::updateAvatar(){
     if(player){
         const General *general = player->getAvatarGeneral();
         avatar_area->setToolTip(general->getSkillDescription());
-        bool success = avatar.load(general->getPixmapPath("small"));
+        avatar = AssetLoader::GetPixmap(general->getPixmapPath("small"));
+        bool success = !avatar.isNull();
         QPixmap kingdom_icon(player->getKingdomIcon());
         kingdom_item->setPixmap(kingdom_icon);
         kingdom_frame.load(player->getKingdomFrame());
@@ -314,7 +309,8 @@ void Photo::updateAvatar(){
 void Photo::updateSmallAvatar(){
     const General *general2 = player->getGeneral2();
     if(general2){
-        bool success = small_avatar.load(general2->getPixmapPath("tiny"));
+        small_avatar = AssetLoader::GetPixmap(general2->getPixmapPath("tiny"));
+        bool success = !small_avatar.isNull();
         small_avatar_area->setToolTip(general2->getSkillDescription());
 
         if(!success){
@@ -4,6 +4,7 @@
 #include "pixmap.h"
 #include "player.h"
 #include "carditem.h"
+#include "animationclock.h"
 
 #include <QGraphicsObject>
 #include <QPixmap>
@@ -14,7 +15,7 @@ class ClientPlayer;
 class RoleCombobox;
 class QPushButton;
 
-class Photo : public Pixmap
+class Photo : public Pixmap, public Ticker
 {
     Q_OBJECT
 
@@ -64,7 +65,7 @@ public slots:
 protected:
     virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
     virtual QVariant itemChange(GraphicsItemChange change, const QVariant &value);
-    virtual void timerEvent(QTimerEvent *);
+    virtual bool tick();
 
 private:
     const ClientPlayer *player;
@@ -95,7 +96,6 @@ private:
     QPixmap death_pixmap;
     Pixmap *back_icon;
     QProgressBar *progress_bar;
-    int timer_id;
     QGraphicsPixmapItem *emotion_item, *frame_item;
     QGraphicsSimpleTextItem *skill_name_item;
     QGraphicsRectItem *avatar_area, *small_avatar_area;
@@ -1,4 +1,5 @@
 #include "pixmap.h"
+#include "assetloader.h"
 
 #include <QPainter>
 #include <QGraphicsColorizeEffect>
@@ -6,7 +7,7 @@
 #include <QImageReader>
 
 Pixmap::Pixmap(const QString &filename, bool center_as_origin)
-    :pixmap(filename), markable(false), marked(false)
+    :pixmap(AssetLoader::GetPixmap(filename)), markable(false), marked(false)
 {
 
 #ifndef QT_NO_DEBUG
@@ -34,9 +35,12 @@ QRectF Pixmap::boundingRect() const{
 }
 
 bool Pixmap::changePixmap(const QString &filename){
-    bool success = pixmap.load(filename);
-    if(success)
+    QPixmap loaded = AssetLoader::GetPixmap(filename);
+    bool success = !loaded.isNull();
+    if(success){
+        pixmap = loaded;
         prepareGeometryChange();
+    }
 
     return success;
 }
@@ -1,6 +1,7 @@
 #include "pixmapanimation.h"
+#include "assetloader.h"
+
 #include <QPainter>
-#include <QPixmapCache>
 #include <QDir>
 
 PixmapAnimation::PixmapAnimation(QGraphicsScene *scene) :
@@ -21,26 +22,23 @@ void PixmapAnimation::advance(int phase)
 
 void PixmapAnimation::setPath(const QString &path)
 {
-    frames.clear();
-
-    int i = 0;
-    QString pic_path = QString("%1%2%3").arg(path).arg(i++).arg(".png");
-    do{
-        frames << GetFrameFromCache(pic_path);
-        pic_path = QString("%1%2%3").arg(path).arg(i++).arg(".png");
-    }while(!GetFrameFromCache(pic_path).isNull());
+    // the frames are drawn out of one atlas, which is decoded in advance when the room is entered
+    Atlas atlas = AssetLoader::GetInstance()->getAtlas(path);
+    pixmap = atlas.pixmap;
+    frames = atlas.frames;
 
     current = 0;
 }
 
 void PixmapAnimation::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
-    painter->drawPixmap(0,0,frames.at(current));
+    const QRect &frame = frames.at(current);
+    painter->drawPixmap(QPointF(0,0), pixmap, frame);
 }
 
 QRectF PixmapAnimation::boundingRect() const
 {
-    return frames.at(current).rect();
+    return QRectF(QPointF(0,0), frames.at(current).size());
 }
 
 bool PixmapAnimation::valid()
@@ -48,14 +46,15 @@ bool PixmapAnimation::valid()
     return !frames.isEmpty();
 }
 
-void PixmapAnimation::timerEvent(QTimerEvent *e)
+bool PixmapAnimation::tick()
 {
     advance(1);
+    return true;
 }
 
 void PixmapAnimation::start(bool permanent,int interval)
 {
-    startTimer(interval);
+    AnimationClock::GetInstance()->start(this, interval);
     if(!permanent)connect(this,SIGNAL(finished()),this,SLOT(deleteLater()));
 }
 
@@ -89,8 +88,7 @@ PixmapAnimation* PixmapAnimation::GetPixmapAnimation(QGraphicsObject *parent, co
             if(emotion == "fire_slash")pma->moveBy(40,0);
         }
         pma->setParentItem(parent);
-        pma->startTimer(50);
-        connect(pma,SIGNAL(finished()),pma,SLOT(deleteLater()));
+        pma->start(false);
         return pma;
     }
     else
@@ -100,17 +98,6 @@ PixmapAnimation* PixmapAnimation::GetPixmapAnimation(QGraphicsObject *parent, co
     }
 }
 
-QPixmap PixmapAnimation::GetFrameFromCache(const QString &filename){
-    QPixmap pixmap;
-    if(!QPixmapCache::find(filename, &pixmap)){
-        pixmap.load(filename);
-        if(!pixmap.isNull())
-            QPixmapCache::insert(filename, pixmap);
-    }
-
-    return pixmap;
-}
-
 int PixmapAnimation::GetFrameCount(const QString &emotion){
     QString path = QString("image/system/emotion/%1/").arg(emotion);
     QDir dir(path);
@@ -1,9 +1,11 @@
 #ifndef PIXMAPANIMATION_H
 #define PIXMAPANIMATION_H
 
+#include "animationclock.h"
+
 #include <QGraphicsPixmapItem>
 
-class PixmapAnimation : public QObject,public QGraphicsItem
+class PixmapAnimation : public QObject,public QGraphicsItem, public Ticker
 {
     Q_OBJECT
     Q_INTERFACES(QGraphicsItem)
@@ -13,7 +15,7 @@ public:
     QRectF boundingRect() const;
     void advance(int phase);
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
-    void timerEvent(QTimerEvent *e);
+    virtual bool tick();
 
     void setPath(const QString &path);
     bool valid();
@@ -21,7 +23,6 @@ public:
     void start(bool permanent = true,int interval = 50);
 
     static PixmapAnimation* GetPixmapAnimation(QGraphicsObject *parent,const QString & emotion);
-    static QPixmap GetFrameFromCache(const QString &filename);
     static int GetFrameCount(const QString &emotion);
 
 signals:
@@ -30,7 +31,8 @@ signals:
 
 private:
     QString path;
-    QList<QPixmap> frames;
+    QPixmap pixmap;
+    QList<QRect> frames;
     int current,off_x,off_y;
 };
 
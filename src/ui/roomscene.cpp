@@ -355,8 +355,13 @@ RoomScene::RoomScene(QMainWindow *main_window)
 #endif
 
     progress_bar = dashboard->addProgressBar();
-    timer_id = 0;
-    tick = 0;
+    progress_ticks = 0;
+
+    if(Config.value("ShowFrameTime", false).toBool()){
+        frame_time = new FrameTimeOverlay;
+        addItem(frame_time);
+    }else
+        frame_time = NULL;
 
 #ifdef JOYSTICK_SUPPORT
 
@@ -525,6 +530,9 @@ void RoomScene::adjustItems(QMatrix matrix){
 
     dashboard->setPos(x, y);
 
+    if(frame_time)
+        frame_time->setPos(x, -main_height/2);
+
     QList<QPointF> positions = getPhotoPositions();
     int i;
     for(i=0; i<positions.length(); i++)
@@ -960,8 +968,8 @@ void RoomScene::contextMenuEvent(QGraphicsSceneContextMenuEvent *event){
     }
 }
 
-void RoomScene::timerEvent(QTimerEvent *event){
-    tick ++;
+bool RoomScene::tick(){
+    progress_ticks ++;
 
     int timeout = ServerInfo.OperationTimeout;
     if(ClientInstance->getStatus() == Client::AskForGuanxing)
@@ -969,16 +977,16 @@ void RoomScene::timerEvent(QTimerEvent *event){
 
     int step = 100 / double(timeout * 5);
     int new_value = progress_bar->value() + step;
-    new_value = qMin(tick * step, progress_bar->maximum());
+    new_value = qMin(progress_ticks * step, progress_bar->maximum());
     progress_bar->setValue(new_value);
 
     if(new_value >= progress_bar->maximum()){
-        killTimer(event->timerId());
-        timer_id = 0;
-        tick = 0;
+        progress_ticks = 0;
         doTimeout();
+        return false;
     }else{
         progress_bar->setValue(new_value);
+        return true;
     }
 }
 
@@ -1042,7 +1050,7 @@ void RoomScene::viewDiscards(){
                 gb =card_item->goBack(true,false,false);
             else gb =card_item->goBack();
 
-            if(gb)connect(gb,SIGNAL(finished()),card_item,SLOT(reduceZ()));
+            if(gb)connect(gb,SIGNAL(finished()),card_item,SLOT(reduceZ()),Qt::UniqueConnection);
         }
     }else{
         CardOverview *overview = new CardOverview;
@@ -2137,16 +2145,13 @@ void RoomScene::updateStatus(Client::Status status){
 
     // do timeout
     progress_bar->setValue(0);
-    if(timer_id != 0){
-        killTimer(timer_id);
-        timer_id = 0;
-    }
+    AnimationClock::GetInstance()->stop(this);
 
     if(status == Client::NotActive){
         progress_bar->hide();
     }else{
-        timer_id = startTimer(200);
-        tick = 0;
+        AnimationClock::GetInstance()->start(this, 200);
+        progress_ticks = 0;
         progress_bar->show();
     }
 }
@@ -2532,7 +2537,7 @@ void RoomScene::saveReplayRecord(){
     QString filename = QFileDialog::getSaveFileName(main_window,
                                                     tr("Save replay record"),
                                                     location,
-                                                    tr("Pure text replay file (*.txt);; Image replay file (*.png)"));
+                                                    tr("Pure text replay file (*.txt);; Image replay file (*.png);; Streaming replay file (*.qsgs)"));
 
     if(!filename.isEmpty()){
         ClientInstance->save(filename);
@@ -130,7 +130,7 @@ private:
 
 #endif
 
-class RoomScene : public QGraphicsScene{
+class RoomScene : public QGraphicsScene, public Ticker{
     Q_OBJECT
 
 public:
@@ -165,12 +165,13 @@ public slots:
 
     EffectAnimation * getEA() const{return animations;}
 
+    virtual bool tick();
+
 protected:
     virtual void mousePressEvent(QGraphicsSceneMouseEvent *event);
     virtual void mouseMoveEvent(QGraphicsSceneMouseEvent *event);
     virtual void keyReleaseEvent(QKeyEvent *event);
     virtual void contextMenuEvent(QGraphicsSceneContextMenuEvent *event);
-    virtual void timerEvent(QTimerEvent *event);
 
 private:
     Button* add_robot, *fill_robots;
@@ -195,8 +196,8 @@ private:
     QComboBox *sort_combobox;
 
     QProgressBar *progress_bar;
-    int timer_id;
-    int tick;
+    int progress_ticks;
+    FrameTimeOverlay *frame_time;
 
     QGraphicsItem *state_item;
     QList<QGraphicsPixmapItem *> role_items;
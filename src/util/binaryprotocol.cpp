@@ -0,0 +1,385 @@
+#include "binaryprotocol.h"
+#include "recorder.h"
+
+#include <QHash>
+#include <QStringList>
+#include <QFile>
+#include <QElapsedTimer>
+
+static const char *MethodNames[] = {
+    "",
+
+    "checkVersion", "roomBegin", "room", "roomEnd", "roomCreated", "roomError", "hallEntered",
+    "setup", "addPlayer", "removePlayer", "startInXs", "arrangeSeats", "warn", "startGame", "gameOver",
+    "hpChange", "killPlayer", "revivePlayer", "showCard", "setMark", "log", "speak",
+    "acquireSkill", "attachSkill", "detachSkill", "moveFocus", "setEmotion", "skillInvoked", "addHistory",
+    "animate", "judgeResult", "setScreenName", "setFixedDistance", "transfigure", "jilei", "pile",
+    "updateStateItem", "playSkillEffect", "playCardEffect", "playAudio",
+    "moveNCards", "moveCard", "drawNCards", "drawCards", "clearPile", "setPileNumber",
+    "activate", "doChooseGeneral", "doChooseGeneral2", "doGuanxing", "doGongxin",
+    "askForDiscard", "askForExchange", "askForSuit", "askForKingdom", "askForSinglePeach",
+    "askForCardChosen", "askForCard", "askForUseCard", "askForSkillInvoke", "askForChoice",
+    "askForNullification", "askForCardShow", "askForPindian", "askForYiji", "askForPlayerChosen",
+    "askForGeneral", "fillAG", "askForAG", "takeAG", "clearAG", "fillGenerals",
+    "askForGeneral3v3", "askForGeneral1v1", "takeGeneral", "startArrange", "askForOrder", "askForRole",
+    "askForDirection", "recoverGeneral", "revealGeneral", "askForAssign",
+
+    "protocol", "signup", "signupr",
+    "useCard", "invokeSkill", "replyNullification", "chooseCard", "responseCard", "discardCards",
+    "chooseSuit", "chooseKingdom", "chooseAG", "choosePlayer", "chooseGeneral", "selectChoice",
+    "replyYiji", "replyGuanxing", "replyGongxin", "assignRoles", "toggleReady", "addRobot", "fillRobots",
+    "choose", "choose2", "arrange", "selectOrder", "selectRole", "trust", "kick", "surrender"
+};
+
+// what kind of message a payload carries, the first byte of the payload
+enum MessageKind{
+    RawMessage,
+    InvokeMessage,
+    SelfPropertyMessage,
+    OtherPropertyMessage
+};
+
+// how the last token of a message is stored
+enum ValueTag{
+    StringValue,
+    DotValue,
+    IntListValue,
+    PlayerValue
+};
+
+static void WriteVarint(QByteArray &data, quint32 n){
+    while(n >= 0x80){
+        data.append(char((n & 0x7F) | 0x80));
+        n >>= 7;
+    }
+
+    data.append(char(n));
+}
+
+static bool ReadVarint(const QByteArray &data, int &pos, quint32 &n){
+    n = 0;
+    int shift = 0;
+    while(pos < data.size() && shift < 35){
+        uchar byte = data.at(pos++);
+        n |= quint32(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0)
+            return true;
+
+        shift += 7;
+    }
+
+    return false;
+}
+
+static void WriteString(QByteArray &data, const QByteArray &str){
+    WriteVarint(data, str.size());
+    data.append(str);
+}
+
+static bool ReadString(const QByteArray &data, int &pos, QByteArray &str){
+    quint32 size;
+    if(!ReadVarint(data, pos, size) || size > quint32(data.size() - pos))
+        return false;
+
+    str = data.mid(pos, size);
+    pos += size;
+    return true;
+}
+
+// only canonical numbers are compacted, so that decoding gives back the same text
+static bool ParseNumber(const QByteArray &token, quint32 &n){
+    if(token.isEmpty() || token.size() > 9)
+        return false;
+
+    if(token.size() > 1 && token.at(0) == '0')
+        return false;
+
+    n = 0;
+    foreach(char c, token){
+        if(c < '0' || c > '9')
+            return false;
+
+        n = n * 10 + (c - '0');
+    }
+
+    return true;
+}
+
+static bool ParsePlayerName(const QByteArray &name, quint32 &index){
+    return name.startsWith("sgs") && ParseNumber(name.mid(3), index);
+}
+
+static void WriteValue(QByteArray &data, const QByteArray &value){
+    if(value == "."){
+        data.append(char(DotValue));
+        return;
+    }
+
+    quint32 n;
+    if(ParsePlayerName(value, n)){
+        data.append(char(PlayerValue));
+        WriteVarint(data, n);
+        return;
+    }
+
+    QList<QByteArray> tokens = value.split('+');
+    QList<quint32> numbers;
+    foreach(QByteArray token, tokens){
+        if(!ParseNumber(token, n))
+            break;
+
+        numbers << n;
+    }
+
+    if(numbers.length() == tokens.length()){
+        data.append(char(IntListValue));
+        foreach(quint32 number, numbers)
+            WriteVarint(data, number);
+
+        return;
+    }
+
+    data.append(char(StringValue));
+    data.append(value);
+}
+
+static bool ReadValue(const QByteArray &data, int pos, QByteArray &value){
+    if(pos >= data.size())
+        return false;
+
+    ValueTag tag = ValueTag(data.at(pos++));
+    switch(tag){
+    case DotValue: value = "."; return true;
+    case StringValue: value = data.mid(pos); return true;
+    case PlayerValue:{
+            quint32 n;
+            if(!ReadVarint(data, pos, n))
+                return false;
+
+            value = "sgs" + QByteArray::number(n);
+            return true;
+        }
+
+    case IntListValue:{
+            value.clear();
+            while(pos < data.size()){
+                quint32 n;
+                if(!ReadVarint(data, pos, n))
+                    return false;
+
+                if(!value.isEmpty())
+                    value.append('+');
+
+                value.append(QByteArray::number(n));
+            }
+
+            return true;
+        }
+
+    default:
+        return false;
+    }
+}
+
+int BinaryProtocol::GetMethodId(const QString &method_name){
+    static QHash<QString, int> ids;
+    if(ids.isEmpty()){
+        int i;
+        for(i=1; i<NumOfMethods; i++)
+            ids.insert(MethodNames[i], i);
+    }
+
+    return ids.value(method_name, UnknownMethod);
+}
+
+QString BinaryProtocol::GetMethodName(int method_id){
+    if(method_id <= UnknownMethod || method_id >= NumOfMethods)
+        return QString();
+
+    return MethodNames[method_id];
+}
+
+QByteArray BinaryProtocol::Encode(const QString &message){
+    QByteArray text = message.toAscii();
+    QByteArray data;
+
+    int space = text.indexOf(' ');
+    if(space > 1){
+        QByteArray head = text.left(space);
+        QByteArray value = text.mid(space + 1);
+
+        if(head.at(0) == '.'){
+            data.append(char(SelfPropertyMessage));
+            WriteString(data, head.mid(1));
+            WriteValue(data, value);
+            return data;
+        }
+
+        quint32 index;
+        int second = value.indexOf(' ');
+        if(head.at(0) == '#' && second != -1 && ParsePlayerName(head.mid(1), index)){
+            data.append(char(OtherPropertyMessage));
+            WriteVarint(data, index);
+            WriteString(data, value.left(second));
+            WriteValue(data, value.mid(second + 1));
+            return data;
+        }
+
+        int method_id = GetMethodId(head);
+        if(method_id != UnknownMethod){
+            data.append(char(InvokeMessage));
+            WriteVarint(data, method_id);
+            WriteValue(data, value);
+            return data;
+        }
+    }
+
+    data.append(char(RawMessage));
+    data.append(text);
+    return data;
+}
+
+QByteArray BinaryProtocol::Decode(const QByteArray &payload){
+    if(payload.isEmpty())
+        return QByteArray();
+
+    MessageKind kind = MessageKind(payload.at(0));
+    int pos = 1;
+    QByteArray value;
+
+    switch(kind){
+    case RawMessage: return payload.mid(1);
+
+    case InvokeMessage:{
+            quint32 method_id;
+            if(!ReadVarint(payload, pos, method_id))
+                break;
+
+            QString method_name = GetMethodName(method_id);
+            if(method_name.isEmpty() || !ReadValue(payload, pos, value))
+                break;
+
+            return method_name.toAscii() + ' ' + value;
+        }
+
+    case SelfPropertyMessage:{
+            QByteArray property;
+            if(!ReadString(payload, pos, property) || !ReadValue(payload, pos, value))
+                break;
+
+            return '.' + property + ' ' + value;
+        }
+
+    case OtherPropertyMessage:{
+            quint32 index;
+            QByteArray property;
+            if(!ReadVarint(payload, pos, index) || !ReadString(payload, pos, property)
+                || !ReadValue(payload, pos, value))
+                break;
+
+            return "#sgs" + QByteArray::number(index) + ' ' + property + ' ' + value;
+        }
+    }
+
+    return QByteArray();
+}
+
+QByteArray BinaryProtocol::Frame(const QString &message){
+    QByteArray payload = Encode(message);
+
+    QByteArray frame;
+    frame.append(char(FrameMarker));
+    WriteVarint(frame, payload.size());
+    frame.append(payload);
+
+    return frame;
+}
+
+BinaryProtocol::HeaderStatus BinaryProtocol::ReadHeader(const QByteArray &head, quint32 &length, int &header_size){
+    int pos = 1;
+    quint32 n;
+    if(!ReadVarint(head, pos, n)){
+        // a varint of a quint32 never takes more than 5 bytes
+        return head.size() > 5 ? HeaderMalformed : HeaderIncomplete;
+    }
+
+    // the fifth byte may only carry the highest 4 bits
+    if(pos == 6 && uchar(head.at(5)) > 0x0F)
+        return HeaderMalformed;
+
+    if(n > MaxFrameSize)
+        return HeaderMalformed;
+
+    length = n;
+    header_size = pos;
+    return HeaderComplete;
+}
+
+QString BinaryProtocol::Benchmark(const QString &filename){
+    QByteArray data;
+    if(filename.endsWith(".png"))
+        data = Replayer::PNG2TXT(filename);
+    else{
+        QFile file(filename);
+        if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+            data = file.readAll();
+    }
+
+    // a recorded line is "elapsed message"
+    QStringList messages;
+    foreach(QByteArray line, data.split('\n')){
+        int space = line.indexOf(' ');
+        if(space != -1)
+            messages << line.mid(space + 1);
+    }
+
+    if(messages.isEmpty())
+        return QString("No message is found in %1").arg(filename);
+
+    qint64 text_bytes = 0, binary_bytes = 0;
+    int mismatched = 0;
+    foreach(QString message, messages){
+        text_bytes += message.toAscii().size() + 1;
+        binary_bytes += Frame(message).size();
+
+        if(Decode(Encode(message)) != message.toAscii())
+            mismatched ++;
+    }
+
+    static const int rounds = 100;
+    QElapsedTimer timer;
+    int i;
+
+    timer.start();
+    for(i=0; i<rounds; i++){
+        foreach(QString message, messages){
+            QByteArray line = message.toAscii();
+            line.append('\n');
+            line.simplified().split(' ');
+        }
+    }
+    qint64 text_msecs = timer.elapsed();
+
+    timer.start();
+    for(i=0; i<rounds; i++){
+        foreach(QString message, messages){
+            QByteArray line = Decode(Encode(message));
+            line.append('\n');
+            line.simplified().split(' ');
+        }
+    }
+    qint64 binary_msecs = timer.elapsed();
+
+    qreal total = qreal(messages.length()) * rounds;
+    QStringList report;
+    report << QString("%1 messages in %2").arg(messages.length()).arg(filename)
+           << QString("text:   %1 bytes, %2 bytes/message, %3 us/message")
+              .arg(text_bytes).arg(qreal(text_bytes) / messages.length(), 0, 'f', 2)
+              .arg(text_msecs * 1000.0 / total, 0, 'f', 3)
+           << QString("binary: %1 bytes, %2 bytes/message, %3 us/message")
+              .arg(binary_bytes).arg(qreal(binary_bytes) / messages.length(), 0, 'f', 2)
+              .arg(binary_msecs * 1000.0 / total, 0, 'f', 3)
+           << QString("%1 messages do not survive a round trip").arg(mismatched);
+
+    return report.join("\n");
+}
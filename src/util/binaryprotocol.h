@@ -0,0 +1,66 @@
+#ifndef BINARYPROTOCOL_H
+#define BINARYPROTOCOL_H
+
+#include <QString>
+#include <QByteArray>
+
+// Length-prefixed binary frames carrying the same messages as the text line protocol.
+// A frame starts with FrameMarker, which never begins a text line since text messages
+// are plain ASCII, so a receiver can tell both kinds apart message by message.
+class BinaryProtocol{
+public:
+    enum MethodId{
+        UnknownMethod = 0,
+
+        // server to client
+        CheckVersion, RoomBegin, RoomInfo, RoomEnd, RoomCreated, RoomError, HallEntered,
+        Setup, AddPlayer, RemovePlayer, StartInXs, ArrangeSeats, Warn, StartGame, GameOver,
+        HpChange, KillPlayer, RevivePlayer, ShowCard, SetMark, Log, Speak,
+        AcquireSkill, AttachSkill, DetachSkill, MoveFocus, SetEmotion, SkillInvoked, AddHistory,
+        Animate, JudgeResult, SetScreenName, SetFixedDistance, Transfigure, Jilei, Pile,
+        UpdateStateItem, PlaySkillEffect, PlayCardEffect, PlayAudio,
+        MoveNCards, MoveCard, DrawNCards, DrawCards, ClearPile, SetPileNumber,
+        Activate, DoChooseGeneral, DoChooseGeneral2, DoGuanxing, DoGongxin,
+        AskForDiscard, AskForExchange, AskForSuit, AskForKingdom, AskForSinglePeach,
+        AskForCardChosen, AskForCard, AskForUseCard, AskForSkillInvoke, AskForChoice,
+        AskForNullification, AskForCardShow, AskForPindian, AskForYiji, AskForPlayerChosen,
+        AskForGeneral, FillAG, AskForAG, TakeAG, ClearAG, FillGenerals,
+        AskForGeneral3v3, AskForGeneral1v1, TakeGeneral, StartArrange, AskForOrder, AskForRole,
+        AskForDirection, RecoverGeneral, RevealGeneral, AskForAssign,
+
+        // client to server
+        Protocol, Signup, SignupR,
+        UseCard, InvokeSkill, ReplyNullification, ChooseCard, ResponseCard, DiscardCards,
+        ChooseSuit, ChooseKingdom, ChooseAG, ChoosePlayer, ChooseGeneral, SelectChoice,
+        ReplyYiji, ReplyGuanxing, ReplyGongxin, AssignRoles, ToggleReady, AddRobot, FillRobots,
+        Choose, Choose2, Arrange, SelectOrder, SelectRole, Trust, Kick, Surrender,
+
+        NumOfMethods
+    };
+
+    static const uchar FrameMarker = 0xB1;
+
+    // no message comes near it, a longer frame or text line is taken as an attack
+    static const quint32 MaxFrameSize = 1 << 20;
+
+    enum HeaderStatus{
+        HeaderIncomplete,
+        HeaderComplete,
+        HeaderMalformed
+    };
+
+    static QByteArray Frame(const QString &message);
+    static QByteArray Encode(const QString &message);
+    static QByteArray Decode(const QByteArray &payload);
+
+    // reads the frame length after the marker, a length that does not fit in 5 bytes
+    // or is longer than MaxFrameSize makes the header malformed
+    static HeaderStatus ReadHeader(const QByteArray &head, quint32 &length, int &header_size);
+
+    static int GetMethodId(const QString &method_name);
+    static QString GetMethodName(int method_id);
+
+    static QString Benchmark(const QString &filename);
+};
+
+#endif // BINARYPROTOCOL_H
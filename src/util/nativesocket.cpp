@@ -1,5 +1,6 @@
 #include "nativesocket.h"
 #include "settings.h"
+#include "binaryprotocol.h"
 
 #include <QTcpSocket>
 #include <QRegExp>
@@ -46,13 +47,13 @@ void NativeServerSocket::processNewConnection(){
 // ---------------------------------
 
 NativeClientSocket::NativeClientSocket()    
-    :socket(new QTcpSocket(this))
+    :socket(new QTcpSocket(this)), binary(false)
 {
     init();
 }
 
 NativeClientSocket::NativeClientSocket(QTcpSocket *socket)
-    :socket(socket)
+    :socket(socket), binary(false)
 {
     socket->setParent(this);
     init();
@@ -82,21 +83,82 @@ void NativeClientSocket::connectToHost(){
 }
 
 void NativeClientSocket::getMessage(){
-    while(socket->canReadLine()){
-        buffer_t msg;
-        socket->readLine(msg, sizeof(msg));        
-
-        emit message_got(msg);
+    forever{
+        char first;
+        if(socket->peek(&first, 1) != 1)
+            break;
+
+        QByteArray msg;
+        if(uchar(first) == BinaryProtocol::FrameMarker){
+            quint32 length;
+            int header_size;
+            BinaryProtocol::HeaderStatus status = BinaryProtocol::ReadHeader(socket->peek(6), length, header_size);
+            if(status == BinaryProtocol::HeaderMalformed){
+                dropPeer();
+                return;
+            }
+
+            if(status == BinaryProtocol::HeaderIncomplete || socket->bytesAvailable() < header_size + qint64(length))
+                break;
+
+            socket->read(header_size);
+            msg = BinaryProtocol::Decode(socket->read(length));
+            msg.append('\n');
+        }else if(socket->canReadLine()){
+            msg = socket->readLine();
+        }else{
+            // a text line is never longer than a frame either
+            if(socket->bytesAvailable() > BinaryProtocol::MaxFrameSize)
+                dropPeer();
+
+            break;
+        }
+
+        emit message_got(msg.data());
     }
 }
 
+void NativeClientSocket::dropPeer(){
+    // what the peer sent can not be trusted any more, so nothing more is read from it
+    emit error_message(tr("Malformed message from %1, the connection is closed").arg(peerName()));
+    socket->abort();
+}
+
 void NativeClientSocket::disconnectFromHost(){    
     socket->disconnectFromHost();
 }
 
 void NativeClientSocket::send(const QString &message){
-    socket->write(message.toAscii());
-    socket->write("\n");
+    if(binary){
+        socket->write(BinaryProtocol::Frame(message));
+    }else{
+        QByteArray data = message.toAscii();
+        data.append('\n');
+        socket->write(data);
+    }
+}
+
+void NativeClientSocket::send(const QStringList &messages){
+    // all the messages go out in one write
+    QByteArray data;
+    foreach(QString message, messages){
+        if(binary){
+            data.append(BinaryProtocol::Frame(message));
+        }else{
+            data.append(message.toAscii());
+            data.append('\n');
+        }
+    }
+
+    socket->write(data);
+}
+
+void NativeClientSocket::setBinary(bool binary){
+    this->binary = binary;
+}
+
+bool NativeClientSocket::isBinary() const{
+    return binary;
 }
 
 bool NativeClientSocket::isConnected() const{
@@ -34,9 +34,12 @@ public:
     virtual void connectToHost();
     virtual void disconnectFromHost();
     virtual void send(const QString &message);
+    virtual void send(const QStringList &messages);
     virtual bool isConnected() const;
     virtual QString peerName() const;
     virtual QString peerAddress() const;
+    virtual void setBinary(bool binary);
+    virtual bool isBinary() const;
 
 private slots:
     void getMessage();
@@ -44,8 +47,10 @@ private slots:
 
 private:
     QTcpSocket * const socket;
+    bool binary;
 
     void init();
+    void dropPeer();
 };
 
 #endif // NATIVESOCKET_H
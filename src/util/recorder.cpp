@@ -6,11 +6,41 @@
 
 #include <QFile>
 #include <QBuffer>
+#include <QDataStream>
+#include <QStringList>
+
+using namespace ReplayFormat;
+
+static void WriteChunk(QIODevice *device, int type, const QByteArray &payload){
+    QDataStream out(device);
+    out << quint8(type) << quint32(payload.size());
+    out.writeRawData(payload.constData(), payload.size());
+}
+
+static bool ReadChunk(QIODevice *device, quint8 &type, QByteArray &payload){
+    QDataStream in(device);
+    quint32 size;
+    in >> type >> size;
+    if(in.status() != QDataStream::Ok)
+        return false;
+
+    // a corrupt or truncated file may claim any size, it must not be allocated
+    if(size > quint64(device->bytesAvailable()))
+        return false;
+
+    payload = device->read(size);
+    return payload.size() == int(size);
+}
 
 Recorder::Recorder(QObject *parent)
-    :QObject(parent)
+    :QObject(parent), last_elapsed(0), random_seed(0), capture_thread(NULL), keyframe_turn(0)
 {
     watch.start();
+
+    if(stream.open()){
+        QDataStream out(&stream);
+        out << Magic << Version;
+    }
 }
 
 void Recorder::record(char *line)
@@ -19,22 +49,145 @@ void Recorder::record(char *line)
 }
 
 void Recorder::recordLine(const QString &line){
+    QMutexLocker locker(&mutex);
+
+    if(capture_thread == QThread::currentThread()){
+        if(line.endsWith("\n"))
+            keyframe.append(line);
+        else
+            keyframe.append(line + "\n");
+
+        return;
+    }
+
     int elapsed = watch.elapsed();
+    last_elapsed = elapsed;
+
+    if(random_seed == 0 && line.startsWith("randomSeed "))
+        random_seed = line.mid(11).trimmed().toULongLong();
+
+    if(setup_line.isEmpty() && line.startsWith("setup "))
+        setup_line = line.endsWith("\n") ? line : line + "\n";
+
     if(line.endsWith("\n"))
-        data.append(QString("%1 %2").arg(elapsed).arg(line));
+        lines.append(QString("%1 %2").arg(elapsed).arg(line));
     else
-        data.append(QString("%1 %2\n").arg(elapsed).arg(line));
+        lines.append(QString("%1 %2\n").arg(elapsed).arg(line));
+
+    if(lines.size() >= ChunkSize)
+        flushLines();
+}
+
+void Recorder::startKeyframe(int turn){
+    QMutexLocker locker(&mutex);
+
+    // the lines before the keyframe must come before it in the file
+    flushLines();
+
+    capture_thread = QThread::currentThread();
+    keyframe_turn = turn;
+    keyframe.clear();
+    keyframe.append(setup_line);
+}
+
+void Recorder::finishKeyframe(){
+    QMutexLocker locker(&mutex);
+
+    if(capture_thread == NULL)
+        return;
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(keyframe_turn) << qint32(watch.elapsed());
+    payload.append(qCompress(keyframe));
+
+    if(stream.isOpen()){
+        keyframes.insert(keyframe_turn, stream.pos());
+        WriteChunk(&stream, KeyframeChunk, payload);
+    }
+
+    capture_thread = NULL;
+    keyframe.clear();
+}
+
+bool Recorder::isCapturing() const{
+    QMutexLocker locker(&mutex);
+    return capture_thread != NULL && capture_thread == QThread::currentThread();
+}
+
+void Recorder::flushLines() const{
+    if(lines.isEmpty() || !stream.isOpen())
+        return;
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(last_elapsed);
+    payload.append(qCompress(lines));
+
+    WriteChunk(&stream, LinesChunk, payload);
+    lines.clear();
+}
+
+QByteArray Recorder::toText() const{
+    QByteArray text;
+
+    stream.seek(0);
+    QDataStream in(&stream);
+    quint32 magic, version;
+    in >> magic >> version;
+
+    quint8 type;
+    QByteArray payload;
+    while(ReadChunk(&stream, type, payload)){
+        if(type == LinesChunk)
+            text.append(qUncompress(payload.mid(sizeof(qint32))));
+    }
+
+    stream.seek(stream.size());
+    return text;
 }
 
 bool Recorder::save(const QString &filename) const{
-    if(filename.endsWith(".txt")){
+    QMutexLocker locker(&mutex);
+
+    flushLines();
+
+    if(filename.endsWith(".qsgs")){
+        QFile file(filename);
+        if(!file.open(QIODevice::WriteOnly))
+            return false;
+
+        // the recording goes on after a save, so the index is only written to the copy
+        stream.seek(0);
+        while(!stream.atEnd())
+            file.write(stream.read(64 * 1024));
+        stream.seek(stream.size());
+
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out << qint32(last_elapsed) << random_seed << qint32(keyframes.size());
+
+        QMapIterator<int, qint64> itor(keyframes);
+        while(itor.hasNext()){
+            itor.next();
+            out << qint32(itor.key()) << qint64(itor.value());
+        }
+
+        quint64 index_offset = file.pos();
+        WriteChunk(&file, IndexChunk, payload);
+
+        QDataStream trailer(&file);
+        trailer << index_offset << IndexMagic;
+
+        return trailer.status() == QDataStream::Ok;
+    }else if(filename.endsWith(".txt")){
         QFile file(filename);
         if(file.open(QIODevice::WriteOnly | QIODevice::Text))
-            return file.write(data) != -1;
+            return file.write(toText()) != -1;
         else
             return false;
     }else if(filename.endsWith(".png")){
-        return TXT2PNG(data).save(filename);
+        return TXT2PNG(toText()).save(filename);
     }else
         return false;
 }
@@ -57,8 +210,19 @@ QImage Recorder::TXT2PNG(QByteArray txtData){
 }
 
 Replayer::Replayer(QObject *parent, const QString &filename)
-    :QThread(parent), filename(filename), speed(1.0), playing(true)
+    :QThread(parent), filename(filename), random_seed(0), speed(1.0), playing(true),
+      streaming(false), duration(0), start_offset(0)
 {
+    if(filename.endsWith(".qsgs")){
+        streaming = true;
+
+        QFile file(filename);
+        if(file.open(QIODevice::ReadOnly))
+            loadIndex(file);
+
+        return;
+    }
+
     QIODevice *device = NULL;
     if(filename.endsWith(".png")){
         QByteArray *data = new QByteArray(PNG2TXT(filename));
@@ -90,6 +254,10 @@ Replayer::Replayer(QObject *parent, const QString &filename)
         QString cmd = space + 1;
         int elapsed = atoi(line);
 
+        // the room sends its seed right after a player joins
+        if(random_seed == 0 && cmd.startsWith("randomSeed "))
+            random_seed = cmd.mid(11).trimmed().toULongLong();
+
         Pair pair;
         pair.elapsed = elapsed;
         pair.cmd = cmd;
@@ -97,9 +265,84 @@ Replayer::Replayer(QObject *parent, const QString &filename)
         pairs << pair;
     }
 
+    if(!pairs.isEmpty())
+        duration = pairs.last().elapsed;
+
     delete device;
 }
 
+bool Replayer::loadIndex(QFile &file){
+    QDataStream in(&file);
+    quint32 magic, version;
+    in >> magic >> version;
+    if(in.status() != QDataStream::Ok || magic != ReplayFormat::Magic)
+        return false;
+
+    start_offset = file.pos();
+
+    // the index is found through the offset at the end of the file
+    static const int TrailerSize = sizeof(quint64) + sizeof(quint32);
+    if(file.size() >= start_offset + TrailerSize){
+        file.seek(file.size() - TrailerSize);
+
+        quint64 index_offset;
+        quint32 index_magic;
+        in >> index_offset >> index_magic;
+
+        quint8 type;
+        QByteArray payload;
+        if(index_magic == ReplayFormat::IndexMagic && file.seek(index_offset)
+                && ReadChunk(&file, type, payload) && type == ReplayFormat::IndexChunk){
+            QDataStream index(payload);
+            qint32 last_elapsed, count;
+            index >> last_elapsed >> random_seed >> count;
+            duration = last_elapsed;
+
+            // the count is not trusted either, the entries end with the payload
+            int i;
+            for(i=0; i<count; i++){
+                qint32 turn;
+                qint64 offset;
+                index >> turn >> offset;
+                if(index.status() != QDataStream::Ok)
+                    break;
+
+                keyframes.insert(turn, offset);
+            }
+
+            return true;
+        }
+    }
+
+    // a replay that was never finished has no index, it is rebuilt from the chunk headers
+    file.seek(start_offset);
+    while(!file.atEnd()){
+        qint64 offset = file.pos();
+
+        quint8 type;
+        quint32 size;
+        in >> type >> size;
+        if(in.status() != QDataStream::Ok)
+            break;
+
+        QDataStream head(file.read(qMin(size, quint32(8))));
+        if(type == ReplayFormat::LinesChunk){
+            qint32 last_elapsed;
+            head >> last_elapsed;
+            duration = last_elapsed;
+        }else if(type == ReplayFormat::KeyframeChunk){
+            qint32 turn;
+            head >> turn;
+            keyframes.insert(turn, offset);
+        }
+
+        if(!file.seek(offset + sizeof(quint8) + sizeof(quint32) + size))
+            break;
+    }
+
+    return true;
+}
+
 QByteArray Replayer::PNG2TXT(const QString filename){
     QImage image(filename);
     image = image.convertToFormat(QImage::Format_ARGB32);
@@ -112,7 +355,29 @@ QByteArray Replayer::PNG2TXT(const QString filename){
 }
 
 int Replayer::getDuration() const{
-    return pairs.last().elapsed / 1000.0;
+    return duration / 1000.0;
+}
+
+quint64 Replayer::getRandomSeed() const{
+    return random_seed;
+}
+
+QList<int> Replayer::getKeyframeTurns() const{
+    return keyframes.keys();
+}
+
+bool Replayer::seek(int turn){
+    if(!streaming || isRunning())
+        return false;
+
+    // start from the last keyframe that is not after the turn
+    QMap<int, qint64>::const_iterator itor = keyframes.upperBound(turn);
+    if(itor == keyframes.constBegin())
+        return false;
+
+    --itor;
+    start_offset = itor.value();
+    return true;
 }
 
 qreal Replayer::getSpeed() {
@@ -164,35 +429,90 @@ void Replayer::toggle(){
         play_sem.release(); // to play
 }
 
+void Replayer::play(int elapsed, const QString &cmd, int &last){
+    static QStringList nondelays;
+    if(nondelays.isEmpty())
+        nondelays << "addPlayer" << "removePlayer" << "speak";
+
+    int delay = qMin(elapsed - last, 2500);
+    last = elapsed;
+
+    bool delayed = true;
+    foreach(QString nondelay, nondelays){
+        if(cmd.startsWith(nondelay)){
+            delayed = false;
+            break;
+        }
+    }
+
+    if(delayed){
+        delay /= getSpeed();
+
+        msleep(delay);
+        emit elasped(elapsed / 1000.0);
+
+        if(!playing)
+            play_sem.acquire();
+    }
+
+    emit command_parsed(cmd);
+}
+
 void Replayer::run(){
-    int last = 0;
+    if(streaming){
+        runStream();
+        return;
+    }
 
-    QStringList nondelays;
-    nondelays << "addPlayer" << "removePlayer" << "speak";
+    int last = 0;
+    foreach(Pair pair, pairs)
+        play(pair.elapsed, pair.cmd, last);
+}
 
-    foreach(Pair pair, pairs){
-        int delay = qMin(pair.elapsed - last, 2500);
-        last = pair.elapsed;
+void Replayer::runStream(){
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly) || !file.seek(start_offset))
+        return;
 
-        bool delayed = true;
-        foreach(QString nondelay, nondelays){
-            if(pair.cmd.startsWith(nondelay)){
-                delayed = false;
-                break;
+    // only one chunk is held in memory at a time
+    int last = 0;
+    bool first = true;
+    quint8 type;
+    QByteArray payload;
+    while(ReadChunk(&file, type, payload)){
+        if(type == ReplayFormat::IndexChunk)
+            break;
+
+        if(type == ReplayFormat::KeyframeChunk){
+            // only the keyframe that was seeked to is played, at once
+            if(first){
+                QDataStream head(payload);
+                qint32 turn, elapsed;
+                head >> turn >> elapsed;
+                last = elapsed;
+                emit elasped(elapsed / 1000.0);
+
+                foreach(QByteArray line, qUncompress(payload.mid(2 * sizeof(qint32))).split('\n')){
+                    if(!line.isEmpty())
+                        emit command_parsed(QString(line.append('\n')));
+                }
             }
-        }
+        }else if(type == ReplayFormat::LinesChunk){
+            foreach(QByteArray line, qUncompress(payload.mid(sizeof(qint32))).split('\n')){
+                int space = line.indexOf(' ');
+                if(space == -1)
+                    continue;
 
-        if(delayed){
-            delay /= getSpeed();
+                int elapsed = line.left(space).toInt();
+                QString cmd = line.mid(space + 1).append('\n');
 
-            msleep(delay);
-            emit elasped(pair.elapsed / 1000.0);
+                if(random_seed == 0 && cmd.startsWith("randomSeed "))
+                    random_seed = cmd.mid(11).trimmed().toULongLong();
 
-            if(!playing)
-                play_sem.acquire();
+                play(elapsed, cmd, last);
+            }
         }
 
-        emit command_parsed(pair.cmd);
+        first = false;
     }
 }
-
@@ -7,6 +7,25 @@
 #include <QMutex>
 #include <QSemaphore>
 #include <QImage>
+#include <QTemporaryFile>
+#include <QMap>
+
+// a .qsgs replay is a header and a list of chunks, each chunk is a type, a size and the payload,
+// the lines are compressed a chunk at a time, a keyframe holds the setup line and what Room::marshal
+// would send to the recording player at the start of a turn, and the index of the keyframes
+// is written last, followed by its offset so that it can be found from the end of the file
+namespace ReplayFormat{
+    enum ChunkType{
+        LinesChunk = 1,
+        KeyframeChunk = 2,
+        IndexChunk = 3
+    };
+
+    static const quint32 Magic = 0x51534753; // "QSGS"
+    static const quint32 IndexMagic = 0x51534749; // "QSGI"
+    static const quint32 Version = 1;
+    static const int ChunkSize = 32 * 1024;
+}
 
 class Recorder : public QObject
 {
@@ -17,12 +36,36 @@ public:
     bool save(const QString &filename) const;
     void recordLine(const QString &line);
 
+    // while a keyframe is open, the lines from the thread that opened it go into the keyframe
+    void startKeyframe(int turn);
+    void finishKeyframe();
+    bool isCapturing() const;
+
 public slots:
     void record(char *line);
 
 private:
     QTime watch;
-    QByteArray data;
+    mutable QMutex mutex;
+
+    // the chunks are written to a temporary file as the game goes on
+    mutable QTemporaryFile stream;
+    mutable QByteArray lines;
+    int last_elapsed;
+    quint64 random_seed;
+
+    // the first setup line, it goes at the head of every keyframe, so that a replay
+    // that starts from a keyframe enters the room as well
+    QString setup_line;
+
+    QThread *capture_thread;
+    int keyframe_turn;
+    QByteArray keyframe;
+    QMap<int, qint64> keyframes;
+
+    void writeChunk(int type, const QByteArray &payload) const;
+    void flushLines() const;
+    QByteArray toText() const;
 };
 
 class Replayer: public QThread
@@ -34,8 +77,13 @@ public:
     static QByteArray PNG2TXT(const QString filename);
 
     int getDuration() const;
+    quint64 getRandomSeed() const;
     qreal getSpeed();
 
+    // only for .qsgs replays, and only before the replay is started
+    QList<int> getKeyframeTurns() const;
+    bool seek(int turn);
+
 public slots:
     void uniform();
     void toggle();
@@ -47,6 +95,7 @@ protected:
 
 private:
     QString filename;
+    quint64 random_seed;
     qreal speed;
     bool playing;
     QMutex mutex;
@@ -58,6 +107,16 @@ private:
     };
     QList<Pair> pairs;
 
+    // a .qsgs replay is read from the disk while it is played
+    bool streaming;
+    int duration;
+    QMap<int, qint64> keyframes;
+    qint64 start_offset;
+
+    bool loadIndex(QFile &file);
+    void play(int elapsed, const QString &cmd, int &last);
+    void runStream();
+
 signals:
     void command_parsed(const QString &cmd);
     void elasped(int secs);
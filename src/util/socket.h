@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QTcpSocket>
 #include <QTcpServer>
+#include <QStringList>
 
 class ClientSocket;
 
@@ -25,10 +26,15 @@ public:
     virtual void connectToHost() = 0;
     virtual void disconnectFromHost() = 0;
     virtual void send(const QString &message) = 0;
+    virtual void send(const QStringList &messages) = 0;
     virtual bool isConnected() const = 0;
     virtual QString peerName() const = 0;
     virtual QString peerAddress() const = 0;
 
+    // frames are always accepted, this only switches what send() writes
+    virtual void setBinary(bool binary) = 0;
+    virtual bool isBinary() const = 0;
+
 signals:
     void message_got(char *msg);
     void error_message(const QString &msg);
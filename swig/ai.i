@@ -99,7 +99,7 @@ bool LuaAI::askForSkillInvoke(const QString &skill_name, const QVariant &data) {
 	lua_pushstring(L, skill_name.toAscii());
 	SWIG_NewPointerObj(L, &data, SWIGTYPE_p_QVariant, 0);
 
-	int error = lua_pcall(L, 3, 1, 0);
+	int error = LuaCall(L, 3, 1);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -121,7 +121,7 @@ void LuaAI::activate(CardUseStruct &card_use) {
 	pushCallback(L, __func__);
 	SWIG_NewPointerObj(L, &card_use, SWIGTYPE_p_CardUseStruct, 0);
 
-	int error = lua_pcall(L, 2, 0, 0);
+	int error = LuaCall(L, 2, 0);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -140,9 +140,9 @@ AI *Room::cloneAI(ServerPlayer *player){
 
 	lua_getglobal(L, "CloneAI");
 
-	SWIG_NewPointerObj(L, player, SWIGTYPE_p_ServerPlayer, 0);
+	PushCachedPointer(L, player, SWIGTYPE_p_ServerPlayer);
 
-	int error = lua_pcall(L, 1, 1, 0);
+	int error = LuaCall(L, 1, 1);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -176,7 +176,7 @@ ServerPlayer *LuaAI::askForYiji(const QList<int> &cards, int &card_id){
 		lua_rawseti(L, -2, i+1);
 	}
 
-	int error = lua_pcall(L, 2, 2, 0);
+	int error = LuaCall(L, 2, 2);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -205,10 +205,10 @@ void LuaAI::filterEvent(TriggerEvent event, ServerPlayer *player, const QVariant
 
 	pushCallback(L, __func__);
 	lua_pushinteger(L, event);
-	SWIG_NewPointerObj(L, player, SWIGTYPE_p_ServerPlayer, 0);
+	PushCachedPointer(L, player, SWIGTYPE_p_ServerPlayer);
 	SWIG_NewPointerObj(L, &data, SWIGTYPE_p_QVariant, 0);
 
-	int error = lua_pcall(L, 4, 0, 0);
+	int error = LuaCall(L, 4, 0);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -216,6 +216,45 @@ void LuaAI::filterEvent(TriggerEvent event, ServerPlayer *player, const QVariant
 	}
 }
 
+void Room::updateAIDispatch(){
+	ai_dispatch = false;
+	if(L == NULL || ais.isEmpty())
+		return;
+
+	// the Lua dispatcher only knows the AIs made by CloneAI
+	foreach(AI *ai, ais){
+		LuaAI *lua_ai = qobject_cast<LuaAI *>(ai);
+		if(lua_ai == NULL || lua_ai->callback == 0)
+			return;
+	}
+
+	lua_getglobal(L, "FilterEvents");
+	ai_dispatch = lua_isfunction(L, -1);
+	lua_pop(L, 1);
+}
+
+void Room::filterEvents(TriggerEvent event, ServerPlayer *target, const QVariant &data){
+	if(!ai_dispatch){
+		foreach(AI *ai, ais)
+			ai->filterEvent(event, target, data);
+
+		return;
+	}
+
+	// one call delivers the event to every AI of the room, in the order of ais
+	lua_getglobal(L, "FilterEvents");
+	lua_pushinteger(L, event);
+	PushCachedPointer(L, target, SWIGTYPE_p_ServerPlayer);
+	SWIG_NewPointerObj(L, &data, SWIGTYPE_p_QVariant, 0);
+
+	int error = LuaCall(L, 3, 0);
+	if(error){
+		const char *error_msg = lua_tostring(L, -1);
+		lua_pop(L, 1);
+		output(error_msg);
+	}
+}
+
 const Card *LuaAI::askForCard(const QString &pattern, const QString &prompt, const QVariant &data){
 	lua_State *L = room->getLuaState();
 
@@ -224,7 +263,7 @@ const Card *LuaAI::askForCard(const QString &pattern, const QString &prompt, con
 	lua_pushstring(L, prompt.toAscii());
 	SWIG_NewPointerObj(L, &data, SWIGTYPE_p_QVariant, 0);
 
-	int error = lua_pcall(L, 4, 1, 0);
+	int error = LuaCall(L, 4, 1);
 	const char *result = lua_tostring(L, -1);
 	lua_pop(L, 1);
 	if(error){
@@ -246,7 +285,7 @@ int LuaAI::askForCardChosen(ServerPlayer *who, const QString &flags, const QStri
 	lua_pushstring(L, flags.toAscii());
 	lua_pushstring(L, reason.toAscii());
 
-	int error = lua_pcall(L, 4, 1, 0);
+	int error = LuaCall(L, 4, 1);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -273,7 +312,7 @@ ServerPlayer *LuaAI::askForPlayerChosen(const QList<ServerPlayer *> &targets, co
 	SWIG_NewPointerObj(L, &targets, SWIGTYPE_p_QListT_ServerPlayer_p_t, 0);
 	lua_pushstring(L, reason.toAscii());
 
-	int error = lua_pcall(L, 3, 1, 0);
+	int error = LuaCall(L, 3, 1);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -301,7 +340,7 @@ const Card *LuaAI::askForNullification(const TrickCard *trick, ServerPlayer *fro
 	SWIG_NewPointerObj(L, to, SWIGTYPE_p_ServerPlayer, 0);
 	lua_pushboolean(L, positive);
 
-	int error = lua_pcall(L, 5, 1, 0);
+	int error = LuaCall(L, 5, 1);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -326,7 +365,7 @@ const Card *LuaAI::askForCardShow(ServerPlayer *requestor, const QString &reason
 	SWIG_NewPointerObj(L, requestor, SWIGTYPE_p_ServerPlayer, 0);
 	lua_pushstring(L, reason.toAscii());
 
-	int error = lua_pcall(L, 3, 1, 0);
+	int error = LuaCall(L, 3, 1);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -349,7 +388,7 @@ const Card *LuaAI::askForSinglePeach(ServerPlayer *dying){
 		pushCallback(L, __func__);
 	SWIG_NewPointerObj(L, dying, SWIGTYPE_p_ServerPlayer, 0);
 
-	int error = lua_pcall(L, 2, 1, 0);
+	int error = LuaCall(L, 2, 1);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -372,7 +411,7 @@ const Card *LuaAI::askForPindian(ServerPlayer *requestor, const QString &reason)
 	SWIG_NewPointerObj(L, requestor, SWIGTYPE_p_ServerPlayer, 0);
 	lua_pushstring(L, reason.toAscii());
 
-	int error = lua_pcall(L, 3, 1, 0);
+	int error = LuaCall(L, 3, 1);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -394,7 +433,7 @@ Card::Suit LuaAI::askForSuit(){
 	lua_State *L = room->getLuaState();
 
 	pushCallback(L, __func__);
-	int error = lua_pcall(L, 1, 1, 0);
+	int error = LuaCall(L, 1, 1);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
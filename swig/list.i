@@ -25,4 +25,316 @@ public:
 %template(CardList) QList<const Card *>;
 %template(IntList) QList<int>;
 %template(SkillList) QList<const Skill *>;
-%template(ItemList) QList<CardItem *>;
\ No newline at end of file
+%template(ItemList) QList<CardItem *>;
+
+%native(ListView) int ListView(lua_State *L);
+%native(ListNext) int ListNext(lua_State *L);
+%native(QList2Table) int QList2Table(lua_State *L);
+
+%{
+
+#include "lua-wrapper.h"
+
+static char LuaPointerCacheKey;
+static const char *ListViewMetatable = "sgs.ListView";
+
+// pushes registry[&LuaPointerCacheKey][type], which maps the pointers of this type to their userdata
+static void PushPointerCache(lua_State *L, swig_type_info *type){
+	lua_pushlightuserdata(L, &LuaPointerCacheKey);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	if(lua_isnil(L, -1)){
+		lua_pop(L, 1);
+		lua_newtable(L);
+		lua_pushlightuserdata(L, &LuaPointerCacheKey);
+		lua_pushvalue(L, -2);
+		lua_rawset(L, LUA_REGISTRYINDEX);
+	}
+
+	lua_pushlightuserdata(L, type);
+	lua_rawget(L, -2);
+	if(lua_isnil(L, -1)){
+		lua_pop(L, 1);
+		lua_newtable(L);
+
+		// the values are weak, so the userdata of the deleted objects are collected at last
+		lua_newtable(L);
+		lua_pushliteral(L, "v");
+		lua_setfield(L, -2, "__mode");
+		lua_setmetatable(L, -2);
+
+		lua_pushlightuserdata(L, type);
+		lua_pushvalue(L, -2);
+		lua_rawset(L, -4);
+	}
+
+	lua_remove(L, -2);
+}
+
+// the cache is the absolute index of the table pushed by PushPointerCache
+static void PushFromPointerCache(lua_State *L, const void *ptr, swig_type_info *type, int cache, LuaCallCount *count){
+	if(ptr == NULL){
+		lua_pushnil(L);
+		return;
+	}
+
+	void *key = const_cast<void *>(ptr);
+	lua_pushlightuserdata(L, key);
+	lua_rawget(L, cache);
+	if(lua_isnil(L, -1)){
+		lua_pop(L, 1);
+		SWIG_NewPointerObj(L, key, type, 0);
+		lua_pushlightuserdata(L, key);
+		lua_pushvalue(L, -2);
+		lua_rawset(L, cache);
+
+		count->userdata ++;
+	}else
+		count->cache_hits ++;
+}
+
+static void PushCachedPointer(lua_State *L, const void *ptr, swig_type_info *type){
+	if(ptr == NULL){
+		lua_pushnil(L);
+		return;
+	}
+
+	PushPointerCache(L, type);
+	PushFromPointerCache(L, ptr, type, lua_gettop(L), GetLuaCallCount(L));
+	lua_remove(L, -2);
+}
+
+template <typename T>
+struct ListElement{
+	static void Push(lua_State *L, T elem, swig_type_info *type, int cache, LuaCallCount *count){
+		PushFromPointerCache(L, elem, type, cache, count);
+	}
+};
+
+template <>
+struct ListElement<int>{
+	static void Push(lua_State *L, int elem, swig_type_info *, int, LuaCallCount *){
+		lua_pushinteger(L, elem);
+	}
+};
+
+// a read-only view of a list for Lua, it holds a shallow copy of the list, which costs
+// nothing as QList is implicitly shared, and its elements are pushed only when they are read
+struct LuaListView{
+	swig_type_info *type; // of the elements, NULL for the lists of integers
+
+	virtual ~LuaListView(){}
+	virtual int length() const = 0;
+
+	// i is 0-based, the cache is ignored when the type is NULL
+	virtual void push(lua_State *L, int i, int cache, LuaCallCount *count) const = 0;
+};
+
+template <typename T>
+struct LuaListViewOf: public LuaListView{
+	QList<T> list;
+
+	LuaListViewOf(const QList<T> &list, swig_type_info *type)
+		:list(list)
+	{
+		this->type = type;
+	}
+
+	virtual int length() const{
+		return list.length();
+	}
+
+	virtual void push(lua_State *L, int i, int cache, LuaCallCount *count) const{
+		ListElement<T>::Push(L, list.at(i), type, cache, count);
+	}
+};
+
+template <typename T>
+static LuaListView *NewListViewOf(lua_State *L, int idx, swig_type_info *list_type, swig_type_info *type){
+	QList<T> *list = NULL;
+	if(!SWIG_IsOK(SWIG_ConvertPtr(L, idx, (void **)&list, list_type, 0)) || list == NULL)
+		return NULL;
+
+	return new LuaListViewOf<T>(*list, type);
+}
+
+static LuaListView *NewListView(lua_State *L, int idx){
+	if(!lua_isuserdata(L, idx))
+		return NULL;
+
+	LuaListView *view = NULL;
+	if((view = NewListViewOf<ServerPlayer *>(L, idx, SWIGTYPE_p_QListT_ServerPlayer_p_t, SWIGTYPE_p_ServerPlayer)))
+		return view;
+	if((view = NewListViewOf<const Player *>(L, idx, SWIGTYPE_p_QListT_Player_const_p_t, SWIGTYPE_p_Player)))
+		return view;
+	if((view = NewListViewOf<const Card *>(L, idx, SWIGTYPE_p_QListT_Card_const_p_t, SWIGTYPE_p_Card)))
+		return view;
+	if((view = NewListViewOf<int>(L, idx, SWIGTYPE_p_QListT_int_t, NULL)))
+		return view;
+	if((view = NewListViewOf<const Skill *>(L, idx, SWIGTYPE_p_QListT_Skill_const_p_t, SWIGTYPE_p_Skill)))
+		return view;
+
+	return NULL;
+}
+
+static LuaListView *TestListView(lua_State *L, int idx){
+	void *data = lua_touserdata(L, idx);
+	if(data == NULL || !lua_getmetatable(L, idx))
+		return NULL;
+
+	luaL_getmetatable(L, ListViewMetatable);
+	bool is_view = lua_rawequal(L, -1, -2);
+	lua_pop(L, 2);
+
+	return is_view ? *static_cast<LuaListView **>(data) : NULL;
+}
+
+static LuaListView *CheckListView(lua_State *L, int idx){
+	LuaListView *view = TestListView(L, idx);
+	if(view == NULL)
+		luaL_typerror(L, idx, ListViewMetatable);
+
+	return view;
+}
+
+// pushes the element i (0-based) of the view, or nil when it is out of range
+static void PushListElement(lua_State *L, LuaListView *view, int i){
+	if(i < 0 || i >= view->length()){
+		lua_pushnil(L);
+		return;
+	}
+
+	if(view->type == NULL){
+		view->push(L, i, 0, NULL);
+		return;
+	}
+
+	PushPointerCache(L, view->type);
+	view->push(L, i, lua_gettop(L), GetLuaCallCount(L));
+	lua_remove(L, -2);
+}
+
+static int ListViewLength(lua_State *L){
+	lua_pushinteger(L, CheckListView(L, 1)->length());
+	return 1;
+}
+
+static int ListViewAt(lua_State *L){
+	PushListElement(L, CheckListView(L, 1), luaL_checkint(L, 2));
+	return 1;
+}
+
+static int ListViewIsEmpty(lua_State *L){
+	lua_pushboolean(L, CheckListView(L, 1)->length() == 0);
+	return 1;
+}
+
+// view[i] is 1-based like a table, the methods of the lists are kept as well
+static int ListViewIndex(lua_State *L){
+	LuaListView *view = CheckListView(L, 1);
+
+	if(lua_type(L, 2) == LUA_TNUMBER){
+		PushListElement(L, view, lua_tointeger(L, 2) - 1);
+		return 1;
+	}
+
+	const char *key = lua_tostring(L, 2);
+	if(key && strcmp(key, "length") == 0)
+		lua_pushcfunction(L, ListViewLength);
+	else if(key && strcmp(key, "at") == 0)
+		lua_pushcfunction(L, ListViewAt);
+	else if(key && strcmp(key, "isEmpty") == 0)
+		lua_pushcfunction(L, ListViewIsEmpty);
+	else
+		lua_pushnil(L);
+
+	return 1;
+}
+
+static int ListViewGC(lua_State *L){
+	LuaListView **data = static_cast<LuaListView **>(lua_touserdata(L, 1));
+	delete *data;
+	*data = NULL;
+
+	return 0;
+}
+
+static void PushListView(lua_State *L, LuaListView *view){
+	LuaListView **data = static_cast<LuaListView **>(lua_newuserdata(L, sizeof(LuaListView *)));
+	*data = view;
+
+	if(luaL_newmetatable(L, ListViewMetatable)){
+		lua_pushcfunction(L, ListViewIndex);
+		lua_setfield(L, -2, "__index");
+		lua_pushcfunction(L, ListViewLength);
+		lua_setfield(L, -2, "__len");
+		lua_pushcfunction(L, ListViewGC);
+		lua_setfield(L, -2, "__gc");
+	}
+
+	lua_setmetatable(L, -2);
+}
+
+// sgs.ListView(list) returns a view of the list, the view itself, or nil for the other values
+static int ListView(lua_State *L){
+	if(TestListView(L, 1)){
+		lua_settop(L, 1);
+		return 1;
+	}
+
+	LuaListView *view = NewListView(L, 1);
+	if(view)
+		PushListView(L, view);
+	else
+		lua_pushnil(L);
+
+	return 1;
+}
+
+// the iterator function of ipairs for the views, ListNext(view, i) returns i+1 and view[i+1]
+static int ListNext(lua_State *L){
+	LuaListView *view = CheckListView(L, 1);
+	int i = luaL_checkint(L, 2);
+	if(i < 0 || i >= view->length())
+		return 0;
+
+	lua_pushinteger(L, i + 1);
+	PushListElement(L, view, i);
+	return 2;
+}
+
+// copies a list or a view into a new table in one pass, sharing the userdata of the elements
+static int QList2Table(lua_State *L){
+	LuaListView *view = TestListView(L, 1);
+	LuaListView *owned = NULL;
+	if(view == NULL){
+		view = owned = NewListView(L, 1);
+		if(view == NULL)
+			return luaL_typerror(L, 1, "QList");
+	}
+
+	int cache = 0;
+	LuaCallCount *count = NULL;
+	if(view->type){
+		PushPointerCache(L, view->type);
+		cache = lua_gettop(L);
+		count = GetLuaCallCount(L);
+	}
+
+	int length = view->length();
+	lua_createtable(L, length, 0);
+
+	int i;
+	for(i=0; i<length; i++){
+		view->push(L, i, cache, count);
+		lua_rawseti(L, -2, i+1);
+	}
+
+	if(cache)
+		lua_remove(L, cache);
+
+	delete owned;
+
+	return 1;
+}
+
+%}
@@ -128,9 +128,42 @@ public:
 %{
 
 #include "lua-wrapper.h"
+#include "luaprofiler.h"
 #include "clientplayer.h"
 #include "carditem.h"
 
+static char LuaCallCountKey;
+
+LuaCallCount *GetLuaCallCount(lua_State *L){
+	lua_pushlightuserdata(L, &LuaCallCountKey);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	LuaCallCount *count = static_cast<LuaCallCount *>(lua_touserdata(L, -1));
+	lua_pop(L, 1);
+
+	if(count == NULL){
+		lua_pushlightuserdata(L, &LuaCallCountKey);
+		count = static_cast<LuaCallCount *>(lua_newuserdata(L, sizeof(LuaCallCount)));
+		count->calls = count->userdata = count->cache_hits = 0;
+		lua_rawset(L, LUA_REGISTRYINDEX);
+	}
+
+	return count;
+}
+
+int LuaCall(lua_State *L, int nargs, int nresults){
+	GetLuaCallCount(L)->calls ++;
+
+	LuaProfiler *profiler = LuaProfiler::Get(L);
+	if(profiler == NULL)
+		return lua_pcall(L, nargs, nresults, 0);
+
+	profiler->enter();
+	int error = lua_pcall(L, nargs, nresults, 0);
+	profiler->leave(error != 0);
+
+	return error;
+}
+
 bool LuaTriggerSkill::triggerable(const ServerPlayer *target) const{
 	if(can_trigger == 0)
 		return TriggerSkill::triggerable(target);
@@ -140,10 +173,10 @@ bool LuaTriggerSkill::triggerable(const ServerPlayer *target) const{
 	
 	// the callback function
 	lua_rawgeti(L, LUA_REGISTRYINDEX, can_trigger);	
-	SWIG_NewPointerObj(L, this, SWIGTYPE_p_LuaTriggerSkill, 0);	
-	SWIG_NewPointerObj(L, target, SWIGTYPE_p_ServerPlayer, 0);
+	PushCachedPointer(L, this, SWIGTYPE_p_LuaTriggerSkill);
+	PushCachedPointer(L, target, SWIGTYPE_p_ServerPlayer);
 
-	int error = lua_pcall(L, 2, 1, 0);
+	int error = LuaCall(L, 2, 1);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -168,19 +201,18 @@ bool LuaTriggerSkill::trigger(TriggerEvent event, ServerPlayer *player, QVariant
 	// the callback
 	lua_rawgeti(L, LUA_REGISTRYINDEX, on_trigger);	
 	
-	LuaTriggerSkill *self = const_cast<LuaTriggerSkill *>(this);
-	SWIG_NewPointerObj(L, self, SWIGTYPE_p_LuaTriggerSkill, 0);
+	PushCachedPointer(L, this, SWIGTYPE_p_LuaTriggerSkill);
 
 	// the first argument: event
 	lua_pushinteger(L, e);	
 	
 	// the second argument: player
-	SWIG_NewPointerObj(L, player, SWIGTYPE_p_ServerPlayer, 0);
+	PushCachedPointer(L, player, SWIGTYPE_p_ServerPlayer);
 
-	// the last event: data
+	// the last event: data, it lives only as long as the event, so it is never cached
 	SWIG_NewPointerObj(L, &data, SWIGTYPE_p_QVariant, 0);
 	
-	int error = lua_pcall(L, 4, 1, 0);
+	int error = LuaCall(L, 4, 1);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -209,12 +241,12 @@ bool LuaProhibitSkill::isProhibited(const Player *from, const Player *to, const
 
 	lua_rawgeti(L, LUA_REGISTRYINDEX, is_prohibited);
 
-	SWIG_NewPointerObj(L, this, SWIGTYPE_p_LuaProhibitSkill, 0);
-	SWIG_NewPointerObj(L, from, SWIGTYPE_p_Player, 0);
-	SWIG_NewPointerObj(L, to, SWIGTYPE_p_Player, 0);
+	PushCachedPointer(L, this, SWIGTYPE_p_LuaProhibitSkill);
+	PushCachedPointer(L, from, SWIGTYPE_p_Player);
+	PushCachedPointer(L, to, SWIGTYPE_p_Player);
 	SWIG_NewPointerObj(L, card, SWIGTYPE_p_Card, 0);
 
-	int error = lua_pcall(L, 4, 1, 0);
+	int error = LuaCall(L, 4, 1);
 	if(error){
 		Error(L);
 		return false;
@@ -233,11 +265,11 @@ int LuaDistanceSkill::getCorrect(const Player *from, const Player *to) const{
 
 	lua_rawgeti(L, LUA_REGISTRYINDEX, correct_func);
 
-	SWIG_NewPointerObj(L, this, SWIGTYPE_p_LuaDistanceSkill, 0);
-	SWIG_NewPointerObj(L, from, SWIGTYPE_p_Player, 0);
-	SWIG_NewPointerObj(L, to, SWIGTYPE_p_Player, 0);
+	PushCachedPointer(L, this, SWIGTYPE_p_LuaDistanceSkill);
+	PushCachedPointer(L, from, SWIGTYPE_p_Player);
+	PushCachedPointer(L, to, SWIGTYPE_p_Player);
 
-	int error = lua_pcall(L, 3, 1, 0);
+	int error = LuaCall(L, 3, 1);
 	if(error){
 		Error(L);
 		return 0;
@@ -260,7 +292,7 @@ bool LuaFilterSkill::viewFilter(const CardItem *to_select) const{
 	SWIG_NewPointerObj(L, this, SWIGTYPE_p_LuaFilterSkill, 0);
 	SWIG_NewPointerObj(L, to_select->getCard(), SWIGTYPE_p_Card, 0);
 
-	int error = lua_pcall(L, 2, 1, 0);
+	int error = LuaCall(L, 2, 1);
 	if(error){
 		Error(L);
 		return false;
@@ -282,7 +314,7 @@ const Card *LuaFilterSkill::viewAs(CardItem *card_item) const{
 	SWIG_NewPointerObj(L, this, SWIGTYPE_p_LuaFilterSkill, 0);
 	SWIG_NewPointerObj(L, card_item->getCard(), SWIGTYPE_p_Card, 0);
 
-	int error = lua_pcall(L, 2, 1, 0);
+	int error = LuaCall(L, 2, 1);
 	if(error){
 		Error(L);
 		return NULL;
@@ -327,7 +359,7 @@ bool LuaViewAsSkill::viewFilter(const QList<CardItem *> &selected, const CardIte
 	const Card *card = to_select->getFilteredCard();
 	SWIG_NewPointerObj(L, card, SWIGTYPE_p_Card, 0);
 
-	int error = lua_pcall(L, 3, 1, 0);
+	int error = LuaCall(L, 3, 1);
 	if(error){
 		Error(L);
 		return false;
@@ -356,7 +388,7 @@ const Card *LuaViewAsSkill::viewAs(const QList<CardItem *> &cards) const{
 		lua_rawseti(L, -2, i+1);
 	}
 
-	int error = lua_pcall(L, 2, 1, 0);
+	int error = LuaCall(L, 2, 1);
 	if(error){
 		Error(L);
 		return NULL;
@@ -385,7 +417,7 @@ bool LuaViewAsSkill::isEnabledAtPlay(const Player *player) const{
 
 	SWIG_NewPointerObj(L, player, SWIGTYPE_p_Player, 0);
 
-	int error = lua_pcall(L, 2, 1, 0);
+	int error = LuaCall(L, 2, 1);
 	if(error){
 		Error(L);
 		return false;
@@ -411,7 +443,7 @@ bool LuaViewAsSkill::isEnabledAtResponse(const Player *player, const QString &pa
 	
 	lua_pushstring(L, pattern.toAscii());
 
-	int error = lua_pcall(L, 3, 1, 0);
+	int error = LuaCall(L, 3, 1);
 	if(error){
 		Error(L);
 		return false;
@@ -450,7 +482,7 @@ bool LuaSkillCard::targetFilter(const QList<const Player *> &targets, const Play
 	SWIG_NewPointerObj(L, to_select, SWIGTYPE_p_Player, 0);
 	SWIG_NewPointerObj(L, self, SWIGTYPE_p_Player, 0);
 
-	int error = lua_pcall(L, 4, 1, 0);
+	int error = LuaCall(L, 4, 1);
 	if(error){
 		Error(L);
 		return false;
@@ -481,7 +513,7 @@ bool LuaSkillCard::targetsFeasible(const QList<const Player *> &targets, const P
 
 	SWIG_NewPointerObj(L, self, SWIGTYPE_p_Player, 0);
 
-	int error = lua_pcall(L, 2, 1, 0);
+	int error = LuaCall(L, 2, 1);
 	if(error){
 		Error(L);
 		return false;
@@ -514,7 +546,7 @@ void LuaSkillCard::use(Room *room, ServerPlayer *source, const QList<ServerPlaye
 		lua_rawseti(L, -2, i+1);
 	}
 
-	int error = lua_pcall(L, 4, 0, 0);
+	int error = LuaCall(L, 4, 0);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
@@ -535,7 +567,7 @@ void LuaSkillCard::onEffect(const CardEffectStruct &effect) const{
 
 	SWIG_NewPointerObj(L, &effect, SWIGTYPE_p_CardEffectStruct, 0);
 
-	int error = lua_pcall(L, 2, 0, 0);
+	int error = LuaCall(L, 2, 0);
 	if(error){
 		const char *error_msg = lua_tostring(L, -1);
 		lua_pop(L, 1);
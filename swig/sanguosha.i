@@ -4,6 +4,8 @@
 #include "structs.h"
 #include "engine.h"
 #include "client.h"
+#include "roomstate.h"
+#include "distancematrix.h"
 
 #include <QDir>
 
@@ -65,6 +67,17 @@ public:
 	void lastWord() const;
 };
 
+class Player;
+
+class DistanceMatrix{
+public:
+	int distance(const Player *from, const Player *to);
+	void invalidate();
+
+	int getHitCount() const;
+	int getMissCount() const;
+};
+
 class Player: public QObject
 {
 public:
@@ -134,6 +147,8 @@ public:
 	virtual int aliveCount() const = 0;
 	int distanceTo(const Player *other) const;
 	void setFixedDistance(const Player *player, int distance);
+	DistanceMatrix *getDistanceMatrix() const;
+	void invalidateDistances() const;
 	const General *getAvatarGeneral() const;
 	const General *getGeneral() const;
 
@@ -706,6 +721,7 @@ public:
 	virtual int getPriority() const;
 	virtual bool triggerable(const ServerPlayer *target) const;    
 	virtual bool trigger(TriggerEvent event, ServerPlayer *player, QVariant &data) const = 0;
+	virtual bool isGlobal() const;
 };
 
 class QThread: public QObject{
@@ -731,6 +747,7 @@ public:
 	bool trigger(TriggerEvent event, ServerPlayer *target);
 
 	void addPlayerSkills(ServerPlayer *player, bool invoke_game_start = false);
+	void updatePlayerSkills(ServerPlayer *player);
 
 	void addTriggerSkill(const TriggerSkill *skill);
 	void delay(unsigned long msecs = 1000);
@@ -810,6 +827,7 @@ public:
 	void swapSeat(ServerPlayer *a, ServerPlayer *b);
 	lua_State *getLuaState() const;
 	void setFixedDistance(Player *from, const Player *to, int distance);
+	DistanceMatrix *getDistanceMatrix();
 	void reverseFor3v3(const Card *card, ServerPlayer *player, QList<ServerPlayer *> &list);
 	bool hasWelfare(const ServerPlayer *player) const;
 	ServerPlayer *getFront(ServerPlayer *a, ServerPlayer *b) const;
@@ -823,6 +841,7 @@ public:
 	void setVirtual();
 	void copyFrom(Room* rRoom);
 	Room* duplicate();
+	RoomState snapshot() const;
 
 	const ProhibitSkill *isProhibited(const Player *from, const Player *to, const Card *card) const;
 
@@ -867,6 +886,75 @@ public:
 	const Card *askForSinglePeach(ServerPlayer *player, ServerPlayer *dying);
 };
 
+class PlayerState{
+public:
+	QString objectName() const;
+	QString getGeneralName() const;
+	QString getGeneral2Name() const;
+	QString getKingdom() const;
+	QString getRole() const;
+	int getSeat() const;
+
+	int getHp() const;
+	void setHp(int hp);
+	int getMaxHP() const;
+	void setMaxHP(int max_hp);
+	int getLostHp() const;
+	bool isWounded() const;
+
+	bool isAlive() const;
+	void setAlive(bool alive);
+	Player::Phase getPhase() const;
+	void setPhase(Player::Phase phase);
+	bool faceUp() const;
+	void setFaceUp(bool face_up);
+	bool isChained() const;
+	void setChained(bool chained);
+
+	QList<int> handCards() const;
+	int getHandcardNum() const;
+	QList<int> getEquips() const;
+	QList<int> getJudgingArea() const;
+	QList<int> getPile(const char *pile_name) const;
+
+	int getMark(const char *mark) const;
+	void setMark(const char *mark, int value);
+	bool hasFlag(const char *flag) const;
+	void setFlags(const char *flag);
+	bool hasSkill(const char *skill_name) const;
+	int usedTimes(const char *card_class) const;
+
+	QVariant getTag(const char *key) const;
+	void setTag(const char *key, const QVariant &value);
+};
+
+class RoomState{
+public:
+	RoomState();
+	RoomState(const RoomState &other);
+
+	int playerCount() const;
+	int alivePlayerCount() const;
+	int indexOf(const char *object_name) const;
+	PlayerState *getPlayer(int index);
+
+	int getCurrent() const;
+	void setCurrent(int index);
+
+	Player::Place getCardPlace(int card_id) const;
+	int getCardOwner(int card_id) const;
+	void moveCard(int card_id, int to, Player::Place place);
+	void addToPile(int card_id, int to, const char *pile_name);
+	QList<int> drawCards(int index, int n);
+
+	QList<int> getDrawPile() const;
+	QList<int> getDiscardPile() const;
+	int getDrawPileNum() const;
+
+	QVariant getTag(const char *key) const;
+	void setTag(const char *key, const QVariant &value);
+};
+
 %extend Room {
 	ServerPlayer *nextPlayer() const{
 		return $self->getCurrent()->getNextAlive();